@@ -23,6 +23,7 @@
 
 #include "color.h"
 #include <math.h>
+#include <string.h>
 #include <lib8tion.h>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -592,6 +593,20 @@ void rgb_fill_solid_rgb(rgb_t *target, rgb_t color, size_t num)
         target[i] = color;
 }
 
+void rgb_nscale8(rgb_t *leds, size_t num, uint8_t scale)
+{
+    // channels are independent, scale them as one flat byte array
+    uint8_t *p = (uint8_t *)leds;
+    size_t n = num * sizeof(rgb_t);
+    for (size_t i = 0; i < n; ++i)
+        p[i] = scale8(p[i], scale);
+}
+
+void rgb_fade_to_black_by(rgb_t *leds, size_t num, uint8_t fade_by)
+{
+    rgb_nscale8(leds, num, 255 - fade_by);
+}
+
 void hsv_fill_gradient_hsv(hsv_t *target, size_t startpos, hsv_t startcolor, size_t endpos, hsv_t endcolor,
         color_gradient_direction_t direction)
 {
@@ -810,6 +825,112 @@ void rgb_fill_gradient_rgb(rgb_t *leds, size_t startpos, rgb_t startcolor, size_
 
 ////////////////////////////////////////////////////////////////////////////////
 
+_Static_assert(sizeof(rgbx_t) == 4, "rgbx_t must be 32 bits");
+
+// SWAR helpers: the even and the odd bytes of a word are processed as two
+// pairs of 16-bit lanes. Per lane the result never exceeds 0xffff, so there
+// is no carry between lanes.
+static inline uint32_t swar_scale8(uint32_t a, uint8_t scale)
+{
+    uint32_t w = (uint32_t)scale + 1;
+    uint32_t lo = (((a & 0x00ff00ff) * w) >> 8) & 0x00ff00ff;
+    uint32_t hi = (((a >> 8) & 0x00ff00ff) * w) & 0xff00ff00;
+    return lo | hi;
+}
+
+static inline uint32_t swar_blend8(uint32_t a, uint32_t b, fract8 amount)
+{
+    // same as blend8(): (a * (256 - amount) + b * (amount + 1)) >> 8
+    uint32_t wa = 256 - (uint32_t)amount;
+    uint32_t wb = (uint32_t)amount + 1;
+    uint32_t lo = (((a & 0x00ff00ff) * wa + (b & 0x00ff00ff) * wb) >> 8) & 0x00ff00ff;
+    uint32_t hi = (((a >> 8) & 0x00ff00ff) * wa + ((b >> 8) & 0x00ff00ff) * wb) & 0xff00ff00;
+    return lo | hi;
+}
+
+void rgbx_fill_solid_rgb(rgbx_t *target, rgb_t color, size_t num)
+{
+    uint32_t raw = rgbx_from_rgb(color).raw;
+    for (size_t i = 0; i < num; ++i)
+        target[i].raw = raw;
+}
+
+void rgbx_fill_gradient_rgb(rgbx_t *leds, size_t startpos, rgb_t startcolor, size_t endpos, rgb_t endcolor)
+{
+    // if the points are in the wrong order, straighten them
+    if (endpos < startpos)
+    {
+        size_t t = endpos;
+        rgb_t tc = endcolor;
+        endcolor = startcolor;
+        endpos = startpos;
+        startpos = t;
+        startcolor = tc;
+    }
+
+    saccum87 rdistance87 = (endcolor.r - startcolor.r) << 7;
+    saccum87 gdistance87 = (endcolor.g - startcolor.g) << 7;
+    saccum87 bdistance87 = (endcolor.b - startcolor.b) << 7;
+
+    size_t pixeldistance = endpos - startpos;
+    int16_t divisor = pixeldistance ? pixeldistance : 1;
+
+    saccum87 rdelta87 = (rdistance87 / divisor) * 2;
+    saccum87 gdelta87 = (gdistance87 / divisor) * 2;
+    saccum87 bdelta87 = (bdistance87 / divisor) * 2;
+
+    accum88 r88 = startcolor.r << 8;
+    accum88 g88 = startcolor.g << 8;
+    accum88 b88 = startcolor.b << 8;
+    for (size_t i = startpos; i <= endpos; ++i)
+    {
+        leds[i].raw = 0;
+        leds[i].r = r88 >> 8;
+        leds[i].g = g88 >> 8;
+        leds[i].b = b88 >> 8;
+        r88 += rdelta87;
+        g88 += gdelta87;
+        b88 += bdelta87;
+    }
+}
+
+void rgbx_nblend(rgbx_t *existing, const rgbx_t *overlay, size_t num, fract8 amount)
+{
+    for (size_t i = 0; i < num; ++i)
+        existing[i].raw = swar_blend8(existing[i].raw, overlay[i].raw, amount);
+}
+
+void rgbx_nblend_rgb(rgbx_t *existing, rgb_t overlay, size_t num, fract8 amount)
+{
+    uint32_t raw = rgbx_from_rgb(overlay).raw;
+    for (size_t i = 0; i < num; ++i)
+        existing[i].raw = swar_blend8(existing[i].raw, raw, amount);
+}
+
+void rgbx_nscale8(rgbx_t *leds, size_t num, uint8_t scale)
+{
+    for (size_t i = 0; i < num; ++i)
+        leds[i].raw = swar_scale8(leds[i].raw, scale);
+}
+
+void rgbx_fade_to_black_by(rgbx_t *leds, size_t num, uint8_t fade_by)
+{
+    rgbx_nscale8(leds, num, 255 - fade_by);
+}
+
+void rgbx_fill_palette_rgb(rgbx_t *target, size_t num, rgb_t *palette, uint8_t pal_size,
+        uint8_t start_index, uint8_t index_step, uint8_t brightness, bool blend)
+{
+    uint8_t index = start_index;
+    for (size_t i = 0; i < num; ++i)
+    {
+        target[i] = rgbx_from_rgb(color_from_palette_rgb(palette, pal_size, index, brightness, blend));
+        index += index_step;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 hsv_t color_from_palette_hsv(hsv_t *palette, uint8_t pal_size, uint8_t index, uint8_t brightness, bool blend)
 {
     uint8_t div = 256 / pal_size;
@@ -947,6 +1068,96 @@ rgb_t color_from_palette_rgb(rgb_t *palette, uint8_t pal_size, uint8_t index, ui
     return rgb_from_values(red1, green1, blue1);
 }
 
+void rgb_palette256_from_rgb(rgb_palette256_t *target, const rgb_t *palette, uint8_t pal_size, bool blend)
+{
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        unsigned pos = i * pal_size;
+        uint8_t hi = pos >> 8;
+        uint8_t f2 = pos & 0xff;
+
+        rgb_t c1 = palette[hi];
+        if (blend && f2)
+        {
+            rgb_t c2 = palette[hi == pal_size - 1 ? 0 : hi + 1];
+            uint8_t f1 = 255 - f2;
+            c1.r = scale8(c1.r, f1) + scale8(c2.r, f2);
+            c1.g = scale8(c1.g, f1) + scale8(c2.g, f2);
+            c1.b = scale8(c1.b, f1) + scale8(c2.b, f2);
+        }
+        target->entries[i] = c1;
+    }
+}
+
+void rgb_palette256_from_hsv(rgb_palette256_t *target, const hsv_t *palette, uint8_t pal_size, bool interpolate)
+{
+    for (unsigned i = 0; i < 256; ++i)
+    {
+        unsigned pos = i * pal_size;
+        uint8_t hi = pos >> 8;
+        uint8_t f2 = pos & 0xff;
+
+        hsv_t c1 = palette[hi];
+        if (interpolate && f2)
+        {
+            hsv_t c2 = palette[hi == pal_size - 1 ? 0 : hi + 1];
+            // Black and white have no hue of their own: adopt the other
+            // one, so that only brightness or saturation ramps
+            if (c1.sat == 0 || c1.val == 0)
+                c1.hue = c2.hue;
+            if (c2.sat == 0 || c2.val == 0)
+                c2.hue = c1.hue;
+            c1 = blend(c1, c2, f2, COLOR_SHORTEST_HUES);
+        }
+        target->entries[i] = hsv2rgb_rainbow(c1);
+    }
+}
+
+// Same as brightness handling in color_from_palette_rgb()
+static inline uint8_t palette_dim(uint8_t c, uint8_t brightness)
+{
+    return c ? scale8(c, brightness) : 0;
+}
+
+void rgb_fill_palette256(rgb_t *target, size_t num, const rgb_palette256_t *palette,
+        accum88 start_index, accum88 index_step, uint8_t brightness)
+{
+    accum88 index = start_index;
+    if (brightness == 255)
+    {
+        for (size_t i = 0; i < num; ++i, index += index_step)
+            target[i] = palette->entries[index >> 8];
+        return;
+    }
+    // brightness 0 gives black, otherwise adjust for rounding
+    uint8_t scale = brightness ? brightness + 1 : 0;
+    for (size_t i = 0; i < num; ++i, index += index_step)
+    {
+        rgb_t c = palette->entries[index >> 8];
+        target[i].r = palette_dim(c.r, scale);
+        target[i].g = palette_dim(c.g, scale);
+        target[i].b = palette_dim(c.b, scale);
+    }
+}
+
+void rgbx_fill_palette256(rgbx_t *target, size_t num, const rgb_palette256_t *palette,
+        accum88 start_index, accum88 index_step, uint8_t brightness)
+{
+    accum88 index = start_index;
+    uint8_t scale = brightness ? brightness + 1 : 0;
+    for (size_t i = 0; i < num; ++i, index += index_step)
+    {
+        rgb_t c = palette->entries[index >> 8];
+        if (brightness != 255)
+        {
+            c.r = palette_dim(c.r, scale);
+            c.g = palette_dim(c.g, scale);
+            c.b = palette_dim(c.b, scale);
+        }
+        target[i] = rgbx_from_rgb(c);
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 hsv_t blend(hsv_t existing, hsv_t overlay, fract8 amount, color_gradient_direction_t direction)
@@ -993,29 +1204,89 @@ hsv_t blend(hsv_t existing, hsv_t overlay, fract8 amount, color_gradient_directi
     return existing;
 }
 
-void blur1d(rgb_t *leds, size_t num_leds, fract8 blur_amount)
+// Blur kernels work on the raw channel bytes of rgb_t arrays, so that the
+// inner loops have no per-pixel struct shuffling and no loop-carried
+// dependency and can be vectorized by the compiler.
+
+_Static_assert(sizeof(rgb_t) == 3, "rgb_t must be tightly packed");
+
+#define BLUR_CHUNK 96 // bytes, multiple of 3
+
+// Blur one contiguous line of pixels; neighbours are 3 bytes apart.
+// Each output byte depends only on the original values of itself and its two
+// neighbours, so their seeped shares are staged chunk-wise in a small window.
+static void blur_span(uint8_t *p, size_t nbytes, uint8_t keep, uint8_t seep)
 {
-    uint8_t keep = 255 - blur_amount;
-    uint8_t seep = blur_amount >> 1;
-    rgb_t carryover = rgb_from_code(0);
-    for (size_t i = 0; i < num_leds; ++i)
+    // part[] holds the seeped share of the original values, shifted by one
+    // pixel: part[j] belongs to the pixel left of out[j], part[j + 6] to the
+    // pixel right of it
+    uint8_t part[BLUR_CHUNK + 6];
+    memset(part, 0, 3); // no left neighbour for the first pixel
+    for (size_t x0 = 0; x0 < nbytes; x0 += BLUR_CHUNK)
     {
-        rgb_t cur = leds[i];
-        rgb_t part = cur;
-        part = rgb_scale(part, seep);
-        cur = rgb_add_rgb(rgb_scale(cur, keep), carryover);
-        if (i)
-            leds[i - 1] = rgb_add_rgb(leds[i - 1], part);
-        leds[i] = cur;
-        carryover = part;
+        size_t n = nbytes - x0 < BLUR_CHUNK ? nbytes - x0 : BLUR_CHUNK;
+        size_t ahead = x0 + n < nbytes ? 3 : 0;
+        uint8_t *out = p + x0;
+
+        for (size_t j = 0; j < n + ahead; ++j)
+            part[j + 3] = scale8(out[j], seep);
+        if (!ahead)
+            memset(part + 3 + n, 0, 3); // no right neighbour for the last pixel
+
+        for (size_t j = 0; j < n; ++j)
+            out[j] = qadd8(qadd8(scale8(out[j], keep), part[j]), part[j + 6]);
+
+        memcpy(part, part + n, 3);
     }
 }
 
+// Blur across 'lines' rows of 'line_bytes' bytes each, 'pitch' bytes apart;
+// i.e. each byte is blurred with the bytes directly above and below it.
+// Processed in column chunks so the carryover fits on the stack.
+static void blur_lines(uint8_t *p, size_t lines, size_t line_bytes, size_t pitch, uint8_t keep, uint8_t seep)
+{
+    uint8_t carry[BLUR_CHUNK];
+    for (size_t x0 = 0; x0 < line_bytes; x0 += BLUR_CHUNK)
+    {
+        size_t n = line_bytes - x0 < BLUR_CHUNK ? line_bytes - x0 : BLUR_CHUNK;
+        memset(carry, 0, n);
+        for (size_t l = 0; l < lines; ++l)
+        {
+            uint8_t *cur = p + l * pitch + x0;
+            for (size_t j = 0; j < n; ++j)
+            {
+                uint8_t part = scale8(cur[j], seep);
+                uint8_t c = qadd8(scale8(cur[j], keep), carry[j]);
+                if (l)
+                {
+                    // The line above only exists from the second line on
+                    uint8_t *prev = cur - pitch;
+                    prev[j] = qadd8(prev[j], part);
+                }
+                cur[j] = c;
+                carry[j] = part;
+            }
+        }
+    }
+}
+
+void blur1d(rgb_t *leds, size_t num_leds, fract8 blur_amount)
+{
+    blur_span((uint8_t *)leds, num_leds * sizeof(rgb_t), 255 - blur_amount, blur_amount >> 1);
+}
+
 void blur_columns(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_to_offs_cb xy, void *ctx)
 {
     // blur columns
     uint8_t keep = 255 - blur_amount;
     uint8_t seep = blur_amount >> 1;
+    if (!xy)
+    {
+        // row-major: blur all columns at once, row by row
+        size_t pitch = width * sizeof(rgb_t);
+        blur_lines((uint8_t *)leds, height, pitch, pitch, keep, seep);
+        return;
+    }
     for (size_t col = 0; col < width; ++col)
     {
         rgb_t carryover = rgb_from_code(0);
@@ -1042,6 +1313,13 @@ void blur_rows(rgb_t *leds, size_t width, size_t height, fract8 blur_amount, xy_
     // blur rows same as columns, for irregular matrix
     uint8_t keep = 255 - blur_amount;
     uint8_t seep = blur_amount >> 1;
+    if (!xy)
+    {
+        // row-major: every row is a contiguous span
+        for (size_t row = 0; row < height; row++)
+            blur_span((uint8_t *)(leds + row * width), width * sizeof(rgb_t), keep, seep);
+        return;
+    }
     for (size_t row = 0; row < height; row++)
     {
         rgb_t carryover = rgb_from_code(0);
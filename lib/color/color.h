@@ -36,6 +36,7 @@
 #define __COLOR_H__
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "rgb.h"
 #include "hsv.h"
@@ -264,6 +265,72 @@ static inline void rgb_fill_gradient4_rgb(rgb_t *target, size_t num, rgb_t c1, r
     rgb_fill_gradient_rgb(target, twothirds, c3, num - 1,   c4);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Fade functions
+
+/**
+ * @brief Scale down an array of RGB colors to N 256ths of their current
+ *        brightness, using 'plain math' dimming rules.
+ */
+void rgb_nscale8(rgb_t *leds, size_t num, uint8_t scale);
+
+/**
+ * @brief Reduce the brightness of an array of RGB colors by 'fade_by'
+ *        256ths, eventually fading to full black.
+ *
+ * Useful for trails: call it on the whole buffer every frame before
+ * drawing the moving elements.
+ */
+void rgb_fade_to_black_by(rgb_t *leds, size_t num, uint8_t fade_by);
+
+////////////////////////////////////////////////////////////////////////////////
+// RGBX framebuffer functions
+//
+// Same operations as above, for word-aligned ::rgbx_t arrays. Blending and
+// scaling process two channels per 32-bit multiply and give exactly the
+// same results as blend8() and scale8().
+
+/**
+ * Fill an array of RGBX colors with a solid RGB color
+ */
+void rgbx_fill_solid_rgb(rgbx_t *target, rgb_t color, size_t num);
+
+/**
+ * Same as ::rgb_fill_gradient_rgb(), but for array of RGBX
+ */
+void rgbx_fill_gradient_rgb(rgbx_t *leds, size_t startpos, rgb_t startcolor, size_t endpos, rgb_t endcolor);
+
+/**
+ * @brief Blend an array of RGBX colors toward a second one
+ *
+ * existing[i] = blend of existing[i] and overlay[i] by 'amount' 256ths
+ */
+void rgbx_nblend(rgbx_t *existing, const rgbx_t *overlay, size_t num, fract8 amount);
+
+/**
+ * @brief Blend an array of RGBX colors toward a solid RGB color
+ */
+void rgbx_nblend_rgb(rgbx_t *existing, rgb_t overlay, size_t num, fract8 amount);
+
+/**
+ * Same as ::rgb_nscale8(), but for array of RGBX
+ */
+void rgbx_nscale8(rgbx_t *leds, size_t num, uint8_t scale);
+
+/**
+ * Same as ::rgb_fade_to_black_by(), but for array of RGBX
+ */
+void rgbx_fade_to_black_by(rgbx_t *leds, size_t num, uint8_t fade_by);
+
+/**
+ * @brief Fill an array of RGBX colors from a RGB palette
+ *
+ * target[i] = palette color at index 'start_index + i * index_step',
+ * see ::color_from_palette_rgb().
+ */
+void rgbx_fill_palette_rgb(rgbx_t *target, size_t num, rgb_t *palette, uint8_t pal_size,
+        uint8_t start_index, uint8_t index_step, uint8_t brightness, bool blend);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Palette functions
 
@@ -281,12 +348,61 @@ hsv_t color_from_palette_hsv(hsv_t *palette, uint8_t pal_size, uint8_t index, ui
  */
 rgb_t color_from_palette_rgb(rgb_t *palette, uint8_t pal_size, uint8_t index, uint8_t brightness, bool blend);
 
+/**
+ * @brief Palette expanded to one RGB color per palette index
+ *
+ * Expanding a palette once with ::rgb_palette256_from_rgb() or
+ * ::rgb_palette256_from_hsv() turns every later lookup into a plain table
+ * read, which is what per-LED palette animations want.
+ */
+typedef struct
+{
+    rgb_t entries[256];
+} rgb_palette256_t;
+
+/**
+ * @brief Expand a RGB palette of 'pal_size' entries to 256 entries
+ *
+ * The entries are spread evenly across the 0..255 index range. For
+ * power-of-two sizes the result is identical to ::color_from_palette_rgb()
+ * with full brightness; other sizes are supported as well.
+ */
+void rgb_palette256_from_rgb(rgb_palette256_t *target, const rgb_t *palette, uint8_t pal_size, bool blend);
+
+/**
+ * @brief Expand a HSV palette of 'pal_size' entries to 256 RGB entries
+ *
+ * Interpolation is done in HSV space as in ::color_from_palette_hsv(),
+ * then every entry is converted with ::hsv2rgb_rainbow().
+ */
+void rgb_palette256_from_hsv(rgb_palette256_t *target, const hsv_t *palette, uint8_t pal_size, bool interpolate);
+
+/**
+ * @brief Fill an array of RGB colors from an expanded palette
+ *
+ * target[i] = palette entry at index '(start_index + i * index_step) >> 8'.
+ * Index and step are Q8.8 fixed-point values, so a strip of any length can
+ * span exactly one palette turn with 'index_step = 65536 / num'.
+ * Brightness is applied as in ::color_from_palette_rgb().
+ */
+void rgb_fill_palette256(rgb_t *target, size_t num, const rgb_palette256_t *palette,
+        accum88 start_index, accum88 index_step, uint8_t brightness);
+
+/**
+ * Same as ::rgb_fill_palette256(), but for array of RGBX
+ */
+void rgbx_fill_palette256(rgbx_t *target, size_t num, const rgb_palette256_t *palette,
+        accum88 start_index, accum88 index_step, uint8_t brightness);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Filter functions
 
 /**
  * Function which must be provided by the application for use in two-dimensional
  * filter functions.
+ *
+ * Pass NULL instead to use row-major layout (offset = y * width + x), which
+ * is considerably faster as no callback is made per pixel.
  */
 typedef size_t (*xy_to_offs_cb)(void *ctx, size_t x, size_t y);
 
@@ -1,2 +1,3 @@
 COMPONENT_ADD_INCLUDEDIRS = .
-COMPONENT_DEPENDS = lib8tion
\ No newline at end of file
+COMPONENT_DEPENDS = lib8tion
+CFLAGS += -ftree-vectorize
@@ -60,6 +60,23 @@ typedef struct
     };
 } rgb_t;
 
+/// RGB color padded to 32 bits (RGBX)
+///
+/// Use it for framebuffers: every pixel is word-aligned, so fill, blend and
+/// scale operations can process whole pixels with 32-bit loads and stores.
+/// The padding byte is ignored when writing to LEDs.
+typedef union
+{
+    struct
+    {
+        uint8_t r;
+        uint8_t g;
+        uint8_t b;
+        uint8_t x;
+    };
+    uint32_t raw;
+} rgbx_t;
+
 /// This allows testing a RGB for zero-ness
 static inline bool rgb_is_zero(rgb_t a)
 {
@@ -94,6 +111,29 @@ static inline uint32_t rgb_to_code(rgb_t color)
     return ((uint32_t)color.r << 16) | ((uint32_t)color.g << 8) | color.b;
 }
 
+/// Convert RGB color to padded RGBX color
+static inline rgbx_t rgbx_from_rgb(rgb_t color)
+{
+    rgbx_t res = {
+        .r = color.r,
+        .g = color.g,
+        .b = color.b,
+        .x = 0,
+    };
+    return res;
+}
+
+/// Convert padded RGBX color to RGB color
+static inline rgb_t rgb_from_rgbx(rgbx_t color)
+{
+    rgb_t res = {
+        .r = color.r,
+        .g = color.g,
+        .b = color.b,
+    };
+    return res;
+}
+
 /// Add a constant to each channel of RGB color,
 /// saturating at 0xFF
 static inline rgb_t rgb_add(rgb_t a, uint8_t val)
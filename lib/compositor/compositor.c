@@ -0,0 +1,231 @@
+/**
+ * @file compositor.c
+ *
+ * Layered compositor for one-dimensional LED scenes
+ */
+#include "compositor.h"
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+
+static const char *TAG = "compositor";
+
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+#define LAYER_OK(comp, layer) ((comp) && (layer) < (comp)->num_layers)
+
+esp_err_t compositor_init(compositor_t *comp, size_t length, size_t num_layers)
+{
+    CHECK_ARG(comp && length && num_layers);
+
+    comp->length = length;
+    comp->num_layers = num_layers;
+    comp->layers = calloc(num_layers, sizeof(compositor_layer_t));
+    if (!comp->layers)
+        goto nomem;
+
+    for (size_t i = 0; i < num_layers; i++)
+    {
+        compositor_layer_t *l = &comp->layers[i];
+        l->pixels = calloc(length, sizeof(rgb_t));
+        l->alpha = calloc(length, 1);
+        l->cache = calloc(length, sizeof(rgb_t));
+        if (!l->pixels || !l->alpha || !l->cache)
+            goto nomem;
+        l->blend = COMPOSITOR_BLEND_NORMAL;
+        l->opacity = 255;
+        l->visible = true;
+        l->dirty = true;
+    }
+    return ESP_OK;
+
+nomem:
+    ESP_LOGE(TAG, "Not enough memory");
+    compositor_free(comp);
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t compositor_free(compositor_t *comp)
+{
+    CHECK_ARG(comp);
+
+    if (comp->layers)
+    {
+        for (size_t i = 0; i < comp->num_layers; i++)
+        {
+            free(comp->layers[i].pixels);
+            free(comp->layers[i].alpha);
+            free(comp->layers[i].cache);
+        }
+        free(comp->layers);
+    }
+    comp->layers = NULL;
+    comp->num_layers = 0;
+
+    return ESP_OK;
+}
+
+esp_err_t compositor_set_blend(compositor_t *comp, size_t layer, compositor_blend_t blend)
+{
+    CHECK_ARG(LAYER_OK(comp, layer));
+
+    compositor_layer_t *l = &comp->layers[layer];
+    if (l->blend != blend)
+    {
+        l->blend = blend;
+        l->dirty = true;
+    }
+    return ESP_OK;
+}
+
+esp_err_t compositor_set_opacity(compositor_t *comp, size_t layer, fract8 opacity)
+{
+    CHECK_ARG(LAYER_OK(comp, layer));
+
+    compositor_layer_t *l = &comp->layers[layer];
+    if (l->opacity != opacity)
+    {
+        l->opacity = opacity;
+        l->dirty = true;
+    }
+    return ESP_OK;
+}
+
+esp_err_t compositor_set_visible(compositor_t *comp, size_t layer, bool visible)
+{
+    CHECK_ARG(LAYER_OK(comp, layer));
+
+    compositor_layer_t *l = &comp->layers[layer];
+    if (l->visible != visible)
+    {
+        l->visible = visible;
+        l->dirty = true;
+    }
+    return ESP_OK;
+}
+
+void compositor_clear(compositor_t *comp, size_t layer)
+{
+    if (!LAYER_OK(comp, layer))
+        return;
+
+    compositor_layer_t *l = &comp->layers[layer];
+    for (size_t i = 0; i < comp->length; i++)
+    {
+        if (l->alpha[i])
+        {
+            memset(l->alpha, 0, comp->length);
+            l->dirty = true;
+            return;
+        }
+    }
+}
+
+static inline void layer_put(compositor_layer_t *l, size_t pos, rgb_t color)
+{
+    rgb_t old = l->pixels[pos];
+    if (l->alpha[pos] == 255 && old.r == color.r && old.g == color.g && old.b == color.b)
+        return;
+    l->pixels[pos] = color;
+    l->alpha[pos] = 255;
+    l->dirty = true;
+}
+
+void compositor_set_pixel(compositor_t *comp, size_t layer, int pos, rgb_t color)
+{
+    if (!LAYER_OK(comp, layer) || pos < 0 || (size_t)pos >= comp->length)
+        return;
+
+    layer_put(&comp->layers[layer], pos, color);
+}
+
+void compositor_fill(compositor_t *comp, size_t layer, int start, size_t len, rgb_t color)
+{
+    if (!LAYER_OK(comp, layer))
+        return;
+
+    // clip to [0, length)
+    if (start < 0)
+    {
+        if ((size_t)-start >= len)
+            return;
+        len -= (size_t)-start;
+        start = 0;
+    }
+    if ((size_t)start >= comp->length)
+        return;
+    if (len > comp->length - start)
+        len = comp->length - start;
+
+    compositor_layer_t *l = &comp->layers[layer];
+    for (size_t i = start; i < start + len; i++)
+        layer_put(l, i, color);
+}
+
+void compositor_invalidate(compositor_t *comp)
+{
+    if (!comp || !comp->num_layers)
+        return;
+    // recompositing from the bottom layer covers everything above
+    comp->layers[0].dirty = true;
+}
+
+static void composite_layer(const compositor_t *comp, const rgb_t *below, compositor_layer_t *l)
+{
+    if (!l->visible || !l->opacity)
+    {
+        if (below)
+            memcpy(l->cache, below, comp->length * sizeof(rgb_t));
+        else
+            memset(l->cache, 0, comp->length * sizeof(rgb_t));
+        return;
+    }
+
+    for (size_t i = 0; i < comp->length; i++)
+    {
+        rgb_t base = below ? below[i] : rgb_from_code(0);
+        uint8_t a = l->opacity == 255 ? l->alpha[i] : scale8(l->alpha[i], l->opacity);
+        if (!a)
+        {
+            l->cache[i] = base;
+            continue;
+        }
+        switch (l->blend)
+        {
+            case COMPOSITOR_BLEND_ADD:
+                l->cache[i] = rgb_add_rgb(base, a == 255 ? l->pixels[i] : rgb_scale(l->pixels[i], a));
+                break;
+            default:
+                l->cache[i] = a == 255 ? l->pixels[i] : rgb_blend(base, l->pixels[i], a);
+                break;
+        }
+    }
+}
+
+const rgb_t *compositor_render(compositor_t *comp, bool *changed)
+{
+    if (changed)
+        *changed = false;
+    if (!comp || !comp->num_layers)
+        return NULL;
+
+    // find lowest dirty layer, everything below it is cached
+    size_t first = 0;
+    while (first < comp->num_layers && !comp->layers[first].dirty)
+        first++;
+
+    compositor_layer_t *top = &comp->layers[comp->num_layers - 1];
+    if (first == comp->num_layers)
+        return top->cache;
+
+    for (size_t i = first; i < comp->num_layers; i++)
+    {
+        const rgb_t *below = i ? comp->layers[i - 1].cache : NULL;
+        composite_layer(comp, below, &comp->layers[i]);
+        comp->layers[i].dirty = false;
+    }
+
+    if (changed)
+        *changed = true;
+    return top->cache;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file compositor.h
+ * @defgroup compositor compositor
+ * @{
+ *
+ * Layered compositor for one-dimensional LED scenes
+ *
+ * A scene is a stack of layers, bottom (index 0) to top. Every layer has its
+ * own pixels, a per-pixel alpha (0 = transparent), an opacity and a blend
+ * mode. Writes only mark a layer dirty when they actually change it, and the
+ * composite of every layer with everything below it is cached, so rendering
+ * recomposites only from the lowest changed layer upwards and does nothing at
+ * all when nothing changed.
+ */
+#ifndef __COMPOSITOR_H__
+#define __COMPOSITOR_H__
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include <color.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Layer blend mode
+ */
+typedef enum
+{
+    COMPOSITOR_BLEND_NORMAL = 0, ///< Layer is blended over the layers below by its alpha
+    COMPOSITOR_BLEND_ADD,        ///< Layer is added to the layers below, saturating
+} compositor_blend_t;
+
+/**
+ * Compositor layer
+ */
+typedef struct
+{
+    rgb_t *pixels;            ///< Layer colors
+    uint8_t *alpha;           ///< Per-pixel coverage, 0 = transparent, 255 = opaque
+    rgb_t *cache;             ///< Composite of this layer and all layers below
+    compositor_blend_t blend; ///< Blend mode
+    fract8 opacity;           ///< Opacity of the whole layer, 255 = as drawn
+    bool visible;             ///< Hidden layers are skipped
+    bool dirty;               ///< Changed since last ::compositor_render()
+} compositor_layer_t;
+
+/**
+ * Compositor descriptor
+ */
+typedef struct
+{
+    size_t length;               ///< Number of pixels
+    size_t num_layers;           ///< Number of layers
+    compositor_layer_t *layers;  ///< Layers, bottom to top
+} compositor_t;
+
+/**
+ * @brief Allocate compositor with transparent, visible, normal-blended layers
+ *
+ * @param comp Compositor descriptor
+ * @param length Number of pixels
+ * @param num_layers Number of layers
+ * @return `ESP_OK` on success
+ */
+esp_err_t compositor_init(compositor_t *comp, size_t length, size_t num_layers);
+
+/**
+ * @brief Deallocate compositor memory
+ *
+ * @param comp Compositor descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t compositor_free(compositor_t *comp);
+
+/**
+ * @brief Set layer blend mode
+ *
+ * @param comp Compositor descriptor
+ * @param layer Layer index
+ * @param blend Blend mode
+ * @return `ESP_OK` on success
+ */
+esp_err_t compositor_set_blend(compositor_t *comp, size_t layer, compositor_blend_t blend);
+
+/**
+ * @brief Set layer opacity
+ *
+ * @param comp Compositor descriptor
+ * @param layer Layer index
+ * @param opacity 0 = invisible .. 255 = as drawn
+ * @return `ESP_OK` on success
+ */
+esp_err_t compositor_set_opacity(compositor_t *comp, size_t layer, fract8 opacity);
+
+/**
+ * @brief Show or hide layer
+ *
+ * @param comp Compositor descriptor
+ * @param layer Layer index
+ * @param visible true to show layer
+ * @return `ESP_OK` on success
+ */
+esp_err_t compositor_set_visible(compositor_t *comp, size_t layer, bool visible);
+
+/**
+ * @brief Make layer fully transparent
+ *
+ * Out of range layer indices are ignored.
+ *
+ * @param comp Compositor descriptor
+ * @param layer Layer index
+ */
+void compositor_clear(compositor_t *comp, size_t layer);
+
+/**
+ * @brief Set opaque pixel of layer
+ *
+ * Out of range layer or pixel indices are ignored, so that callers can draw
+ * partially visible elements without bounds checks.
+ *
+ * @param comp Compositor descriptor
+ * @param layer Layer index
+ * @param pos Pixel index
+ * @param color Pixel color
+ */
+void compositor_set_pixel(compositor_t *comp, size_t layer, int pos, rgb_t color);
+
+/**
+ * @brief Set range of opaque pixels of layer to the one color
+ *
+ * The range is clipped to the compositor length.
+ *
+ * @param comp Compositor descriptor
+ * @param layer Layer index
+ * @param start First pixel index
+ * @param len Number of pixels
+ * @param color Pixels color
+ */
+void compositor_fill(compositor_t *comp, size_t layer, int start, size_t len, rgb_t color);
+
+/**
+ * @brief Mark all layers dirty
+ *
+ * Forces the next ::compositor_render() to report a change, e.g. after the
+ * output was overwritten by something else.
+ *
+ * @param comp Compositor descriptor
+ */
+void compositor_invalidate(compositor_t *comp);
+
+/**
+ * @brief Composite dirty layers
+ *
+ * @param comp Compositor descriptor
+ * @param[out] changed Set to true if any layer was recomposited since the
+ *                     previous call, may be NULL
+ * @return Composited pixels, valid until the next call
+ */
+const rgb_t *compositor_render(compositor_t *comp, bool *changed);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __COMPOSITOR_H__ */
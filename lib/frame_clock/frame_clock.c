@@ -0,0 +1,169 @@
+/**
+ * @file frame_clock.c
+ *
+ * Absolute-deadline frame clock with microsecond resolution
+ */
+#include "frame_clock.h"
+#include <string.h>
+#ifndef ESP_PLATFORM
+#include <errno.h>
+#include <time.h>
+#endif
+
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+#ifdef ESP_PLATFORM
+
+int64_t frame_clock_now_us()
+{
+    return esp_timer_get_time();
+}
+
+static void timer_callback(void *arg)
+{
+    frame_clock_t *fc = arg;
+    if (fc->cb)
+        fc->cb(fc->arg);
+}
+
+esp_err_t frame_clock_init(frame_clock_t *fc, frame_clock_cb_t cb, void *arg)
+{
+    CHECK_ARG(fc && cb);
+
+    memset(fc, 0, sizeof(frame_clock_t));
+    fc->cb = cb;
+    fc->arg = arg;
+
+    esp_timer_create_args_t args = {
+        .callback = timer_callback,
+        .arg = fc,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "frame_clock",
+    };
+    return esp_timer_create(&args, &fc->timer);
+}
+
+esp_err_t frame_clock_free(frame_clock_t *fc)
+{
+    CHECK_ARG(fc && fc->timer);
+
+    CHECK(frame_clock_disarm(fc));
+    CHECK(esp_timer_delete(fc->timer));
+    fc->timer = NULL;
+
+    return ESP_OK;
+}
+
+static esp_err_t timer_stop(frame_clock_t *fc)
+{
+    // Not running is fine: the deadline fired or was never armed
+    esp_err_t r = esp_timer_stop(fc->timer);
+    return r == ESP_ERR_INVALID_STATE ? ESP_OK : r;
+}
+
+static esp_err_t timer_start(frame_clock_t *fc, int64_t delay_us)
+{
+    return esp_timer_start_once(fc->timer, delay_us);
+}
+
+#else // Host: the deadline is waited for in frame_clock_wait()
+
+int64_t frame_clock_now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+esp_err_t frame_clock_init(frame_clock_t *fc, frame_clock_cb_t cb, void *arg)
+{
+    CHECK_ARG(fc);
+
+    memset(fc, 0, sizeof(frame_clock_t));
+    fc->cb = cb;
+    fc->arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t frame_clock_free(frame_clock_t *fc)
+{
+    CHECK_ARG(fc);
+
+    return frame_clock_disarm(fc);
+}
+
+static esp_err_t timer_stop(frame_clock_t *fc)
+{
+    return ESP_OK;
+}
+
+static esp_err_t timer_start(frame_clock_t *fc, int64_t delay_us)
+{
+    return ESP_OK;
+}
+
+bool frame_clock_wait(frame_clock_t *fc)
+{
+    if (!fc || !fc->armed)
+        return false;
+
+    struct timespec ts = {
+        .tv_sec = fc->deadline_us / 1000000,
+        .tv_nsec = (fc->deadline_us % 1000000) * 1000,
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+    if (fc->cb)
+        fc->cb(fc->arg);
+    return true;
+}
+
+#endif
+
+esp_err_t frame_clock_arm(frame_clock_t *fc, int64_t deadline_us)
+{
+    CHECK_ARG(fc);
+
+    CHECK(timer_stop(fc));
+    fc->deadline_us = deadline_us;
+    fc->armed = true;
+
+    int64_t delay_us = deadline_us - frame_clock_now_us();
+    if (delay_us > 0)
+        return timer_start(fc, delay_us);
+
+    // Handling the previous frame took longer than its period
+    fc->stats.overruns++;
+#ifdef ESP_PLATFORM
+    fc->cb(fc->arg);
+#endif
+    return ESP_OK;
+}
+
+esp_err_t frame_clock_disarm(frame_clock_t *fc)
+{
+    CHECK_ARG(fc);
+
+    fc->armed = false;
+    return timer_stop(fc);
+}
+
+bool frame_clock_tick(frame_clock_t *fc, int64_t now_us)
+{
+    if (!fc || !fc->armed || now_us < fc->deadline_us)
+        return false;
+
+    fc->armed = false;
+    int64_t late_us = now_us - fc->deadline_us;
+    fc->stats.frames++;
+    fc->stats.late_total_us += late_us;
+    if (late_us > fc->stats.late_max_us)
+        fc->stats.late_max_us = late_us;
+    return true;
+}
+
+void frame_clock_reset_stats(frame_clock_t *fc)
+{
+    if (fc)
+        memset(&fc->stats, 0, sizeof(frame_clock_stats_t));
+}
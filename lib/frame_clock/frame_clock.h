@@ -0,0 +1,141 @@
+/**
+ * @file frame_clock.h
+ * @defgroup frame_clock frame_clock
+ * @{
+ *
+ * Absolute-deadline frame clock with microsecond resolution
+ *
+ * The FreeRTOS tick (10 ms at 100 Hz) is too coarse to pace frames that are
+ * 15-30 ms apart: every wait is rounded up to whole ticks. The frame clock
+ * runs a one-shot `esp_timer` to an absolute deadline instead and calls a
+ * callback when it is reached, e.g. to wake a task blocked on a queue.
+ * Deadlines are absolute, so lateness of one frame never shifts the next.
+ *
+ * Every reached deadline is reported back with ::frame_clock_tick(), which
+ * records how late the frame was handled. A deadline that has already
+ * passed when it is armed counts as an overrun and fires at once.
+ *
+ * Without `ESP_PLATFORM` (host builds) there is no timer: the callback is
+ * called from ::frame_clock_wait(), which sleeps until the deadline.
+ */
+#ifndef __FRAME_CLOCK_H__
+#define __FRAME_CLOCK_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#ifdef ESP_PLATFORM
+#include <esp_timer.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Deadline callback. Runs in the esp_timer task, or in the caller of
+ * ::frame_clock_wait() on the host; keep it short.
+ */
+typedef void (*frame_clock_cb_t)(void *arg);
+
+/**
+ * Pacing statistics
+ */
+typedef struct
+{
+    uint32_t frames;       ///< Deadlines reported with ::frame_clock_tick()
+    uint32_t overruns;     ///< Deadlines that had already passed when armed
+    int64_t late_total_us; ///< Sum of lateness of all frames, for the mean
+    int64_t late_max_us;   ///< Largest lateness of a frame
+} frame_clock_stats_t;
+
+/**
+ * Frame clock descriptor
+ */
+typedef struct
+{
+#ifdef ESP_PLATFORM
+    esp_timer_handle_t timer;
+#endif
+    frame_clock_cb_t cb;       ///< Deadline callback
+    void *arg;                 ///< Callback argument
+    int64_t deadline_us;       ///< Armed deadline, ::frame_clock_now_us() time base
+    bool armed;                ///< Deadline armed and not reported yet
+    frame_clock_stats_t stats; ///< Statistics since init or ::frame_clock_reset_stats()
+} frame_clock_t;
+
+/**
+ * @brief Current time in microseconds (`esp_timer_get_time()` on the device,
+ *        monotonic clock on the host)
+ */
+int64_t frame_clock_now_us();
+
+/**
+ * @brief Initialize frame clock
+ *
+ * @param fc Frame clock descriptor
+ * @param cb Deadline callback, may be NULL on the host
+ * @param arg Callback argument
+ * @return `ESP_OK` on success
+ */
+esp_err_t frame_clock_init(frame_clock_t *fc, frame_clock_cb_t cb, void *arg);
+
+/**
+ * @brief Stop and delete the timer of the frame clock
+ */
+esp_err_t frame_clock_free(frame_clock_t *fc);
+
+/**
+ * @brief Arm frame clock for an absolute deadline
+ *
+ * Replaces a deadline armed before. If the deadline has already passed it
+ * counts as an overrun and the callback is called at once, from the caller
+ * (on the host from the next ::frame_clock_wait()).
+ *
+ * @param fc Frame clock descriptor
+ * @param deadline_us Deadline, ::frame_clock_now_us() time base
+ * @return `ESP_OK` on success
+ */
+esp_err_t frame_clock_arm(frame_clock_t *fc, int64_t deadline_us);
+
+/**
+ * @brief Cancel the armed deadline
+ */
+esp_err_t frame_clock_disarm(frame_clock_t *fc);
+
+/**
+ * @brief Report that the frame of the armed deadline is being handled
+ *
+ * Call it when the wake-up caused by the callback is processed. Reports of a
+ * deadline that was replaced or cancelled in the meantime are ignored.
+ *
+ * @param fc Frame clock descriptor
+ * @param now_us Current time
+ * @return true if the armed deadline was reached and is now recorded
+ */
+bool frame_clock_tick(frame_clock_t *fc, int64_t now_us);
+
+/**
+ * @brief Clear statistics
+ */
+void frame_clock_reset_stats(frame_clock_t *fc);
+
+#ifndef ESP_PLATFORM
+/**
+ * @brief Sleep until the armed deadline and call the callback
+ *
+ * Host builds only. Returns at once if nothing is armed.
+ *
+ * @param fc Frame clock descriptor
+ * @return true if a deadline was armed
+ */
+bool frame_clock_wait(frame_clock_t *fc);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __FRAME_CLOCK_H__ */
@@ -1,2 +1,2 @@
 COMPONENT_ADD_INCLUDEDIRS = .
-COMPONENT_DEPENDS = driver log color esp_idf_lib_helpers
+COMPONENT_DEPENDS = driver log color esp_idf_lib_helpers esp_timer
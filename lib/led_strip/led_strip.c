@@ -31,10 +31,14 @@
  * MIT Licensed as described in the file LICENSE
  */
 #include "led_strip.h"
+#include "led_strip_spi.h"
 #include <esp_log.h>
 #include <esp_attr.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 #include <esp_idf_lib_helpers.h>
+#include <esp_timer.h>
 #include "esp_log.h"
 
 #if HELPER_TARGET_IS_ESP8266
@@ -65,31 +69,51 @@ static const char *TAG = "led_strip";
 
 #define LED_STRIP_RMT_CLK_DIV 4
 
+#ifndef CONFIG_LED_STRIP_FLUSH_TIMEOUT
+#define CONFIG_LED_STRIP_FLUSH_TIMEOUT 1000
+#endif
+
+// Datasheet timings, may be overridden at build time (the host tests push
+// one outside its window)
+#ifndef WS2812_T1H_NS
 #define WS2812_T0H_NS   300
 #define WS2812_T0L_NS   900
 #define WS2812_T1H_NS   900
 #define WS2812_T1L_NS   300
+#endif
 
 //#define WS2812_T0H_NS   400
 //#define WS2812_T0L_NS   1000
 //#define WS2812_T1H_NS   1000
 //#define WS2812_T1L_NS   400
 
+#ifndef SK6812_T1H_NS
 #define SK6812_T0H_NS   300
 #define SK6812_T0L_NS   900
 #define SK6812_T1H_NS   600
 #define SK6812_T1L_NS   600
+#endif
 
+#ifndef APA106_T1H_NS
 #define APA106_T0H_NS   350
 #define APA106_T0L_NS   1360
 #define APA106_T1H_NS   1360
 #define APA106_T1L_NS   350
+#endif
 
 #define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
 #define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
 
 #define COLOR_SIZE(strip) (3 + ((strip)->is_rgbw != 0))
 
+#define WHITE_LUT_SIZE (6 * 256)
+
+// Per RMT channel: when the last frame started and finished sending.
+// The end time is set by the TX end interrupt, so the latch period can be
+// measured from there instead of always waited in full.
+static int64_t tx_start_us[RMT_CHANNEL_MAX] = { 0 };
+static volatile int64_t tx_end_us[RMT_CHANNEL_MAX] = { 0 };
+
 static rmt_item32_t ws2812_bit0 = { 0 };
 static rmt_item32_t ws2812_bit1 = { 0 };
 static rmt_item32_t ws2812_inv_bit0 = { 0 };
@@ -99,6 +123,40 @@ static rmt_item32_t sk6812_bit1 = { 0 };
 static rmt_item32_t apa106_bit0 = { 0 };
 static rmt_item32_t apa106_bit1 = { 0 };
 
+// Encodes bytes into RMT items, one item per bit, MSB first. With 'map' the
+// source is an `rgb_buf` of LEDs of 'size' bytes, 'psrc' is at channel 'ch'
+// of its LED and the bytes are read in wire order.
+static void IRAM_ATTR encode_bytes(const uint8_t *psrc, rmt_item32_t *pdest, size_t src_size,
+                                   size_t wanted_num, size_t *translated_size, size_t *item_num,
+                                   const rmt_item32_t *bit0, const rmt_item32_t *bit1, uint8_t brightness,
+                                   const uint8_t *map, size_t size, size_t ch)
+{
+    size_t size_done = 0;
+    size_t num = 0;
+    while (size_done < src_size && num < wanted_num)
+    {
+        uint8_t v = *psrc;
+        if (map)
+        {
+            v = psrc[(ptrdiff_t)map[ch] - (ptrdiff_t)ch];
+            if (++ch == size)
+                ch = 0;
+        }
+        uint8_t b = brightness != 255 ? scale8_video(v, brightness) : v;
+        for (int i = 0; i < 8; i++)
+        {
+            // MSB first
+            pdest->val = b & (1 << (7 - i)) ? bit1->val : bit0->val;
+            num++;
+            pdest++;
+        }
+        size_done++;
+        psrc++;
+    }
+    *translated_size = size_done;
+    *item_num = num;
+}
+
 static void IRAM_ATTR _rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
                                    size_t wanted_num, size_t *translated_size, size_t *item_num,
                                    const rmt_item32_t *bit0, const rmt_item32_t *bit1)
@@ -109,34 +167,24 @@ static void IRAM_ATTR _rmt_adapter(const void *src, rmt_item32_t *dest, size_t s
         *item_num = 0;
         return;
     }
-    size_t size = 0;
-    size_t num = 0;
-    uint8_t *psrc = (uint8_t *)src;
-    rmt_item32_t *pdest = dest;
 #ifdef LED_STRIP_BRIGHTNESS
     led_strip_t *strip;
     esp_err_t r = rmt_translator_get_context(item_num, (void **)&strip);
     uint8_t brightness = r == ESP_OK ? strip->brightness : 255;
-#endif
-    while (size < src_size && num < wanted_num)
+    const uint8_t *map = NULL;
+    size_t size = 0, ch = 0;
+    if (r == ESP_OK && strip->rgb_buf)
     {
-#ifdef LED_STRIP_BRIGHTNESS
-        uint8_t b = brightness != 255 ? scale8_video(*psrc, brightness) : *psrc;
+        map = strip->buf_map;
+        size = COLOR_SIZE(strip);
+        ch = ((const uint8_t *)src - strip->buf) % size;
+    }
 #else
-        uint8_t b = *psrc;
+    uint8_t brightness = 255;
+    const uint8_t *map = NULL;
+    size_t size = 0, ch = 0;
 #endif
-        for (int i = 0; i < 8; i++)
-        {
-            // MSB first
-            pdest->val = b & (1 << (7 - i)) ? bit1->val : bit0->val;
-            num++;
-            pdest++;
-        }
-        size++;
-        psrc++;
-    }
-    *translated_size = size;
-    *item_num = num;
+    encode_bytes(src, dest, src_size, wanted_num, translated_size, item_num, bit0, bit1, brightness, map, size, ch);
 }
 
 static void IRAM_ATTR ws2812_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
@@ -164,9 +212,320 @@ static void IRAM_ATTR apa106_rmt_adapter(const void *src, rmt_item32_t *dest, si
 }
 
 ///////////////////////////////////////////////////////////////////////////////
+// Waveform model
+//
+// High-time windows from the datasheets (nominal +/- 150 ns) and the reset
+// (latch) time each type needs after a frame. A bit decodes as 1 if its high
+// time is above the midpoint between the T0H and T1H windows.
+
+typedef struct
+{
+    const rmt_item32_t *bit0;
+    const rmt_item32_t *bit1;
+    uint32_t t0h_min_ns, t0h_max_ns;
+    uint32_t t1h_min_ns, t1h_max_ns;
+    uint32_t reset_us;
+    uint8_t active_level;  // Level of the high phase on the wire
+    uint32_t bit_ns;       // Nominal bit period and 1 bit high time, for the SPI encoding
+    uint32_t t1h_ns;
+} timing_spec_t;
+
+static esp_err_t timing_spec(const led_strip_t *strip, timing_spec_t *spec)
+{
+    switch (strip->type)
+    {
+        case LED_STRIP_WS2812:
+        case LED_STRIP_WS2812_INV:
+            *spec = (timing_spec_t){
+                .bit0 = strip->type == LED_STRIP_WS2812 ? &ws2812_bit0 : &ws2812_inv_bit0,
+                .bit1 = strip->type == LED_STRIP_WS2812 ? &ws2812_bit1 : &ws2812_inv_bit1,
+                .t0h_min_ns = 250, .t0h_max_ns = 550,
+                .t1h_min_ns = 650, .t1h_max_ns = 950,
+                .reset_us = 50,
+                .active_level = strip->type == LED_STRIP_WS2812 ? 1 : 0,
+                .bit_ns = WS2812_T0H_NS + WS2812_T0L_NS, .t1h_ns = WS2812_T1H_NS,
+            };
+            return ESP_OK;
+        case LED_STRIP_SK6812:
+            *spec = (timing_spec_t){
+                .bit0 = &sk6812_bit0, .bit1 = &sk6812_bit1,
+                .t0h_min_ns = 150, .t0h_max_ns = 450,
+                .t1h_min_ns = 450, .t1h_max_ns = 750,
+                .reset_us = 80,
+                .active_level = 1,
+                .bit_ns = SK6812_T0H_NS + SK6812_T0L_NS, .t1h_ns = SK6812_T1H_NS,
+            };
+            return ESP_OK;
+        case LED_STRIP_APA106:
+            *spec = (timing_spec_t){
+                .bit0 = &apa106_bit0, .bit1 = &apa106_bit1,
+                .t0h_min_ns = 200, .t0h_max_ns = 500,
+                .t1h_min_ns = 1210, .t1h_max_ns = 1510,
+                .reset_us = 50,
+                .active_level = 1,
+                .bit_ns = APA106_T0H_NS + APA106_T0L_NS, .t1h_ns = APA106_T1H_NS,
+            };
+            return ESP_OK;
+        default:
+            ESP_LOGE(TAG, "Unknown strip type %d", strip->type);
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+}
+
+static inline uint32_t ticks_to_ns(uint32_t ticks)
+{
+    return (uint64_t)ticks * LED_STRIP_RMT_CLK_DIV * 1000000000ULL / APB_CLK_FREQ;
+}
+
+static inline uint32_t item_ns(const rmt_item32_t *item)
+{
+    return ticks_to_ns(item->duration0 + item->duration1);
+}
+
+// SPI encoding for the strip type. Not every type fits every number of SPI
+// bits: the high times are whole SPI bits and must stay inside the windows.
+static esp_err_t spi_code(const led_strip_t *strip, const timing_spec_t *spec, led_strip_spi_code_t *code)
+{
+    if (strip->type == LED_STRIP_WS2812_INV)
+    {
+        ESP_LOGE(TAG, "Inverted output is not supported by SPI backend");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    CHECK(led_strip_spi_code_init(code, strip->spi_bits ? strip->spi_bits : 4, spec->bit_ns, spec->t1h_ns));
+
+    uint32_t t0h_ns = code->t0h_units * code->unit_ns;
+    uint32_t t1h_ns = code->t1h_units * code->unit_ns;
+    if (t0h_ns < spec->t0h_min_ns || t0h_ns > spec->t0h_max_ns
+            || t1h_ns < spec->t1h_min_ns || t1h_ns > spec->t1h_max_ns)
+    {
+        ESP_LOGE(TAG, "Strip type %d does not fit %d SPI bits per bit (T0H %d ns, T1H %d ns)",
+                 strip->type, code->bits, (int)t0h_ns, (int)t1h_ns);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// RGBW white extraction
+//
+// Corrected mode treats the white LED as a mix of RGB given by white_point.
+// W is the largest amount of that mix contained in the color, and its RGB
+// equivalent is taken out of the color:
+//   W = min(c * 255 / white_c), c' = c - W * white_c / 255
+// With a white_lut both terms come from tables: 3 x 256 bytes for the first
+// (index = c) and 3 x 256 bytes for the second (index = W).
+
+static inline rgb_t white_point(const led_strip_t *strip)
+{
+    return rgb_is_zero(strip->white_point) ? rgb_from_code(0xffffff) : strip->white_point;
+}
+
+static inline uint8_t white_to_w(uint8_t v, uint8_t wc)
+{
+    if (!wc)
+        return 255;
+    uint16_t w = v * 255 / wc;
+    return w > 255 ? 255 : w;
+}
+
+static inline uint8_t white_from_w(uint8_t w, uint8_t wc)
+{
+    return w * wc / 255;
+}
+
+#ifdef CONFIG_LED_STRIP_WHITE_LUT
+static void white_lut_build(led_strip_t *strip)
+{
+    rgb_t wp = white_point(strip);
+    uint8_t *lut = strip->white_lut;
+    for (int v = 0; v < 256; v++)
+    {
+        lut[v] = white_to_w(v, wp.r);
+        lut[256 + v] = white_to_w(v, wp.g);
+        lut[512 + v] = white_to_w(v, wp.b);
+        lut[768 + v] = white_from_w(v, wp.r);
+        lut[1024 + v] = white_from_w(v, wp.g);
+        lut[1280 + v] = white_from_w(v, wp.b);
+    }
+}
+#endif
+
+static inline uint8_t min3(uint8_t a, uint8_t b, uint8_t c)
+{
+    uint8_t m = a < b ? a : b;
+    return m < c ? m : c;
+}
+
+// Removes the white part from 'c' and returns the W channel value
+static inline uint8_t extract_white(const led_strip_t *strip, rgb_t *c)
+{
+    uint8_t w;
+    switch (strip->white_mode)
+    {
+        case LED_STRIP_WHITE_MIN:
+            w = min3(c->r, c->g, c->b);
+            c->r -= w;
+            c->g -= w;
+            c->b -= w;
+            return w;
+        case LED_STRIP_WHITE_CORRECTED:
+            if (strip->white_lut)
+            {
+                const uint8_t *lut = strip->white_lut;
+                w = min3(lut[c->r], lut[256 + c->g], lut[512 + c->b]);
+                c->r -= lut[768 + w];
+                c->g -= lut[1024 + w];
+                c->b -= lut[1280 + w];
+            }
+            else
+            {
+                rgb_t wp = white_point(strip);
+                w = min3(white_to_w(c->r, wp.r), white_to_w(c->g, wp.g), white_to_w(c->b, wp.b));
+                c->r -= white_from_w(w, wp.r);
+                c->g -= white_from_w(w, wp.g);
+                c->b -= white_from_w(w, wp.b);
+            }
+            return w;
+        default:
+            return rgb_luma(*c);
+    }
+}
+
+// Output stage: converts 'len' RGB pixels to the wire format of the strip,
+// writing one LED every 'stride' bytes from 'p'. The white extraction mode
+// is resolved once per call, each loop is a straight per-pixel kernel. A
+// buffer already in RGB order is copied.
+static void write_pixels(const led_strip_t *strip, uint8_t *p, ptrdiff_t stride, const rgb_t *data, size_t len,
+                         size_t r, size_t g, size_t b)
+{
+    if (!strip->is_rgbw)
+    {
+        // Buffer in RGB order (`rgb_buf` or an RGB strip): rgb_t is its layout
+        if (r == 0 && g == 1 && b == 2)
+        {
+            if (stride == sizeof(rgb_t))
+                memcpy(p, data, len * sizeof(rgb_t));
+            else
+                for (size_t i = 0; i < len; i++, p += stride)
+                    memcpy(p, &data[i], sizeof(rgb_t));
+            return;
+        }
+        for (size_t i = 0; i < len; i++, p += stride)
+        {
+            p[r] = data[i].r;
+            p[g] = data[i].g;
+            p[b] = data[i].b;
+        }
+        return;
+    }
+
+    switch (strip->white_mode)
+    {
+        case LED_STRIP_WHITE_MIN:
+            for (size_t i = 0; i < len; i++, p += stride)
+            {
+                uint8_t w = min3(data[i].r, data[i].g, data[i].b);
+                p[r] = data[i].r - w;
+                p[g] = data[i].g - w;
+                p[b] = data[i].b - w;
+                p[3] = w;
+            }
+            break;
+        case LED_STRIP_WHITE_CORRECTED:
+            if (strip->white_lut)
+            {
+                const uint8_t *to_w = strip->white_lut;
+                const uint8_t *from_w = strip->white_lut + 768;
+                for (size_t i = 0; i < len; i++, p += stride)
+                {
+                    uint8_t w = min3(to_w[data[i].r], to_w[256 + data[i].g], to_w[512 + data[i].b]);
+                    p[r] = data[i].r - from_w[w];
+                    p[g] = data[i].g - from_w[256 + w];
+                    p[b] = data[i].b - from_w[512 + w];
+                    p[3] = w;
+                }
+                break;
+            }
+            for (size_t i = 0; i < len; i++, p += stride)
+            {
+                rgb_t c = data[i];
+                p[3] = extract_white(strip, &c);
+                p[r] = c.r;
+                p[g] = c.g;
+                p[b] = c.b;
+            }
+            break;
+        default:
+            for (size_t i = 0; i < len; i++, p += stride)
+            {
+                p[r] = data[i].r;
+                p[g] = data[i].g;
+                p[b] = data[i].b;
+                p[3] = rgb_luma(data[i]);
+            }
+            break;
+    }
+}
+
+// Byte offsets of the R, G and B channels within one LED on the wire
+static esp_err_t wire_order(const led_strip_t *strip, size_t *r, size_t *g, size_t *b)
+{
+    switch (strip->type)
+    {
+        case LED_STRIP_WS2812:
+        case LED_STRIP_WS2812_INV:
+        case LED_STRIP_SK6812:
+            // GRB
+            *r = 1;
+            *g = 0;
+            *b = 2;
+            return ESP_OK;
+        case LED_STRIP_APA106:
+            // RGB
+            *r = 0;
+            *g = 1;
+            *b = 2;
+            return ESP_OK;
+        default:
+            ESP_LOGE(TAG, "Unknown strip type %d", strip->type);
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+}
+
+// Byte offsets of the R, G and B channels within one LED in strip buffer
+static esp_err_t color_order(const led_strip_t *strip, size_t *r, size_t *g, size_t *b)
+{
+    if (!strip->rgb_buf)
+        return wire_order(strip, r, g, b);
+    *r = 0;
+    *g = 1;
+    *b = 2;
+    return ESP_OK;
+}
+
+// Buffer byte of each wire channel of an `rgb_buf` strip
+static esp_err_t buf_map_build(led_strip_t *strip)
+{
+    size_t r, g, b;
+    CHECK(wire_order(strip, &r, &g, &b));
+    strip->buf_map[r] = 0;
+    strip->buf_map[g] = 1;
+    strip->buf_map[b] = 2;
+    strip->buf_map[3] = 3;
+    return ESP_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void IRAM_ATTR tx_end_callback(rmt_channel_t channel, void *arg)
+{
+    tx_end_us[channel] = esp_timer_get_time();
+}
 
 void led_strip_install()
 {
+    rmt_register_tx_end_callback(tx_end_callback, NULL);
+
     double ratio = (double)(APB_CLK_FREQ) / LED_STRIP_RMT_CLK_DIV / 1e09;
 
     ws2812_bit0.duration0 = ratio * WS2812_T0H_NS;
@@ -206,9 +565,39 @@ void led_strip_install()
     apa106_bit1.level1 = 0;
 }
 
+static esp_err_t check_waveform_on_init(led_strip_t *strip)
+{
+#ifdef CONFIG_LED_STRIP_CHECK_WAVEFORM
+    static const uint8_t pattern[] = { 0x00, 0xff, 0xa5, 0x5a, 0x01, 0x80, 0x7f, 0xfe };
+    led_strip_timing_t timing;
+    esp_err_t r = led_strip_check_waveform(strip, pattern, sizeof(pattern), NULL);
+    if (r != ESP_OK)
+    {
+        // Release what led_strip_init() set up
+        led_strip_free(strip);
+        strip->buf = NULL;
+        return r;
+    }
+    CHECK(led_strip_get_timing(strip, &timing));
+    ESP_LOGI(TAG, "Waveform OK: T0H %d ns, T1H %d ns, frame %d us + %d us reset for %d LEDs",
+             (int)timing.t0h_ns, (int)timing.t1h_ns, (int)(timing.frame_ns / 1000), (int)timing.reset_us,
+             (int)strip->length);
+#endif
+    return ESP_OK;
+}
+
 esp_err_t led_strip_init(led_strip_t *strip)
 {
     CHECK_ARG(strip && strip->length > 0);
+    if (strip->rgb_buf)
+    {
+#ifndef LED_STRIP_BRIGHTNESS
+        // The RMT translator needs its context to find the LED boundaries
+        if (strip->backend == LED_STRIP_BACKEND_RMT)
+            return ESP_ERR_NOT_SUPPORTED;
+#endif
+        CHECK(buf_map_build(strip));
+    }
 
     strip->buf = calloc(strip->length, COLOR_SIZE(strip));
     if (!strip->buf)
@@ -217,6 +606,42 @@ esp_err_t led_strip_init(led_strip_t *strip)
         return ESP_ERR_NO_MEM;
     }
 
+    strip->white_lut = NULL;
+#ifdef CONFIG_LED_STRIP_WHITE_LUT
+    if (strip->is_rgbw && strip->white_mode == LED_STRIP_WHITE_CORRECTED)
+    {
+        strip->white_lut = malloc(WHITE_LUT_SIZE);
+        if (!strip->white_lut)
+        {
+            ESP_LOGE(TAG, "Not enough memory");
+            free(strip->buf);
+            strip->buf = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+        white_lut_build(strip);
+    }
+#endif
+
+    if (strip->backend == LED_STRIP_BACKEND_SPI)
+    {
+        timing_spec_t spec;
+        led_strip_spi_code_t code;
+        esp_err_t r = timing_spec(strip, &spec);
+        if (r == ESP_OK)
+            r = spi_code(strip, &spec, &code);
+        if (r == ESP_OK)
+            r = led_strip_spi_init(strip, &code, spec.reset_us);
+        if (r != ESP_OK)
+        {
+            free(strip->buf);
+            free(strip->white_lut);
+            strip->buf = NULL;
+            strip->white_lut = NULL;
+            return r;
+        }
+        return check_waveform_on_init(strip);
+    }
+
     rmt_config_t config = RMT_DEFAULT_CONFIG_TX(strip->gpio, strip->channel);
     config.clk_div = LED_STRIP_RMT_CLK_DIV;
     config.mem_block_num = 8;
@@ -249,6 +674,7 @@ esp_err_t led_strip_init(led_strip_t *strip)
             return ESP_ERR_NOT_SUPPORTED;
     }
     CHECK(rmt_translator_init(config.channel, f));
+    CHECK(check_waveform_on_init(strip));
 #ifdef LED_STRIP_BRIGHTNESS
     // No support for translator context prior to ESP-IDF 4.4
     CHECK(rmt_translator_set_context(config.channel, strip));
@@ -261,33 +687,81 @@ esp_err_t led_strip_free(led_strip_t *strip)
 {
     CHECK_ARG(strip && strip->buf);
     free(strip->buf);
+    free(strip->white_lut);
+    strip->white_lut = NULL;
 
-    CHECK(rmt_driver_uninstall(strip->channel));
+    if (strip->backend == LED_STRIP_BACKEND_SPI)
+        CHECK(led_strip_spi_free(strip));
+    else
+        CHECK(rmt_driver_uninstall(strip->channel));
 
     return ESP_OK;
 }
 
+// Microseconds of the latch period still to wait before the next frame may
+// start. The TX end interrupt may not have run yet right after
+// rmt_wait_tx_done() returned; then the frame has only just ended.
+static uint32_t latch_remaining_us(const led_strip_t *strip, uint32_t reset_us)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t end = tx_end_us[strip->channel];
+    if (end < tx_start_us[strip->channel])
+        end = now;
+    int64_t elapsed = now - end;
+    return elapsed >= reset_us ? 0 : reset_us - elapsed;
+}
+
+// Runs the flush hook for a frame that started
+static esp_err_t frame_started(led_strip_t *strip, esp_err_t r)
+{
+    if (r == ESP_OK && strip->flush_cb)
+        strip->flush_cb(strip->flush_arg);
+    return r;
+}
+
+static esp_err_t start_frame(led_strip_t *strip)
+{
+    tx_start_us[strip->channel] = esp_timer_get_time();
+    return frame_started(strip, rmt_write_sample(strip->channel, strip->buf,
+                                                 strip->length * COLOR_SIZE(strip), false));
+}
+
 esp_err_t led_strip_flush(led_strip_t *strip)
 {
     CHECK_ARG(strip && strip->buf);
-    CHECK(rmt_wait_tx_done(strip->channel, pdMS_TO_TICKS(1000)));
-    ets_delay_us(50);
-    /*
-    int size = COLOR_SIZE(strip);
-    ESP_LOGI( "RGB", "%02x%02x%02x %02x%02x%02x %02x%02x%02x %02x%02x%02x",
-             strip->buf[size*26], strip->buf[size*26+1], strip->buf[size*26+2],
-             strip->buf[size*27], strip->buf[size*27+1], strip->buf[size*27+2],
-             strip->buf[size*28], strip->buf[size*28+1], strip->buf[size*28+2],
-             strip->buf[size*29], strip->buf[size*28+1], strip->buf[size*28+2]
-    );
-    */
-    return rmt_write_sample(strip->channel, strip->buf,
-                            strip->length * COLOR_SIZE(strip), false);
+
+    if (strip->backend == LED_STRIP_BACKEND_SPI)
+        return frame_started(strip, led_strip_spi_flush(strip, pdMS_TO_TICKS(CONFIG_LED_STRIP_FLUSH_TIMEOUT)));
+
+    timing_spec_t spec;
+    CHECK(timing_spec(strip, &spec));
+    CHECK(rmt_wait_tx_done(strip->channel, pdMS_TO_TICKS(CONFIG_LED_STRIP_FLUSH_TIMEOUT)));
+
+    uint32_t latch = latch_remaining_us(strip, spec.reset_us);
+    if (latch)
+        ets_delay_us(latch);
+    return start_frame(strip);
+}
+
+esp_err_t led_strip_try_flush(led_strip_t *strip)
+{
+    CHECK_ARG(strip && strip->buf);
+
+    if (strip->backend == LED_STRIP_BACKEND_SPI)
+        return frame_started(strip, led_strip_spi_flush(strip, 0));
+
+    timing_spec_t spec;
+    CHECK(timing_spec(strip, &spec));
+    if (rmt_wait_tx_done(strip->channel, 0) != ESP_OK || latch_remaining_us(strip, spec.reset_us))
+        return ESP_ERR_TIMEOUT;
+    return start_frame(strip);
 }
 
 bool led_strip_busy(led_strip_t *strip)
 {
     if (!strip) return false;
+    if (strip->backend == LED_STRIP_BACKEND_SPI)
+        return led_strip_spi_wait(strip, 0) == ESP_ERR_TIMEOUT;
     return rmt_wait_tx_done(strip->channel, 0) == ESP_ERR_TIMEOUT;
 }
 
@@ -295,53 +769,381 @@ esp_err_t led_strip_wait(led_strip_t *strip, TickType_t timeout)
 {
     CHECK_ARG(strip);
 
+    if (strip->backend == LED_STRIP_BACKEND_SPI)
+        return led_strip_spi_wait(strip, timeout);
     return rmt_wait_tx_done(strip->channel, timeout);
 }
 
-esp_err_t led_strip_set_pixel(led_strip_t *strip, size_t num, rgb_t color)
+esp_err_t led_strip_color(const led_strip_t *strip, rgb_t color, led_strip_color_t *out)
 {
-    CHECK_ARG(strip && strip->buf && num <= strip->length);
-    size_t idx = num * COLOR_SIZE(strip);
-    switch (strip->type)
+    CHECK_ARG(strip && out);
+
+    size_t r, g, b;
+    CHECK(color_order(strip, &r, &g, &b));
+    out->bytes[3] = strip->is_rgbw ? extract_white(strip, &color) : 0;
+    out->bytes[r] = color.r;
+    out->bytes[g] = color.g;
+    out->bytes[b] = color.b;
+    return ESP_OK;
+}
+
+// Copies wire color to 'len' consecutive LEDs starting at 'p'
+static inline void store_color(uint8_t *p, size_t size, size_t len, led_strip_color_t color)
+{
+    if (size == 4)
     {
-        case LED_STRIP_WS2812:
-        case LED_STRIP_WS2812_INV:
-        case LED_STRIP_SK6812:
-            // GRB
-            strip->buf[idx] = color.g;
-            strip->buf[idx + 1] = color.r;
-            strip->buf[idx + 2] = color.b;
-            if (strip->is_rgbw)
-                strip->buf[idx + 3] = rgb_luma(color);
-            break;
-        case LED_STRIP_APA106:
-            // RGB
-            strip->buf[idx] = color.r;
-            strip->buf[idx + 1] = color.g;
-            strip->buf[idx + 2] = color.b;
-            if (strip->is_rgbw)
-                strip->buf[idx + 3] = rgb_luma(color);
-            break;
-        default:
-            ESP_LOGE(TAG, "Unknown strip type %d", strip->type);
-            return ESP_ERR_NOT_SUPPORTED;
+        for (size_t i = 0; i < len; i++, p += 4)
+            memcpy(p, color.bytes, 4);
+    }
+    else
+    {
+        for (size_t i = 0; i < len; i++, p += 3)
+            memcpy(p, color.bytes, 3);
+    }
+}
+
+esp_err_t led_strip_get_timing(const led_strip_t *strip, led_strip_timing_t *timing)
+{
+    CHECK_ARG(strip && timing);
+
+    timing_spec_t spec;
+    CHECK(timing_spec(strip, &spec));
+    timing->reset_us = spec.reset_us;
+
+    if (strip->backend == LED_STRIP_BACKEND_SPI)
+    {
+        led_strip_spi_code_t code;
+        CHECK(spi_code(strip, &spec, &code));
+        timing->t0h_ns = code.t0h_units * code.unit_ns;
+        timing->t0l_ns = (code.bits - code.t0h_units) * code.unit_ns;
+        timing->t1h_ns = code.t1h_units * code.unit_ns;
+        timing->t1l_ns = (code.bits - code.t1h_units) * code.unit_ns;
+        timing->frame_ns = (uint64_t)strip->length * COLOR_SIZE(strip) * 8 * code.bits * code.unit_ns;
+        return ESP_OK;
     }
+
+    timing->t0h_ns = ticks_to_ns(spec.bit0->duration0);
+    timing->t0l_ns = ticks_to_ns(spec.bit0->duration1);
+    timing->t1h_ns = ticks_to_ns(spec.bit1->duration0);
+    timing->t1l_ns = ticks_to_ns(spec.bit1->duration1);
+
+    uint32_t bit_ns = item_ns(spec.bit0) > item_ns(spec.bit1) ? item_ns(spec.bit0) : item_ns(spec.bit1);
+    timing->frame_ns = (uint64_t)strip->length * COLOR_SIZE(strip) * 8 * bit_ns;
     return ESP_OK;
 }
 
-esp_err_t led_strip_set_pixels(led_strip_t *strip, size_t start, size_t len, rgb_t *data)
+// Decodes one bit from its high time and checks it against the windows
+static esp_err_t check_bit(const timing_spec_t *spec, size_t pos, int bit, uint32_t high_ns, uint8_t *decoded)
+{
+    uint32_t threshold_ns = (spec->t0h_max_ns + spec->t1h_min_ns) / 2;
+    bool one = high_ns > threshold_ns;
+    uint32_t min_ns = one ? spec->t1h_min_ns : spec->t0h_min_ns;
+    uint32_t max_ns = one ? spec->t1h_max_ns : spec->t0h_max_ns;
+    if (high_ns < min_ns || high_ns > max_ns)
+    {
+        ESP_LOGE(TAG, "Byte %d bit %d: T%dH %d ns outside %d..%d ns", (int)pos, bit, one,
+                 (int)high_ns, (int)min_ns, (int)max_ns);
+        return ESP_FAIL;
+    }
+    *decoded = (*decoded << 1) | one;
+    return ESP_OK;
+}
+
+static esp_err_t check_decoded(size_t pos, uint8_t decoded, uint8_t expected)
+{
+    if (decoded != expected)
+    {
+        ESP_LOGE(TAG, "Byte %d: decoded 0x%02x, expected 0x%02x", (int)pos, decoded, expected);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// SPI bits of every LED bit must be a run of ones followed by zeros
+static esp_err_t check_waveform_spi(const led_strip_t *strip, const timing_spec_t *spec, const uint8_t *data,
+                                    size_t len, uint8_t brightness, uint64_t *total_ns)
+{
+    led_strip_spi_code_t code;
+    CHECK(spi_code(strip, spec, &code));
+
+    uint8_t out[4];
+    for (size_t pos = 0; pos < len; pos++)
+    {
+        led_strip_spi_encode(&code, data + pos, 1, out, brightness, NULL, 0);
+        uint32_t v = 0;
+        for (int i = 0; i < code.bits; i++)
+            v = (v << 8) | out[i];
+
+        uint8_t decoded = 0;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            uint32_t group = (v >> ((7 - bit) * code.bits)) & ((1 << code.bits) - 1);
+            int high = 0;
+            while (high < code.bits && group & (1 << (code.bits - 1 - high)))
+                high++;
+            if (!high || group & ((1 << (code.bits - high)) - 1))
+            {
+                ESP_LOGE(TAG, "Byte %d bit %d: bad SPI bit pattern 0x%x", (int)pos, bit, (int)group);
+                return ESP_FAIL;
+            }
+            CHECK(check_bit(spec, pos, bit, high * code.unit_ns, &decoded));
+            *total_ns += code.bits * code.unit_ns;
+        }
+        CHECK(check_decoded(pos, decoded, brightness != 255 ? scale8_video(data[pos], brightness) : data[pos]));
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_check_waveform(const led_strip_t *strip, const uint8_t *data, size_t len, uint64_t *wire_ns)
+{
+    CHECK_ARG(strip && data && len);
+
+    timing_spec_t spec;
+    CHECK(timing_spec(strip, &spec));
+#ifdef LED_STRIP_BRIGHTNESS
+    uint8_t brightness = strip->brightness;
+#else
+    uint8_t brightness = 255;
+#endif
+    uint64_t total_ns = 0;
+
+    if (strip->backend == LED_STRIP_BACKEND_SPI)
+    {
+        CHECK(check_waveform_spi(strip, &spec, data, len, brightness, &total_ns));
+        if (wire_ns)
+            *wire_ns = total_ns;
+        return ESP_OK;
+    }
+
+    // Encode in chunks the way the RMT driver calls the translator
+    rmt_item32_t items[8 * 8];
+    for (size_t pos = 0; pos < len;)
+    {
+        size_t translated, num;
+        encode_bytes(data + pos, items, len - pos, 8 * 8, &translated, &num, spec.bit0, spec.bit1, brightness,
+                     NULL, 0, 0);
+        if (!translated || num != translated * 8)
+        {
+            ESP_LOGE(TAG, "Translator produced %d items for %d bytes", (int)num, (int)translated);
+            return ESP_FAIL;
+        }
+
+        for (size_t i = 0; i < translated; i++)
+        {
+            uint8_t expected = brightness != 255 ? scale8_video(data[pos + i], brightness) : data[pos + i];
+            uint8_t decoded = 0;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                const rmt_item32_t *item = &items[i * 8 + bit];
+                if (item->level0 != spec.active_level || item->level1 == spec.active_level)
+                {
+                    ESP_LOGE(TAG, "Byte %d bit %d: wrong levels %d/%d", (int)(pos + i), bit, item->level0, item->level1);
+                    return ESP_FAIL;
+                }
+                CHECK(check_bit(&spec, pos + i, bit, ticks_to_ns(item->duration0), &decoded));
+                total_ns += item_ns(item);
+            }
+            CHECK(check_decoded(pos + i, decoded, expected));
+        }
+        pos += translated;
+    }
+
+    if (wire_ns)
+        *wire_ns = total_ns;
+    return ESP_OK;
+}
+
+esp_err_t led_strip_read_rgb(const led_strip_t *strip, uint8_t *out)
+{
+    CHECK_ARG(strip && strip->buf && out);
+
+    size_t r, g, b;
+    CHECK(color_order(strip, &r, &g, &b));
+    size_t size = COLOR_SIZE(strip);
+    if (r == 0 && g == 1)
+    {
+        memcpy(out, strip->buf, strip->length * size);
+        return ESP_OK;
+    }
+    const uint8_t *p = strip->buf;
+    for (size_t i = 0; i < strip->length; i++, p += size, out += size)
+    {
+        out[0] = p[r];
+        out[1] = p[g];
+        out[2] = p[b];
+        if (size == 4)
+            out[3] = p[3];
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_set_color(led_strip_t *strip, size_t num, led_strip_color_t color)
+{
+    CHECK_ARG(strip && strip->buf && num < strip->length);
+
+    size_t size = COLOR_SIZE(strip);
+    memcpy(strip->buf + num * size, color.bytes, size);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_fill_color(led_strip_t *strip, size_t start, size_t len, led_strip_color_t color)
 {
     CHECK_ARG(strip && strip->buf && len && start + len <= strip->length);
-    for (size_t i = 0; i < len; i++)
-        CHECK(led_strip_set_pixel(strip, i + start, data[i]));
+
+    size_t size = COLOR_SIZE(strip);
+    store_color(strip->buf + start * size, size, len, color);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_set_pixel(led_strip_t *strip, size_t num, rgb_t color)
+{
+    led_strip_color_t c;
+    CHECK(led_strip_color(strip, color, &c));
+    return led_strip_set_color(strip, num, c);
+}
+
+esp_err_t led_strip_set_pixels(led_strip_t *strip, size_t start, size_t len, rgb_t *data)
+{
+    CHECK_ARG(strip && strip->buf && data && len && start + len <= strip->length);
+
+    size_t r, g, b;
+    CHECK(color_order(strip, &r, &g, &b));
+
+    size_t size = COLOR_SIZE(strip);
+    write_pixels(strip, strip->buf + start * size, size, data, len, r, g, b);
     return ESP_OK;
 }
 
 esp_err_t led_strip_fill(led_strip_t *strip, size_t start, size_t len, rgb_t color)
 {
-    CHECK_ARG(strip && strip->buf && len && start + len <= strip->length);
+    led_strip_color_t c;
+    CHECK(led_strip_color(strip, color, &c));
+    return led_strip_fill_color(strip, start, len, c);
+}
 
-    for (size_t i = start; i < start + len; i++)
-        CHECK(led_strip_set_pixel(strip, i, color));
+esp_err_t led_strip_set_pixels_rgbx(led_strip_t *strip, size_t start, size_t len, const rgbx_t *data)
+{
+    CHECK_ARG(strip && strip->buf && data && len && start + len <= strip->length);
+
+    size_t r, g, b;
+    CHECK(color_order(strip, &r, &g, &b));
+
+    size_t size = COLOR_SIZE(strip);
+    uint8_t *p = strip->buf + start * size;
+    for (size_t i = 0; i < len; i++, p += size)
+    {
+        rgb_t c = rgb_from_rgbx(data[i]);
+        if (strip->is_rgbw)
+            p[3] = extract_white(strip, &c);
+        p[r] = c.r;
+        p[g] = c.g;
+        p[b] = c.b;
+    }
+    return ESP_OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+esp_err_t led_strip_segment_init(led_strip_segment_t *seg, led_strip_t *strip, size_t offset, size_t length,
+                                 bool reversed, size_t serpentine_width)
+{
+    CHECK_ARG(seg && strip && strip->buf && length && length <= strip->length && offset <= strip->length - length);
+    CHECK_ARG(!serpentine_width || length % serpentine_width == 0);
+
+    seg->strip = strip;
+    seg->offset = offset;
+    seg->length = length;
+    seg->reversed = reversed;
+    seg->serpentine_width = serpentine_width;
+
+    return ESP_OK;
+}
+
+// Longest run of segment pixels starting at 'num' that are adjacent in the
+// strip buffer. Returns run length (at most 'remaining'), the strip index of
+// pixel 'num' and the step between consecutive pixels of the run (+1 or -1).
+static size_t segment_run(const led_strip_segment_t *seg, size_t num, size_t remaining, size_t *first, int *step)
+{
+    size_t k = seg->reversed ? seg->length - 1 - num : num;
+    int dir = seg->reversed ? -1 : 1;
+    size_t run = remaining;
+
+    if (seg->serpentine_width)
+    {
+        size_t w = seg->serpentine_width;
+        size_t row = k / w;
+        size_t col = k % w;
+        size_t left = dir > 0 ? w - col : col + 1; // Pixels until the row ends
+        if (run > left)
+            run = left;
+        if (row & 1)
+        {
+            k = row * w + (w - 1 - col);
+            dir = -dir;
+        }
+    }
+
+    *first = seg->offset + k;
+    *step = dir;
+    return run;
+}
+
+esp_err_t led_strip_segment_set_pixel(led_strip_segment_t *seg, size_t num, rgb_t color)
+{
+    CHECK_ARG(seg && num < seg->length);
+
+    size_t first;
+    int step;
+    segment_run(seg, num, 1, &first, &step);
+    return led_strip_set_pixel(seg->strip, first, color);
+}
+
+esp_err_t led_strip_segment_fill(led_strip_segment_t *seg, size_t start, size_t len, rgb_t color)
+{
+    CHECK_ARG(seg);
+
+    led_strip_color_t c;
+    CHECK(led_strip_color(seg->strip, color, &c));
+    return led_strip_segment_fill_color(seg, start, len, c);
+}
+
+esp_err_t led_strip_segment_fill_color(led_strip_segment_t *seg, size_t start, size_t len, led_strip_color_t color)
+{
+    CHECK_ARG(seg && len && len <= seg->length && start <= seg->length - len);
+
+    size_t size = COLOR_SIZE(seg->strip);
+    while (len)
+    {
+        size_t first;
+        int step;
+        size_t run = segment_run(seg, start, len, &first, &step);
+        // Same color everywhere, so direction does not matter
+        if (step < 0)
+            first -= run - 1;
+        store_color(seg->strip->buf + first * size, size, run, color);
+        start += run;
+        len -= run;
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_segment_blit(led_strip_segment_t *seg, size_t start, size_t len, const rgb_t *data)
+{
+    CHECK_ARG(seg && data && len && len <= seg->length && start <= seg->length - len);
+
+    size_t r, g, b;
+    CHECK(color_order(seg->strip, &r, &g, &b));
+    size_t size = COLOR_SIZE(seg->strip);
+
+    while (len)
+    {
+        size_t first;
+        int step;
+        size_t run = segment_run(seg, start, len, &first, &step);
+        write_pixels(seg->strip, seg->strip->buf + first * size, step * (ptrdiff_t)size, data, run, r, g, b);
+        data += run;
+        start += run;
+        len -= run;
+    }
     return ESP_OK;
 }
@@ -38,6 +38,7 @@
 #include <driver/gpio.h>
 #include <esp_err.h>
 #include <driver/rmt.h>
+#include <driver/spi_master.h>
 #include <color.h>
 
 #ifdef __cplusplus
@@ -59,6 +60,32 @@ typedef enum
     LED_STRIP_WS2812_INV,
 } led_strip_type_t;
 
+/**
+ * Peripheral that sends the strip buffer to the LEDs
+ */
+typedef enum
+{
+    LED_STRIP_BACKEND_RMT = 0, ///< RMT, one 32-bit RMT item per bit, encoded in the RMT interrupt
+    LED_STRIP_BACKEND_SPI,     ///< SPI master with DMA, 3 or 4 SPI bits per bit, encoded once per flush.
+                               ///< Uses a whole SPI bus; not for ::LED_STRIP_WS2812_INV
+} led_strip_backend_t;
+
+/**
+ * How the white channel of RGBW strips is derived from RGB colors
+ */
+typedef enum
+{
+    LED_STRIP_WHITE_LUMA = 0,  ///< W = luma of the color, RGB unchanged
+    LED_STRIP_WHITE_MIN,       ///< W = min(R, G, B), subtracted from RGB
+    LED_STRIP_WHITE_CORRECTED, ///< As MIN, relative to the color of the white LED (`white_point`)
+} led_strip_white_mode_t;
+
+/**
+ * Hook called in the task that flushed, right after a frame started. The
+ * strip buffer may be read, not written; keep it short.
+ */
+typedef void (*led_strip_flush_cb_t)(void *arg);
+
 /**
  * LED strip descriptor
  */
@@ -72,10 +99,77 @@ typedef struct
 #endif
     size_t length;         ///< Number of LEDs in strip
     gpio_num_t gpio;       ///< Data GPIO pin
-    rmt_channel_t channel; ///< RMT channel
+    led_strip_backend_t backend; ///< Output peripheral, set before ::led_strip_init()
+    rmt_channel_t channel; ///< RMT backend: RMT channel
+    spi_host_device_t spi_host; ///< SPI backend: SPI host (`SPI2_HOST` or `SPI3_HOST`)
+    uint8_t spi_bits;      ///< SPI backend: SPI bits per bit, 3 or 4 (0 for 4).
+                           ///< 3 bits need 25% less DMA memory but fit WS2812 only
+    led_strip_white_mode_t white_mode; ///< RGBW only: white extraction mode, set before ::led_strip_init()
+    rgb_t white_point;     ///< RGBW only: color of the white LED at full power, as RGB.
+                           ///< Used by ::LED_STRIP_WHITE_CORRECTED, black means pure white
+    bool rgb_buf;          ///< `buf` holds R, G, B(, W) per LED instead of wire order; the encoder
+                           ///< reorders while sending. Set before ::led_strip_init(), e.g. to receive
+                           ///< network pixel data straight into `buf`. Needs ESP-IDF >= 4.4 for RMT
+    led_strip_flush_cb_t flush_cb; ///< Called after every frame started by ::led_strip_flush() or
+                           ///< ::led_strip_try_flush(), may be NULL
+    void *flush_arg;       ///< Argument of `flush_cb`
     uint8_t *buf;
+    uint8_t *white_lut;    ///< Internal: extraction tables for ::LED_STRIP_WHITE_CORRECTED
+    void *spi;             ///< Internal: SPI backend state
+    uint8_t buf_map[4];    ///< Internal: `rgb_buf` byte of each wire channel
 } led_strip_t;
 
+/**
+ * Color in the wire order of a strip (or RGB order with `rgb_buf`),
+ * including the white channel of RGBW strips. Convert once with
+ * ::led_strip_color() (or build a constant with ::LED_STRIP_COLOR_GRB /
+ * ::LED_STRIP_COLOR_RGB) and reuse it; writing it into the strip buffer is a
+ * plain 3 or 4 byte copy.
+ */
+typedef union
+{
+    uint8_t bytes[4]; ///< Channel bytes in wire order, bytes[3] is white on RGBW strips
+    uint32_t raw;
+} led_strip_color_t;
+
+/// Compile-time wire color for WS2812/SK6812 (GRB order, white channel 0)
+#define LED_STRIP_COLOR_GRB(r, g, b) ((led_strip_color_t){ .bytes = { (g), (r), (b), 0 } })
+/// Compile-time wire color for APA106 (RGB order, white channel 0)
+#define LED_STRIP_COLOR_RGB(r, g, b) ((led_strip_color_t){ .bytes = { (r), (g), (b), 0 } })
+
+/**
+ * Wire timing of a strip, as produced by the RMT translator (rounded to
+ * RMT ticks) or the SPI encoding (rounded to the SPI clock)
+ */
+typedef struct
+{
+    uint32_t t0h_ns;   ///< High time of a 0 bit
+    uint32_t t0l_ns;   ///< Low time of a 0 bit
+    uint32_t t1h_ns;   ///< High time of a 1 bit
+    uint32_t t1l_ns;   ///< Low time of a 1 bit
+    uint64_t frame_ns; ///< Time to send the whole strip buffer (longest bit period for every bit)
+    uint32_t reset_us; ///< Latch time the LEDs need after a frame
+} led_strip_timing_t;
+
+/**
+ * Segment descriptor: a virtual strip mapped onto a stretch of LEDs of a
+ * physical strip.
+ *
+ * Segment pixel 0 is LED `offset` of the strip, or the last LED of the
+ * stretch if `reversed` is set. With a non-zero `serpentine_width` the
+ * stretch is a zig-zag wired matrix: every second run of that many LEDs
+ * runs backwards, so segment pixels are in row-major order.
+ * Segments write straight into the buffer of the strip.
+ */
+typedef struct
+{
+    led_strip_t *strip;      ///< Physical strip
+    size_t offset;           ///< First LED of the stretch on the strip
+    size_t length;           ///< Number of LEDs in segment
+    bool reversed;           ///< Segment runs from the end of the stretch to its start
+    size_t serpentine_width; ///< Zig-zag row length, 0 for a straight stretch
+} led_strip_segment_t;
+
 /**
  * @brief Setup library
  *
@@ -92,7 +186,7 @@ void led_strip_install();
 esp_err_t led_strip_init(led_strip_t *strip);
 
 /**
- * @brief Deallocate buffer memory and release RMT channel
+ * @brief Deallocate buffer memory and release RMT channel or SPI bus
  *
  * @param strip Descriptor of LED strip
  * @return `ESP_OK` on success
@@ -102,21 +196,71 @@ esp_err_t led_strip_free(led_strip_t *strip);
 /**
  * @brief Send strip buffer to LEDs
  *
+ * Waits up to `CONFIG_LED_STRIP_FLUSH_TIMEOUT` ms for the previous frame to
+ * finish, then for what is left of the reset (latch) period of the LED
+ * type since it finished, and starts sending the buffer. The SPI backend
+ * sends the reset period as part of the frame and never busy-waits.
+ *
+ * @note ::led_strip_install() registers the RMT TX end callback to time
+ *       the latch period; do not replace it with your own.
+ *
  * @param strip Descriptor of LED strip
  * @return `ESP_OK` on success
  */
 esp_err_t led_strip_flush(led_strip_t *strip);
 
 /**
- * @brief Check if associated RMT channel is busy
+ * @brief Send strip buffer to LEDs if that is possible without waiting
+ *
+ * Use it to drop a frame rather than stall when the previous frame is still
+ * being sent or latched.
+ *
+ * @param strip Descriptor of LED strip
+ * @return `ESP_OK` if the frame was started, `ESP_ERR_TIMEOUT` if the strip
+ *         is busy and nothing was sent
+ */
+esp_err_t led_strip_try_flush(led_strip_t *strip);
+
+/**
+ * @brief Get wire timing of strip
+ *
+ * Frame rate is limited to 1 / (`frame_ns` + `reset_us`).
+ * Only needs ::led_strip_install(), the strip does not have to be initialized.
  *
  * @param strip Descriptor of LED strip
- * @return true if RMT peripherals is busy
+ * @param[out] timing Wire timing
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_get_timing(const led_strip_t *strip, led_strip_timing_t *timing);
+
+/**
+ * @brief Verify the waveform the RMT translator or SPI encoder generates for given data
+ *
+ * Runs the translator or encoder of the strip over `data` (with strip
+ * brightness applied), decodes the output back to bytes and checks the high
+ * times against the datasheet windows of the LED type. Does not touch the
+ * peripheral. With `CONFIG_LED_STRIP_CHECK_WAVEFORM` this runs on a test
+ * pattern in ::led_strip_init().
+ *
+ * @param strip Descriptor of LED strip
+ * @param data Bytes in wire order
+ * @param len Number of bytes
+ * @param[out] wire_ns Exact wire time of the data, may be NULL
+ * @return `ESP_OK` if the waveform decodes to `data` within the timing
+ *         windows, `ESP_FAIL` otherwise
+ */
+esp_err_t led_strip_check_waveform(const led_strip_t *strip, const uint8_t *data, size_t len, uint64_t *wire_ns);
+
+/**
+ * @brief Check if associated RMT channel or SPI bus is busy
+ *
+ * @param strip Descriptor of LED strip
+ * @return true if peripheral is busy
  */
 bool led_strip_busy(led_strip_t *strip);
 
 /**
- * @brief Wait until RMT peripherals is free to send buffer to LEDs
+ * @brief Wait until peripheral is free to send buffer to LEDs
  *
  * @param strip Descriptor of LED strip
  * @param timeout Timeout in RTOS ticks
@@ -124,6 +268,15 @@ bool led_strip_busy(led_strip_t *strip);
  */
 esp_err_t led_strip_wait(led_strip_t *strip, TickType_t timeout);
 
+/**
+ * @brief Copy the strip buffer with the channels of every LED in R, G, B(, W) order
+ *
+ * @param strip Descriptor of LED strip
+ * @param[out] out `length` * 3 bytes, 4 for RGBW strips
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_read_rgb(const led_strip_t *strip, uint8_t *out);
+
 /**
  * @brief Set color of single LED in strip
  *
@@ -151,6 +304,63 @@ esp_err_t led_strip_set_pixel(led_strip_t *strip, size_t num, rgb_t color);
  */
 esp_err_t led_strip_set_pixels(led_strip_t *strip, size_t start, size_t len, rgb_t *data);
 
+/**
+ * @brief Set colors of multiple LEDs from a padded RGBX framebuffer
+ *
+ * Converts the framebuffer to the wire color order of the strip in one pass.
+ * This function does not actually change colors of the LEDs.
+ * Call ::led_strip_flush() to send buffer to the LEDs.
+ *
+ * @param strip Descriptor of LED strip
+ * @param start First LED index, 0-based
+ * @param len Number of LEDs
+ * @param data Pointer to RGBX data
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_set_pixels_rgbx(led_strip_t *strip, size_t start, size_t len, const rgbx_t *data);
+
+/**
+ * @brief Convert RGB color to the wire order of the strip
+ *
+ * For RGBW strips the white channel is extracted as ::led_strip_set_pixel()
+ * does, following the strip's `white_mode` and `white_point`: luma with RGB
+ * unchanged, or the common part of R, G and B moved to the white LED. It is
+ * computed here only, not per write.
+ *
+ * @param strip Descriptor of LED strip
+ * @param color RGB color
+ * @param[out] out Wire color
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_color(const led_strip_t *strip, rgb_t color, led_strip_color_t *out);
+
+/**
+ * @brief Set single LED to a wire color
+ *
+ * This function does not actually change colors of the LEDs.
+ * Call ::led_strip_flush() to send buffer to the LEDs.
+ *
+ * @param strip Descriptor of LED strip
+ * @param num LED number, 0..strip length - 1
+ * @param color Wire color
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_set_color(led_strip_t *strip, size_t num, led_strip_color_t color);
+
+/**
+ * @brief Set multiple LEDs to a wire color
+ *
+ * This function does not actually change colors of the LEDs.
+ * Call ::led_strip_flush() to send buffer to the LEDs.
+ *
+ * @param strip Descriptor of LED strip
+ * @param start First LED index, 0-based
+ * @param len Number of LEDs
+ * @param color Wire color
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_fill_color(led_strip_t *strip, size_t start, size_t len, led_strip_color_t color);
+
 /**
  * @brief Set multiple LEDs to the one color
  *
@@ -165,6 +375,79 @@ esp_err_t led_strip_set_pixels(led_strip_t *strip, size_t start, size_t len, rgb
  */
 esp_err_t led_strip_fill(led_strip_t *strip, size_t start, size_t len, rgb_t color);
 
+/**
+ * @brief Initialize segment descriptor
+ *
+ * @param seg Segment descriptor
+ * @param strip Initialized LED strip
+ * @param offset First LED of the stretch on the strip
+ * @param length Number of LEDs in segment, must be a multiple of
+ *               `serpentine_width` if that is not 0
+ * @param reversed Segment runs from the end of the stretch to its start
+ * @param serpentine_width Zig-zag row length, 0 for a straight stretch
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_segment_init(led_strip_segment_t *seg, led_strip_t *strip, size_t offset, size_t length,
+                                 bool reversed, size_t serpentine_width);
+
+/**
+ * @brief Set color of single LED in segment
+ *
+ * This function does not actually change colors of the LEDs.
+ * Call ::led_strip_flush() to send buffer to the LEDs.
+ *
+ * @param seg Segment descriptor
+ * @param num LED number, 0..segment length - 1
+ * @param color RGB color
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_segment_set_pixel(led_strip_segment_t *seg, size_t num, rgb_t color);
+
+/**
+ * @brief Set multiple LEDs of segment to the one color
+ *
+ * The range is checked once, then written as contiguous runs of the
+ * strip buffer.
+ * This function does not actually change colors of the LEDs.
+ * Call ::led_strip_flush() to send buffer to the LEDs.
+ *
+ * @param seg Segment descriptor
+ * @param start First LED index in segment, 0-based
+ * @param len Number of LEDs
+ * @param color RGB color
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_segment_fill(led_strip_segment_t *seg, size_t start, size_t len, rgb_t color);
+
+/**
+ * @brief Set multiple LEDs of segment to a wire color
+ *
+ * Same as ::led_strip_segment_fill() without any color conversion.
+ *
+ * @param seg Segment descriptor
+ * @param start First LED index in segment, 0-based
+ * @param len Number of LEDs
+ * @param color Wire color
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_segment_fill_color(led_strip_segment_t *seg, size_t start, size_t len, led_strip_color_t color);
+
+/**
+ * @brief Copy RGB data to multiple LEDs of segment
+ *
+ * The range is checked once, then written as contiguous runs of the
+ * strip buffer in the direction of the segment.
+ * This function does not actually change colors of the LEDs.
+ * Call ::led_strip_flush() to send buffer to the LEDs.
+ *
+ * @param seg Segment descriptor
+ * @param start First LED index in segment, 0-based
+ * @param len Number of LEDs
+ * @param data Pointer to RGB data, `len` pixels
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_segment_blit(led_strip_segment_t *seg, size_t start, size_t len, const rgb_t *data);
+
 #ifdef __cplusplus
 }
 #endif
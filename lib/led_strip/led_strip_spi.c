@@ -0,0 +1,201 @@
+/**
+ * @file led_strip_spi.c
+ *
+ * SPI/DMA backend of led_strip
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#include "led_strip_spi.h"
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <stdlib.h>
+#include <string.h>
+#include <driver/spi_master.h>
+#include <lib8tion.h>
+
+static const char *TAG = "led_strip_spi";
+
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+#define COLOR_SIZE(strip) (3 + ((strip)->is_rgbw != 0))
+
+typedef struct
+{
+    led_strip_spi_code_t code;
+    spi_device_handle_t dev;
+    spi_transaction_t trans;
+    uint8_t *dma_buf;
+    size_t size;  // Encoded frame plus reset zeros
+    bool pending; // Transfer queued, result not fetched yet
+} spi_state_t;
+
+esp_err_t led_strip_spi_code_init(led_strip_spi_code_t *code, uint8_t bits, uint32_t bit_ns, uint32_t t1h_ns)
+{
+    CHECK_ARG(code && (bits == 3 || bits == 4) && bit_ns);
+
+    // SPI clock is APB divided by an integer, the LED bit ends up a bit longer
+    int hz = (int)((uint64_t)bits * 1000000000ULL / bit_ns);
+    code->clock_hz = spi_get_actual_clock(APB_CLK_FREQ, hz, 128);
+    code->unit_ns = 1000000000UL / code->clock_hz;
+    code->bits = bits;
+    code->t0h_units = 1;
+    uint32_t t1h = (t1h_ns + code->unit_ns / 2) / code->unit_ns;
+    code->t1h_units = t1h < 2 ? 2 : t1h > bits - 1 ? bits - 1 : t1h;
+
+    uint16_t bit0 = 1 << (bits - 1);
+    uint16_t bit1 = ((1 << code->t1h_units) - 1) << (bits - code->t1h_units);
+    for (int n = 0; n < 16; n++)
+    {
+        uint16_t v = 0;
+        for (int i = 3; i >= 0; i--)
+            v = (v << bits) | (n & (1 << i) ? bit1 : bit0);
+        code->lut[n] = v;
+    }
+    return ESP_OK;
+}
+
+static inline void encode_byte(const led_strip_spi_code_t *code, uint8_t v, uint8_t *dst, uint8_t brightness)
+{
+    uint8_t b = brightness != 255 ? scale8_video(v, brightness) : v;
+    if (code->bits == 4)
+    {
+        uint16_t hi = code->lut[b >> 4], lo = code->lut[b & 0x0f];
+        dst[0] = hi >> 8;
+        dst[1] = hi;
+        dst[2] = lo >> 8;
+        dst[3] = lo;
+    }
+    else
+    {
+        uint32_t w = ((uint32_t)code->lut[b >> 4] << 12) | code->lut[b & 0x0f];
+        dst[0] = w >> 16;
+        dst[1] = w >> 8;
+        dst[2] = w;
+    }
+}
+
+void led_strip_spi_encode(const led_strip_spi_code_t *code, const uint8_t *src, size_t len, uint8_t *dst,
+                          uint8_t brightness, const uint8_t *map, size_t size)
+{
+    size_t bits = code->bits;
+    if (!map)
+    {
+        for (size_t i = 0; i < len; i++, dst += bits)
+            encode_byte(code, src[i], dst, brightness);
+        return;
+    }
+    // Whole LEDs, channels picked in wire order
+    for (size_t i = 0; i + size <= len; i += size)
+        for (size_t ch = 0; ch < size; ch++, dst += bits)
+            encode_byte(code, src[i + map[ch]], dst, brightness);
+}
+
+esp_err_t led_strip_spi_init(led_strip_t *strip, const led_strip_spi_code_t *code, uint32_t reset_us)
+{
+    CHECK_ARG(strip && strip->buf && code);
+
+    spi_state_t *spi = calloc(1, sizeof(spi_state_t));
+    if (!spi)
+    {
+        ESP_LOGE(TAG, "Not enough memory");
+        return ESP_ERR_NO_MEM;
+    }
+    spi->code = *code;
+
+    // Line stays low after the trailing zeros, so the reset period needs no waiting
+    size_t reset_bytes = ((uint64_t)reset_us * 1000 / code->unit_ns + 7) / 8;
+    spi->size = strip->length * COLOR_SIZE(strip) * code->bits + reset_bytes;
+    spi->dma_buf = heap_caps_calloc(1, spi->size, MALLOC_CAP_DMA);
+    if (!spi->dma_buf)
+    {
+        ESP_LOGE(TAG, "Not enough DMA memory for %d bytes", (int)spi->size);
+        free(spi);
+        return ESP_ERR_NO_MEM;
+    }
+
+    spi_bus_config_t bus = {
+        .mosi_io_num = strip->gpio,
+        .miso_io_num = -1,
+        .sclk_io_num = -1,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = spi->size,
+    };
+    spi_device_interface_config_t dev = {
+        .clock_speed_hz = code->clock_hz,
+        .mode = 0,
+        .spics_io_num = -1,
+        .queue_size = 1,
+    };
+    esp_err_t r = spi_bus_initialize(strip->spi_host, &bus, SPI_DMA_CH_AUTO);
+    if (r == ESP_OK)
+    {
+        r = spi_bus_add_device(strip->spi_host, &dev, &spi->dev);
+        if (r != ESP_OK)
+            spi_bus_free(strip->spi_host);
+    }
+    if (r != ESP_OK)
+    {
+        ESP_LOGE(TAG, "SPI setup failed: %d", r);
+        free(spi->dma_buf);
+        free(spi);
+        return r;
+    }
+
+    strip->spi = spi;
+    ESP_LOGD(TAG, "%d Hz, %d SPI bits per bit, %d bytes DMA", (int)code->clock_hz, code->bits, (int)spi->size);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_spi_free(led_strip_t *strip)
+{
+    CHECK_ARG(strip && strip->spi);
+
+    spi_state_t *spi = strip->spi;
+    CHECK(led_strip_spi_wait(strip, portMAX_DELAY));
+    CHECK(spi_bus_remove_device(spi->dev));
+    CHECK(spi_bus_free(strip->spi_host));
+    free(spi->dma_buf);
+    free(spi);
+    strip->spi = NULL;
+
+    return ESP_OK;
+}
+
+esp_err_t led_strip_spi_wait(led_strip_t *strip, TickType_t timeout)
+{
+    CHECK_ARG(strip && strip->spi);
+
+    spi_state_t *spi = strip->spi;
+    if (spi->pending)
+    {
+        spi_transaction_t *done;
+        CHECK(spi_device_get_trans_result(spi->dev, &done, timeout));
+        spi->pending = false;
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_spi_flush(led_strip_t *strip, TickType_t timeout)
+{
+    CHECK(led_strip_spi_wait(strip, timeout));
+
+    spi_state_t *spi = strip->spi;
+#ifdef LED_STRIP_BRIGHTNESS
+    uint8_t brightness = strip->brightness;
+#else
+    uint8_t brightness = 255;
+#endif
+    // Reset zeros at the end of the DMA buffer are never overwritten
+    led_strip_spi_encode(&spi->code, strip->buf, strip->length * COLOR_SIZE(strip), spi->dma_buf, brightness,
+                         strip->rgb_buf ? strip->buf_map : NULL, COLOR_SIZE(strip));
+
+    memset(&spi->trans, 0, sizeof(spi->trans));
+    spi->trans.length = spi->size * 8;
+    spi->trans.tx_buffer = spi->dma_buf;
+    CHECK(spi_device_queue_trans(spi->dev, &spi->trans, 0));
+    spi->pending = true;
+
+    return ESP_OK;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file led_strip_spi.h
+ *
+ * SPI/DMA backend of led_strip, internal to the component
+ *
+ * Every bit of the strip buffer is sent as 3 or 4 SPI bits: a run of ones
+ * for the high time followed by zeros, e.g. 100/110 or 1000/1110. The SPI
+ * clock is chosen so that the SPI bits add up to the bit period of the LED
+ * type. The encoded frame and the zeros of the reset period are streamed
+ * from one DMA buffer without any CPU work during transfer.
+ *
+ * MIT Licensed as described in the file LICENSE
+ */
+#ifndef __LED_STRIP_SPI_H__
+#define __LED_STRIP_SPI_H__
+
+#include "led_strip.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Encoding of LED bits into SPI bits
+ */
+typedef struct
+{
+    uint8_t bits;      ///< SPI bits per LED bit, 3 or 4
+    uint8_t t0h_units; ///< SPI bits high for a 0 bit
+    uint8_t t1h_units; ///< SPI bits high for a 1 bit
+    uint32_t clock_hz; ///< Actual SPI clock
+    uint32_t unit_ns;  ///< Time of one SPI bit
+    uint16_t lut[16];  ///< SPI bits of every nibble, 4 * `bits` wide, MSB first
+} led_strip_spi_code_t;
+
+/**
+ * @brief Build encoding for a LED bit period
+ *
+ * @param code Encoding to fill
+ * @param bits SPI bits per LED bit, 3 or 4
+ * @param bit_ns Nominal LED bit period
+ * @param t1h_ns Nominal high time of a 1 bit
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_spi_code_init(led_strip_spi_code_t *code, uint8_t bits, uint32_t bit_ns, uint32_t t1h_ns);
+
+/**
+ * @brief Encode bytes into SPI bits
+ *
+ * @param code Encoding
+ * @param src Bytes in wire order
+ * @param len Number of bytes
+ * @param dst Output, `len * code->bits` bytes
+ * @param brightness Brightness applied to every byte, 255 for none
+ * @param map NULL if `src` is in wire order, otherwise the `src` byte of
+ *            each wire channel within an LED (`led_strip_t::buf_map`)
+ * @param size Bytes per LED, used with `map`
+ */
+void led_strip_spi_encode(const led_strip_spi_code_t *code, const uint8_t *src, size_t len, uint8_t *dst,
+                          uint8_t brightness, const uint8_t *map, size_t size);
+
+/**
+ * @brief Set up SPI bus, device and DMA buffer of the strip
+ *
+ * `strip->buf` must be allocated.
+ *
+ * @param strip Descriptor of LED strip
+ * @param code Encoding for the strip type
+ * @param reset_us Reset time, sent as zeros after every frame
+ * @return `ESP_OK` on success
+ */
+esp_err_t led_strip_spi_init(led_strip_t *strip, const led_strip_spi_code_t *code, uint32_t reset_us);
+
+/**
+ * @brief Release SPI device, bus and DMA buffer of the strip
+ */
+esp_err_t led_strip_spi_free(led_strip_t *strip);
+
+/**
+ * @brief Encode strip buffer and start the transfer
+ *
+ * @param strip Descriptor of LED strip
+ * @param timeout Time to wait for the previous transfer, 0 to fail at once
+ * @return `ESP_OK` on success, `ESP_ERR_TIMEOUT` if the previous transfer
+ *         did not finish in time
+ */
+esp_err_t led_strip_spi_flush(led_strip_t *strip, TickType_t timeout);
+
+/**
+ * @brief Wait for the current transfer, including the reset period
+ *
+ * @return `ESP_OK` when idle, `ESP_ERR_TIMEOUT` otherwise
+ */
+esp_err_t led_strip_spi_wait(led_strip_t *strip, TickType_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LED_STRIP_SPI_H__ */
@@ -1,3 +1,109 @@
 #include "lib8tion.h"
 
 uint16_t rand16seed;
+
+// splitmix32, used to spread a seed over the whole generator state
+static uint32_t random_splitmix32(uint32_t *x)
+{
+    uint32_t z = (*x += 0x9e3779b9);
+    z = (z ^ (z >> 16)) * 0x85ebca6b;
+    z = (z ^ (z >> 13)) * 0xc2b2ae35;
+    return z ^ (z >> 16);
+}
+
+void random_state_init(random_state_t *state, uint32_t seed, uint32_t stream)
+{
+    // Streams start from unrelated points of the sequence: the stream number
+    // is hashed into the splitmix input, so neighbouring streams and seeds
+    // do not share any state words
+    uint32_t h = stream;
+    uint32_t x = seed ^ random_splitmix32(&h);
+    for (int i = 0; i < 4; i++)
+        state->s[i] = random_splitmix32(&x);
+    // all-zero is the one invalid state
+    if (!(state->s[0] | state->s[1] | state->s[2] | state->s[3]))
+        state->s[0] = 1;
+}
+
+void fill_random8(random_state_t *state, uint8_t *buf, size_t num)
+{
+    // Most significant byte first, so buf[4 * k] is what the k-th
+    // random8_r() would return, on any byte order
+    size_t i = 0;
+    for (; i + 4 <= num; i += 4)
+    {
+        uint32_t r = random32_r(state);
+        buf[i] = r >> 24;
+        buf[i + 1] = r >> 16;
+        buf[i + 2] = r >> 8;
+        buf[i + 3] = r;
+    }
+    if (i < num)
+    {
+        uint32_t r = random32_r(state);
+        for (; i < num; i++, r <<= 8)
+            buf[i] = r >> 24;
+    }
+}
+
+// Tables are generated from sin8() and quadwave8(), so the table-driven
+// variants return exactly the same values.
+
+const uint8_t sin8_table[256] = {
+    128, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 161, 164, 167, 170, 173,
+    177, 179, 182, 184, 187, 189, 192, 194, 197, 200, 202, 205, 207, 210, 212, 215,
+    218, 219, 221, 223, 224, 226, 228, 229, 231, 233, 234, 236, 238, 239, 241, 243,
+    245, 245, 246, 246, 247, 248, 248, 249, 250, 250, 251, 251, 252, 253, 253, 254,
+    255, 254, 253, 253, 252, 251, 251, 250, 250, 249, 248, 248, 247, 246, 246, 245,
+    245, 243, 241, 239, 238, 236, 234, 233, 231, 229, 228, 226, 224, 223, 221, 219,
+    218, 215, 212, 210, 207, 205, 202, 200, 197, 194, 192, 189, 187, 184, 182, 179,
+    177, 173, 170, 167, 164, 161, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131,
+    128, 125, 122, 119, 116, 113, 110, 107, 104, 101,  98,  95,  92,  89,  86,  83,
+     79,  77,  74,  72,  69,  67,  64,  62,  59,  56,  54,  51,  49,  46,  44,  41,
+     38,  37,  35,  33,  32,  30,  28,  27,  25,  23,  22,  20,  18,  17,  15,  13,
+     11,  11,  10,  10,   9,   8,   8,   7,   6,   6,   5,   5,   4,   3,   3,   2,
+      1,   2,   3,   3,   4,   5,   5,   6,   6,   7,   8,   8,   9,  10,  10,  11,
+     11,  13,  15,  17,  18,  20,  22,  23,  25,  27,  28,  30,  32,  33,  35,  37,
+     38,  41,  44,  46,  49,  51,  54,  56,  59,  62,  64,  67,  69,  72,  74,  77,
+     79,  83,  86,  89,  92,  95,  98, 101, 104, 107, 110, 113, 116, 119, 122, 125,
+};
+
+const uint8_t quadwave8_table[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   2,   2,   2,   2,   4,   4,   6,   6,
+      8,   8,  10,  10,  12,  14,  14,  16,  18,  18,  20,  22,  24,  26,  28,  30,
+     32,  34,  36,  38,  40,  42,  44,  48,  50,  52,  54,  58,  60,  62,  66,  68,
+     72,  74,  78,  82,  84,  88,  90,  94,  98, 102, 106, 108, 112, 116, 120, 124,
+    129, 133, 137, 141, 145, 149, 151, 155, 159, 163, 165, 169, 173, 175, 179, 181,
+    185, 187, 191, 193, 197, 199, 201, 205, 207, 209, 211, 213, 217, 219, 221, 223,
+    225, 227, 229, 231, 231, 233, 235, 237, 239, 239, 241, 243, 243, 245, 247, 247,
+    249, 249, 251, 251, 251, 253, 253, 253, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 253, 253, 253, 251, 251, 251, 249, 249,
+    247, 247, 245, 243, 243, 241, 239, 239, 237, 235, 233, 231, 231, 229, 227, 225,
+    223, 221, 219, 217, 213, 211, 209, 207, 205, 201, 199, 197, 193, 191, 187, 185,
+    181, 179, 175, 173, 169, 165, 163, 159, 155, 151, 149, 145, 141, 137, 133, 129,
+    124, 120, 116, 112, 108, 106, 102,  98,  94,  90,  88,  84,  82,  78,  74,  72,
+     68,  66,  62,  60,  58,  54,  52,  50,  48,  44,  42,  40,  38,  36,  34,  32,
+     30,  28,  26,  24,  22,  20,  18,  18,  16,  14,  14,  12,  10,  10,   8,   8,
+      6,   6,   4,   4,   2,   2,   2,   2,   0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+void fill_sin8(uint8_t *out, size_t num, uint8_t phase, uint8_t step)
+{
+    for (size_t i = 0; i < num; ++i, phase += step)
+        out[i] = sin8_table[phase];
+}
+
+void fill_quadwave8(uint8_t *out, size_t num, uint8_t phase, uint8_t step)
+{
+    for (size_t i = 0; i < num; ++i, phase += step)
+        out[i] = quadwave8_table[phase];
+}
+
+void fill_beatsin8(uint8_t *out, size_t num, accum88 beats_per_minute, uint8_t lowest, uint8_t highest,
+        uint32_t timebase, uint8_t phase_offset, uint8_t phase_step)
+{
+    uint8_t phase = beat8(beats_per_minute, timebase) + phase_offset;
+    uint8_t rangewidth = highest - lowest;
+    for (size_t i = 0; i < num; ++i, phase += phase_step)
+        out[i] = lowest + scale8(sin8_table[phase], rangewidth);
+}
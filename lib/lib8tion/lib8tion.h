@@ -55,6 +55,13 @@
  random16_set_seed(k)    ==  seed = k
  random16_add_entropy(k) ==  seed += k
 
+ The same functions with a '_r' suffix take an explicit
+ random_state_t, for independent, reproducible streams
+ (one per task, per match, ...):
+ random_state_init(&st, seed, stream)
+ random8_r(&st), random16_r(&st), random32_r(&st)
+ fill_random8(&st, buf, n)
+
 
  - Absolute value of a signed 8-bit value.
  abs8(i)     == abs(i)
@@ -151,6 +158,7 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <esp_timer.h>
 
@@ -691,6 +699,12 @@ LIB8STATIC uint8_t beatsin8(accum88 beats_per_minute, uint8_t lowest, uint8_t hi
     return result;
 }
 
+/// fill_beatsin8 fills an array with beatsin8() values whose phase advances
+///           by 'phase_step' per element, e.g. a sine wave travelling
+///           along the strip. The beat is sampled once for the whole array.
+void fill_beatsin8(uint8_t *out, size_t num, accum88 beats_per_minute, uint8_t lowest, uint8_t highest,
+        uint32_t timebase, uint8_t phase_offset, uint8_t phase_step);
+
 /// Return the current seconds since boot in a 16-bit value.  Used as part of the
 /// "every N time-periods" mechanism
 LIB8STATIC uint16_t seconds16()
@@ -113,6 +113,98 @@ LIB8STATIC void random16_add_entropy(uint16_t entropy)
     rand16seed += entropy;
 }
 
+///////////////////////////////////////////////////////////////////////
+
+// Random generators with explicit state
+//        Same API as above with a '_r' suffix, working on a caller-owned
+//        state instead of the global seed. Use one state per task (or per
+//        match, per simulated court, ...) for thread-safe, reproducible
+//        streams.
+//
+//        The generator is xoshiro128** (period 2^128 - 1), 32 bits per step.
+
+/// Random generator state
+typedef struct
+{
+    uint32_t s[4];
+} random_state_t;
+
+/// Initialize state from a seed and a stream number.
+/// Different streams for the same seed give independent sequences, e.g.
+/// one stream per worker task.
+void random_state_init(random_state_t *state, uint32_t seed, uint32_t stream);
+
+/// Fill buffer with random bytes, 4 bytes per generator step: the bytes of
+/// random32_r(), most significant first. Byte 4 * k equals the k-th
+/// random8_r() from the same state, and the state advances as by
+/// (num + 3) / 4 calls.
+void fill_random8(random_state_t *state, uint8_t *buf, size_t num);
+
+LIB8STATIC_ALWAYS_INLINE uint32_t random_rotl32(uint32_t x, int k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+
+/// Generate a 32-bit random number
+LIB8STATIC uint32_t random32_r(random_state_t *state)
+{
+    uint32_t *s = state->s;
+    uint32_t result = random_rotl32(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = random_rotl32(s[3], 11);
+
+    return result;
+}
+
+/// Generate an 8-bit random number
+LIB8STATIC uint8_t random8_r(random_state_t *state)
+{
+    // high bits are the best ones
+    return random32_r(state) >> 24;
+}
+
+/// Generate a 16 bit random number
+LIB8STATIC uint16_t random16_r(random_state_t *state)
+{
+    return random32_r(state) >> 16;
+}
+
+/// Generate an 8-bit random number between 0 and lim
+/// @param lim the upper bound for the result
+LIB8STATIC uint8_t random8_to_r(random_state_t *state, uint8_t lim)
+{
+    return (random8_r(state) * lim) >> 8;
+}
+
+/// Generate an 8-bit random number in the given range
+/// @param min the lower bound for the random number
+/// @param lim the upper bound for the random number
+LIB8STATIC uint8_t random8_between_r(random_state_t *state, uint8_t min, uint8_t lim)
+{
+    return random8_to_r(state, lim - min) + min;
+}
+
+/// Generate an 16-bit random number between 0 and lim
+/// @param lim the upper bound for the result
+LIB8STATIC uint16_t random16_to_r(random_state_t *state, uint16_t lim)
+{
+    return ((uint32_t)lim * random16_r(state)) >> 16;
+}
+
+/// Generate an 16-bit random number in the given range
+/// @param min the lower bound for the random number
+/// @param lim the upper bound for the random number
+LIB8STATIC uint16_t random16_between_r(random_state_t *state, uint16_t min, uint16_t lim)
+{
+    return random16_to_r(state, lim - min) + min;
+}
+
 ///@}
 
 #endif
@@ -150,5 +150,40 @@ LIB8STATIC uint8_t cos8(uint8_t theta)
     return sin8(theta + 64);
 }
 
+///////////////////////////////////////////////////////////////////////
+
+// Table-driven sin8/cos8
+//        Same results as sin8() and cos8(), one table read per call.
+//        Batch evaluators fill a whole array with a wave, e.g. one
+//        value per LED: out[i] = sin8(phase + i * step)
+
+/// sin8() for every possible input angle
+extern const uint8_t sin8_table[256];
+
+/// quadwave8() for every possible input
+extern const uint8_t quadwave8_table[256];
+
+/// Table-driven sin8(), returns exactly the same values
+/// @param theta input angle from 0-255
+/// @returns sin of theta, value between 0 and 255
+LIB8STATIC_ALWAYS_INLINE uint8_t sin8_lut(uint8_t theta)
+{
+    return sin8_table[theta];
+}
+
+/// Table-driven cos8(), returns exactly the same values
+/// @param theta input angle from 0-255
+/// @returns cos of theta, value between 0 and 255
+LIB8STATIC_ALWAYS_INLINE uint8_t cos8_lut(uint8_t theta)
+{
+    return sin8_table[(uint8_t)(theta + 64)];
+}
+
+/// Fill array with sin8(phase + i * step)
+void fill_sin8(uint8_t *out, size_t num, uint8_t phase, uint8_t step);
+
+/// Fill array with quadwave8(phase + i * step)
+void fill_quadwave8(uint8_t *out, size_t num, uint8_t phase, uint8_t step);
+
 ///@}
 #endif
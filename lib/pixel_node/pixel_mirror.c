@@ -0,0 +1,354 @@
+/**
+ * @file pixel_mirror.c
+ *
+ * DDP sender that mirrors every flushed frame of a strip to remote LED nodes
+ */
+#include "pixel_mirror.h"
+#include "pixel_node_ddp.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <esp_log.h>
+#ifdef ESP_PLATFORM
+#include <esp_timer.h>
+#endif
+
+static const char *TAG = "pixel_mirror";
+
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+#define COLOR_SIZE(strip) (3 + ((strip)->is_rgbw != 0))
+
+#define DEFAULT_KEYFRAME_MS 1000
+#define MERGE_GAP 64           // Unchanged bytes cheaper to send along than to start another packet for
+#define TASK_STACK 3072
+#define TASK_PRIORITY 3        // Below the task that flushes
+
+#ifdef ESP_PLATFORM
+
+static inline bool lock(pixel_mirror_t *m, bool wait)
+{
+    return xSemaphoreTake(m->lock, wait ? portMAX_DELAY : 0) == pdTRUE;
+}
+
+static inline void unlock(pixel_mirror_t *m)
+{
+    xSemaphoreGive(m->lock);
+}
+
+static void mirror_task(void *arg)
+{
+    pixel_mirror_t *m = arg;
+    int64_t wait_us = -1;
+    while (true)
+    {
+        TickType_t ticks = portMAX_DELAY;
+        if (wait_us >= 0)
+        {
+            ticks = pdMS_TO_TICKS((wait_us + 999) / 1000);
+            if (!ticks)
+                ticks = 1;
+        }
+        ulTaskNotifyTake(pdTRUE, ticks);
+        pixel_mirror_send(m, esp_timer_get_time(), &wait_us);
+    }
+}
+
+#else
+
+static inline bool lock(pixel_mirror_t *m, bool wait)
+{
+    return true;
+}
+
+static inline void unlock(pixel_mirror_t *m)
+{
+}
+
+#endif
+
+static void flush_hook(void *arg)
+{
+    pixel_mirror_submit(arg);
+}
+
+static void free_buffers(pixel_mirror_t *m)
+{
+    free(m->ready);
+    free(m->work);
+    free(m->sent);
+    m->ready = m->work = m->sent = NULL;
+}
+
+esp_err_t pixel_mirror_init(pixel_mirror_t *mirror, led_strip_t *strip, const pixel_mirror_config_t *config)
+{
+    CHECK_ARG(mirror && strip && strip->buf && config && config->peers[0]);
+
+    memset(mirror, 0, sizeof(pixel_mirror_t));
+    mirror->strip = strip;
+    mirror->sock = -1;
+    mirror->size = strip->length * COLOR_SIZE(strip);
+    mirror->min_interval_us = config->max_fps ? 1000000 / config->max_fps : 0;
+    mirror->keyframe_us = (int64_t)(config->keyframe_ms ? config->keyframe_ms : DEFAULT_KEYFRAME_MS) * 1000;
+    mirror->keyframe = true;
+
+    uint16_t port = config->port ? config->port : 4048;
+    for (size_t i = 0; i < PIXEL_MIRROR_MAX_PEERS && config->peers[i]; i++)
+    {
+        struct sockaddr_in *peer = &mirror->peers[mirror->num_peers++];
+        peer->sin_family = AF_INET;
+        peer->sin_port = htons(port);
+        if (inet_pton(AF_INET, config->peers[i], &peer->sin_addr) != 1)
+        {
+            ESP_LOGE(TAG, "Bad peer address %s", config->peers[i]);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    mirror->ready = calloc(1, mirror->size);
+    mirror->work = calloc(1, mirror->size);
+    mirror->sent = calloc(1, mirror->size);
+    if (!mirror->ready || !mirror->work || !mirror->sent)
+    {
+        ESP_LOGE(TAG, "Not enough memory");
+        free_buffers(mirror);
+        return ESP_ERR_NO_MEM;
+    }
+
+    mirror->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (mirror->sock < 0)
+    {
+        ESP_LOGE(TAG, "socket() failed");
+        free_buffers(mirror);
+        return ESP_FAIL;
+    }
+    fcntl(mirror->sock, F_SETFL, fcntl(mirror->sock, F_GETFL, 0) | O_NONBLOCK);
+
+#ifdef ESP_PLATFORM
+    mirror->lock = xSemaphoreCreateMutex();
+    if (!mirror->lock || xTaskCreate(mirror_task, "pixel_mirror", TASK_STACK, mirror, TASK_PRIORITY,
+                                     &mirror->task) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Not enough memory");
+        if (mirror->lock)
+            vSemaphoreDelete(mirror->lock);
+        close(mirror->sock);
+        mirror->sock = -1;
+        free_buffers(mirror);
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+
+    strip->flush_arg = mirror;
+    strip->flush_cb = flush_hook;
+    ESP_LOGI(TAG, "Mirroring %d LEDs to %d peers on port %d", (int)strip->length, (int)mirror->num_peers, port);
+    return ESP_OK;
+}
+
+esp_err_t pixel_mirror_free(pixel_mirror_t *mirror)
+{
+    CHECK_ARG(mirror && mirror->sock >= 0);
+
+    mirror->strip->flush_cb = NULL;
+    mirror->strip->flush_arg = NULL;
+#ifdef ESP_PLATFORM
+    lock(mirror, true); // The task never holds the lock while it is deleted
+    vTaskDelete(mirror->task);
+    vSemaphoreDelete(mirror->lock);
+#endif
+    close(mirror->sock);
+    mirror->sock = -1;
+    free_buffers(mirror);
+    return ESP_OK;
+}
+
+void pixel_mirror_submit(pixel_mirror_t *mirror)
+{
+    mirror->stats.submitted++;
+    if (!lock(mirror, false))
+    {
+        mirror->stats.dropped++; // The task is taking the previous frame
+        return;
+    }
+    if (mirror->has_ready)
+        mirror->stats.dropped++;
+    led_strip_read_rgb(mirror->strip, mirror->ready);
+    mirror->has_ready = true;
+    unlock(mirror);
+#ifdef ESP_PLATFORM
+    xTaskNotifyGive(mirror->task);
+#endif
+}
+
+void pixel_mirror_reset_stats(pixel_mirror_t *mirror)
+{
+    if (mirror)
+        memset(&mirror->stats, 0, sizeof(mirror->stats));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Next byte range of 'frame' to send at or after 'pos', false if none. In
+// full frames that is the next DDP_MAX_DATA bytes, otherwise the whole LEDs
+// from the next change up to the last change before MERGE_GAP unchanged
+// bytes (or DDP_MAX_DATA bytes).
+static bool next_range(const pixel_mirror_t *m, const uint8_t *frame, bool full, size_t pos, size_t *start,
+                       size_t *end)
+{
+    size_t size = m->size;
+    size_t led = COLOR_SIZE(m->strip);
+    if (!full)
+    {
+        while (pos < size && frame[pos] == m->sent[pos])
+            pos++;
+        pos -= pos % led;
+    }
+    if (pos >= size)
+        return false;
+
+    size_t limit = size - pos > DDP_MAX_DATA ? pos + DDP_MAX_DATA : size;
+    *start = pos;
+    if (full)
+    {
+        *end = limit;
+        return true;
+    }
+    size_t last = pos;
+    for (size_t i = pos; i < limit && i - last < MERGE_GAP; i++)
+    {
+        if (frame[i] != m->sent[i])
+            last = i + 1;
+    }
+    *end = last + (led - last % led) % led;
+    return true;
+}
+
+static esp_err_t send_range(pixel_mirror_t *m, const uint8_t *frame, size_t start, size_t end, bool push)
+{
+    size_t len = end - start;
+    uint8_t *h = m->header;
+    m->seq = m->seq % DDP_SEQ_MOD + 1;
+    h[0] = DDP_VERSION_1 | (push ? DDP_FLAG_PUSH : 0);
+    h[1] = m->seq;
+    h[2] = m->strip->is_rgbw ? DDP_TYPE_RGBW8 : DDP_TYPE_RGB8;
+    h[3] = DDP_ID_DISPLAY;
+    h[4] = start >> 24;
+    h[5] = start >> 16;
+    h[6] = start >> 8;
+    h[7] = start;
+    h[8] = len >> 8;
+    h[9] = len;
+
+    struct iovec iov[2] = {
+        { .iov_base = h, .iov_len = DDP_HEADER_LEN },
+        { .iov_base = (void *)(frame + start), .iov_len = len },
+    };
+    for (size_t i = 0; i < m->num_peers; i++)
+    {
+        struct msghdr msg = {
+            .msg_name = &m->peers[i],
+            .msg_namelen = sizeof(m->peers[i]),
+            .msg_iov = iov,
+            .msg_iovlen = 2,
+        };
+        if (sendmsg(m->sock, &msg, 0) != (ssize_t)(DDP_HEADER_LEN + len))
+            return ESP_FAIL;
+    }
+    m->stats.packets++;
+    m->stats.bytes += len;
+    return ESP_OK;
+}
+
+// Sends the ranges of 'frame', the last one with PUSH; 'sent' tells if
+// anything went out
+static esp_err_t send_frame(pixel_mirror_t *m, const uint8_t *frame, bool full, bool *sent)
+{
+    size_t start, end, next_start, next_end;
+    *sent = next_range(m, frame, full, 0, &start, &end);
+    if (!*sent)
+        return ESP_OK;
+    while (true)
+    {
+        bool more = next_range(m, frame, full, end, &next_start, &next_end);
+        CHECK(send_range(m, frame, start, end, !more));
+        if (!more)
+            return ESP_OK;
+        start = next_start;
+        end = next_end;
+    }
+}
+
+esp_err_t pixel_mirror_send(pixel_mirror_t *mirror, int64_t now_us, int64_t *wait_us)
+{
+    CHECK_ARG(mirror && mirror->sock >= 0);
+
+    pixel_mirror_t *m = mirror;
+    bool full = m->keyframe || now_us - m->last_key_us >= m->keyframe_us;
+    bool held = now_us - m->last_send_us < m->min_interval_us;
+    bool fresh = false;
+    if (!held)
+    {
+        lock(m, true);
+        fresh = m->has_ready;
+        if (fresh)
+        {
+            uint8_t *t = m->work;
+            m->work = m->ready;
+            m->ready = t;
+            m->has_ready = false;
+        }
+        unlock(m);
+    }
+
+    esp_err_t r = ESP_OK;
+    if (!held && (fresh || full))
+    {
+        // Without a new frame a due full frame repeats the last one
+        const uint8_t *frame = fresh ? m->work : m->sent;
+        bool sent;
+        r = send_frame(m, frame, full, &sent);
+        if (r != ESP_OK)
+        {
+            m->stats.errors++;
+            m->keyframe = true;
+        }
+        else
+        {
+            m->keyframe = false;
+            if (full)
+            {
+                m->last_key_us = now_us;
+                m->stats.keyframes++;
+            }
+        }
+        if (sent)
+        {
+            m->last_send_us = now_us;
+            m->stats.sent++;
+        }
+        if (fresh)
+        {
+            uint8_t *t = m->sent;
+            m->sent = m->work;
+            m->work = t;
+        }
+    }
+
+    if (wait_us)
+    {
+        int64_t wait = m->last_key_us + m->keyframe_us - now_us;
+        if (m->has_ready)
+        {
+            int64_t hold = m->last_send_us + m->min_interval_us - now_us;
+            if (hold < wait)
+                wait = hold;
+        }
+        *wait_us = wait < 0 ? 0 : wait;
+    }
+    return r;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file pixel_mirror.h
+ * @defgroup pixel_mirror pixel_mirror
+ * @{
+ *
+ * DDP sender that mirrors every flushed frame of a strip to remote LED nodes
+ *
+ * The mirror hooks into ::led_strip_flush() of the strip: each flushed frame
+ * is copied, in R, G, B(, W) order, into a single slot. A background task
+ * sends the slot to all peers, so flushing never waits for the network.
+ * While the task is busy or held back by the frame rate limit, newer frames
+ * replace the waiting one and the replaced frames are counted as dropped;
+ * nothing queues up.
+ *
+ * Frames are delta-encoded against the last frame sent: only the changed
+ * LEDs go out, with nearby changes batched into one packet and the last
+ * packet of a frame carrying the DDP PUSH flag. A full frame is sent
+ * periodically, and after a failed send, so receivers that joined late or
+ * lost packets catch up.
+ *
+ * Without `ESP_PLATFORM` (host builds) there is no task: call
+ * ::pixel_mirror_send() to send the waiting frame.
+ */
+#ifndef __PIXEL_MIRROR_H__
+#define __PIXEL_MIRROR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <netinet/in.h>
+#include <esp_err.h>
+#include <led_strip.h>
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIXEL_MIRROR_MAX_PEERS 4
+
+/**
+ * Mirror configuration
+ */
+typedef struct
+{
+    const char *peers[PIXEL_MIRROR_MAX_PEERS]; ///< IPv4 addresses of the receivers, unused entries NULL
+    uint16_t port;        ///< UDP port of the receivers, 0 for 4048
+    uint16_t max_fps;     ///< Frame rate limit, 0 for none
+    uint16_t keyframe_ms; ///< Longest time between full frames, 0 for 1000
+} pixel_mirror_config_t;
+
+/**
+ * Mirror statistics
+ */
+typedef struct
+{
+    uint32_t submitted;   ///< Frames flushed
+    uint32_t sent;        ///< Frames sent, full or delta
+    uint32_t keyframes;   ///< ... of them full frames
+    uint32_t dropped;     ///< Frames replaced by a newer one or flushed while the slot was locked
+    uint32_t packets;     ///< Packets sent to each peer
+    uint32_t bytes;       ///< Pixel bytes sent to each peer
+    uint32_t errors;      ///< Frames cut short by a failed send
+} pixel_mirror_stats_t;
+
+/**
+ * Mirror descriptor
+ */
+typedef struct
+{
+    led_strip_t *strip;
+    int sock;
+    struct sockaddr_in peers[PIXEL_MIRROR_MAX_PEERS];
+    size_t num_peers;
+    int64_t min_interval_us;   ///< From `max_fps`
+    int64_t keyframe_us;
+    size_t size;               ///< Frame bytes
+    uint8_t *ready;            ///< Latest flushed frame, waiting to be sent
+    uint8_t *work;             ///< Frame being sent
+    uint8_t *sent;             ///< Frame the peers have
+    bool has_ready;            ///< `ready` holds a frame
+    bool keyframe;             ///< Send the next frame in full
+    int64_t last_send_us;
+    int64_t last_key_us;
+    uint8_t seq;               ///< DDP sequence number of the last packet
+    uint8_t header[10];        ///< DDP header of the packet being sent
+#ifdef ESP_PLATFORM
+    SemaphoreHandle_t lock;    ///< Guards `ready` and `has_ready`
+    TaskHandle_t task;
+#endif
+    pixel_mirror_stats_t stats; ///< Statistics since init or ::pixel_mirror_reset_stats()
+} pixel_mirror_t;
+
+/**
+ * @brief Open the socket, start the sender task and hook into the strip
+ *
+ * Sets `flush_cb` of the strip.
+ *
+ * @param mirror Mirror descriptor
+ * @param strip Initialized LED strip
+ * @param config Configuration, at least one peer
+ * @return `ESP_OK` on success
+ */
+esp_err_t pixel_mirror_init(pixel_mirror_t *mirror, led_strip_t *strip, const pixel_mirror_config_t *config);
+
+/**
+ * @brief Unhook from the strip, stop the task and release everything
+ *
+ * @param mirror Mirror descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t pixel_mirror_free(pixel_mirror_t *mirror);
+
+/**
+ * @brief Take the current strip buffer as the next frame to send
+ *
+ * Called by the strip after every flush; never blocks.
+ *
+ * @param mirror Mirror descriptor
+ */
+void pixel_mirror_submit(pixel_mirror_t *mirror);
+
+/**
+ * @brief Send the waiting frame, or a full frame if one is due
+ *
+ * Runs in the sender task; call it directly in host builds.
+ *
+ * @param mirror Mirror descriptor
+ * @param now_us Current time
+ * @param[out] wait_us Time until a held-back frame or the next full frame
+ *             may be sent, may be NULL
+ * @return `ESP_OK` on success, also when nothing was due
+ */
+esp_err_t pixel_mirror_send(pixel_mirror_t *mirror, int64_t now_us, int64_t *wait_us);
+
+/**
+ * @brief Clear statistics
+ */
+void pixel_mirror_reset_stats(pixel_mirror_t *mirror);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __PIXEL_MIRROR_H__ */
@@ -0,0 +1,303 @@
+/**
+ * @file pixel_node.c
+ *
+ * E1.31 (sACN) and DDP network pixel receiver for led_strip
+ */
+#include "pixel_node.h"
+#include "pixel_node_ddp.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <esp_log.h>
+
+static const char *TAG = "pixel_node";
+
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+#define CHECK_ARG(VAL) do { if (!(VAL)) return ESP_ERR_INVALID_ARG; } while (0)
+
+#define COLOR_SIZE(strip) (3 + ((strip)->is_rgbw != 0))
+
+#define STRIP_TIMEOUT_MS 100   // Longest wait for the strip to finish sending
+
+// E1.31 offsets into the data packet (root, framing and DMP layer)
+#define E131_ROOT_VECTOR 18
+#define E131_FRAMING_VECTOR 40
+#define E131_SYNC_ADDRESS 109
+#define E131_SEQUENCE 111
+#define E131_OPTIONS 112
+#define E131_UNIVERSE 113
+#define E131_DMP_VECTOR 117
+#define E131_DMP_TYPE 118
+#define E131_VALUE_COUNT 123
+#define E131_START_CODE 125
+#define E131_HEADER_LEN 126
+// ... and into the synchronization packet
+#define E131_SYNC_ADDRESS_EXT 45
+#define E131_SYNC_LEN 49
+
+#define E131_VECTOR_ROOT_DATA 0x00000004
+#define E131_VECTOR_ROOT_EXTENDED 0x00000008
+#define E131_VECTOR_DATA_PACKET 0x00000002
+#define E131_VECTOR_SYNC 0x00000001
+#define E131_DMP_SET_PROPERTY 0x02
+#define E131_DMP_ADDRESS_TYPE 0xa1
+#define E131_OPTION_PREVIEW 0x40
+#define E131_OPTION_TERMINATED 0x20
+#define E131_SLOTS 512
+#define E131_LATE_WINDOW 20    // Sequence numbers this far behind are late, further back is a restart
+
+static const uint8_t e131_acn_id[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+static inline uint16_t be16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] << 8) | p[1];
+}
+
+static inline uint32_t be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline size_t buf_size(const pixel_node_t *node)
+{
+    return node->strip->length * COLOR_SIZE(node->strip);
+}
+
+// Bytes of one universe: whole LEDs in 512 slots
+static inline size_t universe_size(const pixel_node_t *node)
+{
+    return E131_SLOTS / COLOR_SIZE(node->strip) * COLOR_SIZE(node->strip);
+}
+
+static inline size_t num_universes(const pixel_node_t *node)
+{
+    size_t n = (buf_size(node) + universe_size(node) - 1) / universe_size(node);
+    return n > PIXEL_NODE_MAX_UNIVERSES ? PIXEL_NODE_MAX_UNIVERSES : n;
+}
+
+esp_err_t pixel_node_init(pixel_node_t *node, led_strip_t *strip, pixel_node_protocol_t protocol, uint16_t port,
+                          uint16_t universe)
+{
+    CHECK_ARG(node && strip && strip->buf);
+    CHECK_ARG(protocol == PIXEL_NODE_DDP || (protocol == PIXEL_NODE_E131 && universe >= 1 && universe <= 63999));
+
+    memset(node, 0, sizeof(pixel_node_t));
+    node->strip = strip;
+    node->protocol = protocol;
+    node->universe = universe;
+    if (!port)
+        port = protocol == PIXEL_NODE_DDP ? PIXEL_NODE_DDP_PORT : PIXEL_NODE_E131_PORT;
+    if (protocol == PIXEL_NODE_E131 && buf_size(node) > PIXEL_NODE_MAX_UNIVERSES * universe_size(node))
+        ESP_LOGW(TAG, "Strip needs more than %d universes, the rest stays dark", PIXEL_NODE_MAX_UNIVERSES);
+
+    node->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (node->sock < 0)
+    {
+        ESP_LOGE(TAG, "socket() failed");
+        return ESP_FAIL;
+    }
+    struct sockaddr_in local = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(node->sock, (struct sockaddr *)&local, sizeof(local)) < 0)
+    {
+        ESP_LOGE(TAG, "bind() to port %d failed", port);
+        close(node->sock);
+        node->sock = -1;
+        return ESP_FAIL;
+    }
+    fcntl(node->sock, F_SETFL, fcntl(node->sock, F_GETFL, 0) | O_NONBLOCK);
+
+    ESP_LOGI(TAG, "%s on port %d, %d LEDs", protocol == PIXEL_NODE_DDP ? "DDP" : "E1.31", port,
+             (int)strip->length);
+    return ESP_OK;
+}
+
+esp_err_t pixel_node_free(pixel_node_t *node)
+{
+    CHECK_ARG(node);
+
+    if (node->sock >= 0)
+        close(node->sock);
+    node->sock = -1;
+    return ESP_OK;
+}
+
+esp_err_t pixel_node_wait(pixel_node_t *node, uint32_t timeout_ms)
+{
+    CHECK_ARG(node && node->sock >= 0);
+
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(node->sock, &fds);
+    struct timeval tv = { .tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000 };
+    return select(node->sock + 1, &fds, NULL, NULL, &tv) > 0 ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void pixel_node_reset_stats(pixel_node_t *node)
+{
+    if (node)
+        memset(&node->stats, 0, sizeof(node->stats));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Copies 'len' payload bytes into the strip buffer at 'offset'
+static esp_err_t write_payload(pixel_node_t *node, const uint8_t *data, size_t offset, size_t len)
+{
+    // The RMT translator reads the buffer while sending; SPI encodes it at flush
+    if (node->strip->backend == LED_STRIP_BACKEND_RMT)
+        CHECK(led_strip_wait(node->strip, pdMS_TO_TICKS(STRIP_TIMEOUT_MS)));
+
+    memcpy(node->strip->buf + offset, data, len);
+    node->stats.packets++;
+    node->stats.pixels += len / COLOR_SIZE(node->strip);
+    if (len)
+        node->dirty = true;
+    return ESP_OK;
+}
+
+static esp_err_t show(pixel_node_t *node, uint32_t *frames)
+{
+    node->dirty = false;
+    node->sync_address = 0;
+    node->stats.frames++;
+    if (frames)
+        (*frames)++;
+    return led_strip_flush(node->strip);
+}
+
+// Records sequence number 'seq' of a stream; 'gap' is its distance to the
+// previous one, valid if there was one
+static void note_seq(pixel_node_t *node, size_t stream, uint8_t seq, int gap)
+{
+    if (node->seq_valid[stream] && gap > 1)
+        node->stats.dropped += gap - 1;
+    node->seq[stream] = seq;
+    node->seq_valid[stream] = true;
+}
+
+static esp_err_t receive_ddp(pixel_node_t *node, const uint8_t *hdr, size_t n, uint32_t *frames)
+{
+    uint8_t flags = hdr[0];
+    size_t hdr_len = DDP_HEADER_LEN + (flags & DDP_FLAG_TIMECODE ? DDP_TIMECODE_LEN : 0);
+    if (n < hdr_len || (flags & DDP_VERSION_MASK) != DDP_VERSION_1 ||
+        (flags & (DDP_FLAG_QUERY | DDP_FLAG_REPLY | DDP_FLAG_STORAGE)) || hdr[3] != DDP_ID_DISPLAY)
+    {
+        node->stats.ignored++;
+        return ESP_OK;
+    }
+    uint8_t seq = hdr[1] & 0x0f;
+    if (seq)
+        note_seq(node, 0, seq, (seq - node->seq[0] + DDP_SEQ_MOD) % DDP_SEQ_MOD);
+
+    size_t offset = be32(hdr + 4);
+    size_t len = be16(hdr + 8);
+    size_t size = buf_size(node);
+    if (len > n - hdr_len)
+        len = n - hdr_len;
+    if (offset > size)
+        offset = size;
+    if (len > size - offset)
+        len = size - offset;
+    CHECK(write_payload(node, hdr + hdr_len, offset, len));
+
+    if (flags & DDP_FLAG_PUSH)
+        return show(node, frames);
+    return ESP_OK;
+}
+
+static esp_err_t receive_e131(pixel_node_t *node, const uint8_t *hdr, size_t n, uint32_t *frames)
+{
+    if (n < E131_SYNC_LEN || be16(hdr) != 0x0010 || memcmp(hdr + 4, e131_acn_id, sizeof(e131_acn_id)))
+    {
+        node->stats.ignored++;
+        return ESP_OK;
+    }
+
+    uint32_t root = be32(hdr + E131_ROOT_VECTOR);
+    uint32_t framing = be32(hdr + E131_FRAMING_VECTOR);
+    if (root == E131_VECTOR_ROOT_EXTENDED && framing == E131_VECTOR_SYNC)
+    {
+        if (node->dirty && node->sync_address && be16(hdr + E131_SYNC_ADDRESS_EXT) == node->sync_address)
+            return show(node, frames);
+        return ESP_OK;
+    }
+
+    size_t idx = be16(hdr + E131_UNIVERSE) - node->universe; // Wraps for universes below ours
+    if (n < E131_HEADER_LEN || root != E131_VECTOR_ROOT_DATA || framing != E131_VECTOR_DATA_PACKET ||
+        hdr[E131_DMP_VECTOR] != E131_DMP_SET_PROPERTY || hdr[E131_DMP_TYPE] != E131_DMP_ADDRESS_TYPE ||
+        hdr[E131_START_CODE] != 0 || (hdr[E131_OPTIONS] & (E131_OPTION_PREVIEW | E131_OPTION_TERMINATED)) ||
+        idx >= num_universes(node))
+    {
+        node->stats.ignored++;
+        return ESP_OK;
+    }
+
+    uint8_t seq = hdr[E131_SEQUENCE];
+    int8_t diff = (int8_t)(seq - node->seq[idx]);
+    if (node->seq_valid[idx] && diff <= 0 && diff > -E131_LATE_WINDOW)
+    {
+        node->stats.late++;
+        return ESP_OK;
+    }
+    note_seq(node, idx, seq, diff); // A big step back is a restarted source, nothing dropped
+
+    size_t slots = be16(hdr + E131_VALUE_COUNT);
+    slots = slots ? slots - 1 : 0; // Minus the start code
+    if (slots > n - E131_HEADER_LEN)
+        slots = n - E131_HEADER_LEN;
+    size_t offset = idx * universe_size(node);
+    size_t len = buf_size(node) - offset;
+    if (len > universe_size(node))
+        len = universe_size(node);
+    if (len > slots)
+        len = slots;
+    CHECK(write_payload(node, hdr + E131_HEADER_LEN, offset, len));
+
+    uint16_t sync = be16(hdr + E131_SYNC_ADDRESS);
+    if (sync)
+    {
+        node->sync_address = sync;
+        return ESP_OK;
+    }
+    if (idx == num_universes(node) - 1)
+        return show(node, frames);
+    return ESP_OK;
+}
+
+esp_err_t pixel_node_receive(pixel_node_t *node, uint32_t *frames)
+{
+    CHECK_ARG(node && node->sock >= 0);
+
+    if (frames)
+        *frames = 0;
+    while (true)
+    {
+        ssize_t n = recv(node->sock, node->packet, sizeof(node->packet), 0);
+        if (n < 0)
+            return ESP_OK; // Nothing left
+        if (node->protocol == PIXEL_NODE_DDP)
+            CHECK(receive_ddp(node, node->packet, n, frames));
+        else
+            CHECK(receive_e131(node, node->packet, n, frames));
+    }
+}
+
+esp_err_t pixel_node_discard(pixel_node_t *node)
+{
+    CHECK_ARG(node && node->sock >= 0);
+
+    while (recv(node->sock, node->packet, sizeof(node->packet), 0) >= 0)
+        ;
+    // The next packets start a new stream
+    memset(node->seq_valid, 0, sizeof(node->seq_valid));
+    node->dirty = false;
+    node->sync_address = 0;
+    return ESP_OK;
+}
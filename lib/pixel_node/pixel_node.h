@@ -0,0 +1,146 @@
+/**
+ * @file pixel_node.h
+ * @defgroup pixel_node pixel_node
+ * @{
+ *
+ * E1.31 (sACN) and DDP network pixel receiver for led_strip
+ *
+ * Turns a strip into a pixel node of a lighting or show controller. The
+ * payload of every packet is copied unchanged into the strip buffer at the
+ * LEDs it addresses. The strip should be initialized with `rgb_buf` set, as
+ * both protocols send R, G, B(, W): color order and brightness are then
+ * applied by the strip encoder while sending, with no conversion pass.
+ *
+ * Frame sync:
+ * - DDP: the frame is shown on a packet with the PUSH flag.
+ * - E1.31: with a synchronization address in the data packets the frame is
+ *   shown on the matching sync packet, otherwise on the packet of the last
+ *   universe covering the strip. Each universe carries 170 RGB or 128 RGBW
+ *   LEDs, universe `universe` starts at LED 0.
+ *
+ * Missing sequence numbers are counted as dropped packets. Late E1.31
+ * packets are discarded as the standard requires.
+ *
+ * Uses BSD sockets only and runs unchanged in host builds.
+ */
+#ifndef __PIXEL_NODE_H__
+#define __PIXEL_NODE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include <led_strip.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIXEL_NODE_DDP_PORT 4048
+#define PIXEL_NODE_E131_PORT 5568
+#define PIXEL_NODE_MAX_UNIVERSES 8 ///< E1.31 universes per node
+#define PIXEL_NODE_MAX_PACKET 1460  ///< Longest packet read, DDP allows 1440 data bytes
+
+/**
+ * Network protocol
+ */
+typedef enum
+{
+    PIXEL_NODE_DDP = 0, ///< Distributed Display Protocol, output device 1
+    PIXEL_NODE_E131,    ///< E1.31 streaming ACN, DMX start code 0 only
+} pixel_node_protocol_t;
+
+/**
+ * Receiver statistics
+ */
+typedef struct
+{
+    uint32_t packets;      ///< Data packets written to the strip
+    uint32_t pixels;       ///< LEDs written
+    uint32_t frames;       ///< Frames shown
+    uint32_t dropped;      ///< Packets missing by sequence number
+    uint32_t late;         ///< E1.31 packets discarded as out of order
+    uint32_t ignored;      ///< Malformed packets, other universes, queries, preview data
+} pixel_node_stats_t;
+
+/**
+ * Pixel node descriptor
+ */
+typedef struct
+{
+    led_strip_t *strip;             ///< Strip the payload is written to
+    pixel_node_protocol_t protocol; ///< Protocol
+    uint16_t universe;              ///< E1.31: universe of LED 0
+    int sock;                       ///< UDP socket
+    bool dirty;                     ///< LEDs written since the last shown frame
+    uint16_t sync_address;          ///< E1.31: sync universe the written LEDs wait for, 0 if none
+    uint8_t seq[PIXEL_NODE_MAX_UNIVERSES]; ///< Last sequence number per universe (DDP: [0])
+    bool seq_valid[PIXEL_NODE_MAX_UNIVERSES];
+    pixel_node_stats_t stats;       ///< Statistics since init or ::pixel_node_reset_stats()
+    uint8_t packet[PIXEL_NODE_MAX_PACKET]; ///< Receive buffer
+} pixel_node_t;
+
+/**
+ * @brief Open the UDP socket of the node
+ *
+ * @param node Pixel node descriptor
+ * @param strip Initialized LED strip
+ * @param protocol Protocol to receive
+ * @param port UDP port, 0 for the standard port of the protocol
+ * @param universe E1.31: universe of LED 0, 1..63999; ignored for DDP
+ * @return `ESP_OK` on success
+ */
+esp_err_t pixel_node_init(pixel_node_t *node, led_strip_t *strip, pixel_node_protocol_t protocol, uint16_t port,
+                          uint16_t universe);
+
+/**
+ * @brief Close the socket
+ *
+ * @param node Pixel node descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t pixel_node_free(pixel_node_t *node);
+
+/**
+ * @brief Wait until a packet can be received
+ *
+ * @param node Pixel node descriptor
+ * @param timeout_ms Time to wait, 0 to only check
+ * @return `ESP_OK` if a packet is pending, `ESP_ERR_TIMEOUT` otherwise
+ */
+esp_err_t pixel_node_wait(pixel_node_t *node, uint32_t timeout_ms);
+
+/**
+ * @brief Receive all pending packets into the strip and show completed frames
+ *
+ * Waits for the strip to finish sending before writing into its buffer, and
+ * calls ::led_strip_flush() at every frame sync. Returns when no packet is
+ * left; never blocks on the network.
+ *
+ * @param node Pixel node descriptor
+ * @param[out] frames Number of frames shown, may be NULL
+ * @return `ESP_OK` on success
+ */
+esp_err_t pixel_node_receive(pixel_node_t *node, uint32_t *frames);
+
+/**
+ * @brief Read and drop all pending packets without touching the strip
+ *
+ * For while the strip shows something else.
+ *
+ * @param node Pixel node descriptor
+ * @return `ESP_OK` on success
+ */
+esp_err_t pixel_node_discard(pixel_node_t *node);
+
+/**
+ * @brief Clear statistics
+ */
+void pixel_node_reset_stats(pixel_node_t *node);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**@}*/
+
+#endif /* __PIXEL_NODE_H__ */
@@ -0,0 +1,27 @@
+/**
+ * @file pixel_node_ddp.h
+ *
+ * DDP (Distributed Display Protocol) packet layout, internal to the component
+ *
+ * Header: flags, sequence number, data type, output id, data offset (BE32),
+ * data length (BE16), then a BE32 timecode if its flag is set.
+ */
+#ifndef __PIXEL_NODE_DDP_H__
+#define __PIXEL_NODE_DDP_H__
+
+#define DDP_HEADER_LEN 10
+#define DDP_TIMECODE_LEN 4
+#define DDP_MAX_DATA 1440      // Data bytes per packet
+#define DDP_VERSION_MASK 0xc0
+#define DDP_VERSION_1 0x40
+#define DDP_FLAG_TIMECODE 0x10
+#define DDP_FLAG_STORAGE 0x08
+#define DDP_FLAG_REPLY 0x04
+#define DDP_FLAG_QUERY 0x02
+#define DDP_FLAG_PUSH 0x01
+#define DDP_TYPE_RGB8 0x0b
+#define DDP_TYPE_RGBW8 0x1b
+#define DDP_ID_DISPLAY 1
+#define DDP_SEQ_MOD 15         // Sequence numbers run 1..15, 0 means unused
+
+#endif /* __PIXEL_NODE_DDP_H__ */
@@ -0,0 +1,87 @@
+#include "ai.h"
+
+#define AI_SERVE_JITTER_MS 400 // Extra random delay before serving
+#define AI_LOOKAHEAD_TICKS 256 // Longest approach looked at (court length / slowest ball speed)
+
+void ai_init(AiPlayer *ai, int player, uint8_t skill, uint16_t reaction_ms, uint32_t seed) {
+    *ai = (AiPlayer){ .player = player, .skill = skill, .reaction_ms = reaction_ms };
+    random_state_init(&ai->rng, seed, player);
+}
+
+// Uniform random offset in -range..+range
+int32_t ai_jitter(AiPlayer *ai, uint32_t range) {
+    if (range == 0) return 0;
+    return (int32_t)(random32_r(&ai->rng) % (2 * range + 1)) - (int32_t)range;
+}
+
+// Replays the ball ticks to find the time window in which the ball is on
+// the paddle, and aims for its middle
+void ai_plan_return(AiPlayer *ai, Court *court, Player *me, uint32_t now) {
+    Ball *ball = &court->ball;
+    float step = (ball->direction == LEFT) ? -ball->speed : ball->speed;
+    uint32_t interval = ball_tick_interval(court);
+    int32_t next_tick = court->timers[TIMER_BALL].armed ? (int32_t)(court->timers[TIMER_BALL].deadline_ms - now)
+                                                        : (int32_t)interval;
+
+    // Same float steps as update_ball_position(), so the prediction is exact
+    int first = -1, last = -1;
+    float pos = ball->position;
+    for (int k = 0; k < AI_LOOKAHEAD_TICKS; k++, pos += step) {
+        if (k > 0 && (pos < 0 || pos >= court->num_leds - 1)) break; // Out, point lost
+        int idx = (int)(pos + 0.5f);
+        if (idx >= me->paddle_pos_start && idx <= me->paddle_pos_end) {
+            if (first < 0) first = k;
+            last = k;
+        } else if (first >= 0) {
+            break;
+        }
+    }
+
+    ai->planned = true;
+    if (first < 0) {
+        ai->pressed = true; // Unreachable, sit this one out
+        return;
+    }
+
+    // Ball shows tick k's position from the k-th tick until the next one
+    int32_t start = (first == 0) ? 0 : next_tick + (first - 1) * (int32_t)interval;
+    int32_t end = next_tick + last * (int32_t)interval;
+    int32_t span = end - start;
+    int32_t at = start + span / 2 + ai_jitter(ai, ((255 - ai->skill) * (uint32_t)span) >> 8);
+    if (at < ai->reaction_ms) at = ai->reaction_ms;
+    ai->press_at = now + at;
+}
+
+int32_t ai_update(AiPlayer *ai, Court *court, uint32_t now, bool *press) {
+    Player *me = (ai->player == 1) ? &court->player1 : &court->player2;
+    *press = false;
+
+    bool serving = court->state == GAME_STATE_WAIT_SERVE && court->servingPlayer == me;
+    bool returning = court->state == GAME_STATE_PLAYING && court->ball.direction == me->side;
+    if (!serving && !returning) {
+        ai->planned = false;
+        ai->pressed = false;
+        return -1;
+    }
+
+    if (ai->planned && ai->plan_serve != serving) {
+        ai->planned = false;
+        ai->pressed = false;
+    }
+    if (!ai->planned) {
+        ai->plan_serve = serving;
+        if (serving) {
+            ai->planned = true;
+            ai->press_at = now + ai->reaction_ms + AI_SERVE_JITTER_MS / 2 + ai_jitter(ai, AI_SERVE_JITTER_MS / 2);
+        } else {
+            ai_plan_return(ai, court, me, now);
+        }
+    }
+    if (ai->pressed) return -1;
+
+    int32_t remaining = (int32_t)(ai->press_at - now);
+    if (remaining > 0) return remaining;
+    ai->pressed = true;
+    *press = true;
+    return -1;
+}
@@ -0,0 +1,54 @@
+#ifndef AI_H
+#define AI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lib8tion.h"
+#include "game.h"
+
+// Computer player for one side of a court. When the ball turns towards its
+// paddle the AI predicts, from the ball position, speed and tick interval,
+// the ball ticks during which the ball is on the paddle and schedules one
+// press for the middle of them. Skill adds a random timing error, the
+// reaction time holds the press back after the ball turned. Planning happens
+// once per approach, so the per-call cost is a few comparisons.
+
+typedef struct {
+    int player;             // 1 = left, 2 = right
+    uint8_t skill;          // Timing accuracy, 255 = always presses dead centre
+    uint16_t reaction_ms;   // No press earlier than this after the ball turned (or the serve was due)
+    random_state_t rng;
+
+    bool planned;           // Press scheduled for the current approach or serve
+    bool plan_serve;        // ... for a serve; a serve after a return is a new plan even if
+                            // the point in between was not seen (env skips it)
+    bool pressed;           // ... and already done
+    uint32_t press_at;      // Time of the scheduled press (ms)
+} AiPlayer;
+
+/**
+ * @brief Initialize AI player
+ *
+ * @param ai AI descriptor
+ * @param player 1 for the left player, 2 for the right one
+ * @param skill Timing accuracy, 0..255
+ * @param reaction_ms Reaction time
+ * @param seed Random seed, the same seed gives the same game
+ */
+void ai_init(AiPlayer *ai, int player, uint8_t skill, uint16_t reaction_ms, uint32_t seed);
+
+/**
+ * @brief Let the AI look at the court at time 'now'
+ *
+ * Call it after court timers were processed and whenever the court changed.
+ *
+ * @param ai AI descriptor
+ * @param court Court the AI plays on
+ * @param now Current time (ms)
+ * @param[out] press Set to true if the AI presses its button now; feed the
+ *             press into the court
+ * @return Milliseconds until the next scheduled press, or -1 if none
+ */
+int32_t ai_update(AiPlayer *ai, Court *court, uint32_t now, bool *press);
+
+#endif /* AI_H */
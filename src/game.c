@@ -0,0 +1,714 @@
+#include "game.h"
+#include <stdlib.h>
+#include "esp_log.h"
+#include <inttypes.h> // For PRIu32 in ESP_LOG
+
+static const char *TAG = GAME_LOG_TAG;
+
+#define PADDLE_SIZE 6     // Number of LEDs for the paddle (as seen in video)
+#define INITIAL_LIVES 5
+#define INITIAL_BALL_SPEED 0.5f        // Start speed (LEDs per update-cycle)
+#define BALL_SPEED_MULT 1.12f          // Multiplicative speed growth per successful hit
+#define BALL_SPEED_CAP 4.0f            // Max ball speed (LEDs per tick)
+#define PADDLE_HIT_FACTOR 0.25f        // Max +/- speed modifier based on hit position on paddle (25%)
+#define BALL_UPDATE_INTERVAL_MS 30     // Base ball tick interval (ms); shrinks with rally
+#define BALL_UPDATE_INTERVAL_MIN_MS 15 // Floor for tick interval at high rally counts
+#define SERVE_BLINK_MS 250             // Serving paddle blink half-period (ms)
+
+// --- Color Definitions (RGB) ---
+// Colour constant from 0xRRGGBB, unpacked at compile time
+#define RGB_CONST(color) { .r = ((color) >> 16) & 0xFF, .g = ((color) >> 8) & 0xFF, .b = (color) & 0xFF }
+
+const rgb_t COLOR_BLACK = RGB_CONST(0x000000);
+const rgb_t COLOR_RED = RGB_CONST(0xFF0000);
+const rgb_t COLOR_GREEN = RGB_CONST(0x00FF00);
+const rgb_t COLOR_BLUE = RGB_CONST(0x0000FF);
+const rgb_t COLOR_P1_PADDLE = RGB_CONST(0xFF0000); // Red for P1 (left button in video)
+const rgb_t COLOR_P2_PADDLE = RGB_CONST(0x00FF00); // Green for P2 (right button in video)
+const rgb_t COLOR_BALL = RGB_CONST(0x00FFFF);   // Cyan ball (was white, changed for visibility)
+const rgb_t COLOR_LIFE_ACTIVE = RGB_CONST(0xFFFF00); // Yellow for active lives
+const rgb_t COLOR_LIFE_LOST = RGB_CONST(0x400000); // Dim Red for lost lives
+
+// --- Frame Functions ---
+// Animations draw straight into the court's animation frame
+void set_pixel_color(Court *court, int index, rgb_t color) {
+    if (index >= 0 && index < court->num_leds) {
+        court->anim_frame[index] = color;
+        court->anim_dirty = true;
+    }
+}
+
+void fill_color(Court *court, rgb_t color) {
+    rgb_fill_solid_rgb(court->anim_frame, color, court->num_leds);
+    court->anim_dirty = true;
+}
+
+// --- Timers ---
+// Court timers are deadlines relative to the time of the event being
+// processed; the caller sleeps until the earliest one expires.
+void timer_start(Court *court, GameTimer timer, uint32_t delay_ms) {
+    court->timers[timer].armed = true;
+    court->timers[timer].deadline_ms = court->now + delay_ms;
+}
+
+void timer_stop(Court *court, GameTimer timer) {
+    court->timers[timer].armed = false;
+}
+
+int32_t court_next_timer(const Court *court, uint32_t now) {
+    int32_t min_remaining = -1;
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        if (!court->timers[i].armed) continue;
+        int32_t remaining = (int32_t)(court->timers[i].deadline_ms - now);
+        if (remaining < 0) remaining = 0;
+        if (min_remaining < 0 || remaining < min_remaining) {
+            min_remaining = remaining;
+        }
+    }
+    return min_remaining;
+}
+
+// --- Game Initialization ---
+void init_game_elements(Court *court) {
+    Player *player1 = &court->player1;
+    Player *player2 = &court->player2;
+
+    player1->side = LEFT;
+    player1->lives = INITIAL_LIVES;
+    player1->color = COLOR_P1_PADDLE;
+    player1->paddle_pos_start = 0;
+    player1->paddle_pos_end = PADDLE_SIZE - 1;
+
+    player2->side = RIGHT;
+    player2->lives = INITIAL_LIVES;
+    player2->color = COLOR_P2_PADDLE;
+    player2->paddle_pos_start = court->num_leds - PADDLE_SIZE;
+    player2->paddle_pos_end = court->num_leds - 1;
+
+    court->ball.color = COLOR_BALL;
+    court->ball.speed = INITIAL_BALL_SPEED;
+    court->rallyCount = 0; // Reset difficulty ramp for a new game
+
+    // Alternate starting player or P1 starts
+    if (court->servingPlayer == player1) {
+        court->servingPlayer = player2;
+    } else {
+        court->servingPlayer = player1;
+    }
+    // court->servingPlayer = player1; // Player 1 always starts first game
+
+    ESP_LOGI(TAG, "Court %d: game elements initialized. Player %s serves.", court->id,
+             (court->servingPlayer == player1) ? "1 (Left)" : "2 (Right)");
+}
+
+void prepare_serve(Court *court) {
+    Ball *ball = &court->ball;
+    // Reset ball speed to the initial value for every new serve (after each point).
+    ball->speed = INITIAL_BALL_SPEED;
+    court->rallyCount = 0;
+    if (court->servingPlayer->side == LEFT) {
+        ball->position = court->player1.paddle_pos_end + 1.0f; // Just in front of the paddle
+        ball->direction = STOP; // Waits for action
+    } else {
+        ball->position = court->player2.paddle_pos_start - 1.0f;
+        ball->direction = STOP;
+    }
+    ESP_LOGI(TAG, "Court %d: prepare serve. Ball at %.1f, Player %s to serve.", court->id, ball->position,
+             (court->servingPlayer == &court->player1) ? "1" : "2");
+}
+
+// --- Game Logic ---
+// Computes a speed modifier (1.0 +/- up to PADDLE_HIT_FACTOR) based on where the
+// ball hit the paddle. Center = 0% (1.0). Front (toward opponent) = up to -25%.
+// Back (toward the player/wall) = up to +25%. Linearly interpolated.
+float paddle_hit_factor(Player *p, int ball_led_idx) {
+    // Normalized position along the paddle: 0.0 at paddle_pos_start, 1.0 at paddle_pos_end
+    float t;
+    if (PADDLE_SIZE > 1) {
+        t = (float)(ball_led_idx - p->paddle_pos_start) / (float)(PADDLE_SIZE - 1);
+    } else {
+        t = 0.5f;
+    }
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+
+    // Map t (0..1) to -1..+1 where -1 = paddle_pos_start end, +1 = paddle_pos_end end
+    float rel = (t - 0.5f) * 2.0f; // -1 .. +1, 0 = center
+
+    // Determine which end is "front" (toward opponent) and which is "back" (toward player).
+    // P1 (LEFT): front = paddle_pos_end (t=1, rel=+1), back = paddle_pos_start (t=0, rel=-1)
+    // P2 (RIGHT): front = paddle_pos_start (t=0, rel=-1), back = paddle_pos_end (t=1, rel=+1)
+    float back_amount; // -1 (full front) .. +1 (full back)
+    if (p->side == LEFT) {
+        back_amount = -rel; // back is at start (rel=-1) -> +1
+    } else {
+        back_amount = rel;  // back is at end (rel=+1) -> +1
+    }
+
+    return 1.0f + back_amount * PADDLE_HIT_FACTOR;
+}
+
+// Handles a button press during play: either a paddle hit (if the ball is on
+// the player's paddle and moving toward them) or a penalty (if they press
+// while the ball is approaching but NOT on their paddle).
+GameState handle_paddle_input(Court *court, Player *p) {
+    Ball *ball = &court->ball;
+    int player_num = (p == &court->player1) ? 1 : 2;
+    if (ball->direction != p->side) {
+        return GAME_STATE_PLAYING; // Ball moving away, press is ignored
+    }
+
+    int ball_led_idx = (int)(ball->position + 0.5f);
+    if (ball_led_idx >= p->paddle_pos_start && ball_led_idx <= p->paddle_pos_end) {
+        // Hit
+        ESP_LOGI(TAG, "Court %d: player %d hit! Ball at %d, Paddle [%d-%d]", court->id, player_num, ball_led_idx,
+                 p->paddle_pos_start, p->paddle_pos_end);
+        if (p->side == LEFT) {
+            ball->direction = RIGHT;
+            ball->position = p->paddle_pos_end + 0.1f;
+        } else {
+            ball->direction = LEFT;
+            ball->position = p->paddle_pos_start - 0.1f;
+        }
+        court->rallyCount++;
+        ball->speed *= BALL_SPEED_MULT;
+        ball->speed *= paddle_hit_factor(p, ball_led_idx);
+        if (ball->speed > BALL_SPEED_CAP) ball->speed = BALL_SPEED_CAP;
+        if (ball->speed < INITIAL_BALL_SPEED) ball->speed = INITIAL_BALL_SPEED;
+        ESP_LOGI(TAG, "Court %d: new ball speed: %.2f (rally %d)", court->id, ball->speed, court->rallyCount);
+        return GAME_STATE_PLAYING;
+    }
+
+    // Mis-press penalty: ball approaching but not on paddle
+    ESP_LOGI(TAG, "Court %d: player %d mis-press penalty! Ball at %d", court->id, player_num, ball_led_idx);
+    p->lives--;
+    court->servingPlayer = p;
+    return GAME_STATE_POINT_SCORED;
+}
+
+GameState update_ball_position(Court *court) {
+    Ball *ball = &court->ball;
+    if (ball->direction == LEFT) {
+        ball->position -= ball->speed;
+    } else if (ball->direction == RIGHT) {
+        ball->position += ball->speed;
+    }
+
+    // Collision with Walls (Points)
+    if (ball->position < 0) { // Ball went past player 1
+        ESP_LOGI(TAG, "Court %d: ball out on left. Player 2 scores.", court->id);
+        court->player1.lives--;
+        court->servingPlayer = &court->player1; // Loser serves
+        return GAME_STATE_POINT_SCORED;
+    } else if (ball->position >= court->num_leds - 1) { // Ball went past player 2
+        ESP_LOGI(TAG, "Court %d: ball out on right. Player 1 scores.", court->id);
+        court->player2.lives--;
+        court->servingPlayer = &court->player2; // Loser serves
+        return GAME_STATE_POINT_SCORED;
+    }
+    return GAME_STATE_PLAYING;
+}
+
+// Dynamic tick interval: shrinks as the rally grows, clamped to a floor
+uint32_t ball_tick_interval(Court *court) {
+    uint32_t interval = BALL_UPDATE_INTERVAL_MS - (court->rallyCount / 2);
+    if (interval < BALL_UPDATE_INTERVAL_MIN_MS) {
+        interval = BALL_UPDATE_INTERVAL_MIN_MS;
+    }
+    return interval;
+}
+
+// --- Animations ---
+// Colour wheel R -> G -> B -> R, expanded once into a 256-entry table shared
+// by all courts
+rgb_palette256_t rainbow_palette;
+bool rainbow_palette_ready = false;
+
+void render_rainbow_frame(Court *court, int j) {
+    if (!rainbow_palette_ready) {
+        const rgb_t wheel[] = { COLOR_RED, COLOR_GREEN, COLOR_BLUE };
+        rgb_palette256_from_rgb(&rainbow_palette, wheel, 3, true);
+        rainbow_palette_ready = true;
+    }
+
+    // One full wheel turn spread over the court, shifted by j each frame
+    rgb_fill_palette256(court->anim_frame, court->num_leds, &rainbow_palette, (accum88)(j << 8),
+                        65536 / court->num_leds, 255);
+    court->anim_dirty = true;
+}
+
+void render_knight_rider_frame(Court *court, int frame) {
+    // Forward sweep covers positions 0..num_leds-width, backward sweep
+    // num_leds-width-1..0
+    int forward = court->num_leds - court->anim.width + 1;
+    int f = frame % (2 * forward - 1);
+    int i = (f < forward) ? f : (2 * forward - 2 - f);
+    fill_color(court, COLOR_BLACK);
+    for (int k = 0; k < court->anim.width; k++) {
+        set_pixel_color(court, i + k, court->anim.color);
+    }
+}
+
+// Draws the current frame and returns how long it stays on the court
+uint32_t render_anim_frame(Court *court) {
+    Animation *anim = &court->anim;
+    switch (anim->type) {
+        case ANIM_RAINBOW:
+            render_rainbow_frame(court, anim->frame);
+            break;
+        case ANIM_KNIGHT_RIDER:
+            render_knight_rider_frame(court, anim->frame);
+            break;
+        case ANIM_SCORE_BLINK: {
+            // 3 x (on, off) at 200 ms, longer pause after the last one
+            bool on = (anim->frame % 2) == 0;
+            for (int j = anim->start_led; j < anim->end_led; j++) {
+                set_pixel_color(court, j, on ? anim->color : COLOR_BLACK);
+            }
+            return (anim->frame == anim->frames - 1) ? 200 + 600 : 200;
+        }
+        case ANIM_WINNER_FLASH:
+            fill_color(court, (anim->frame % 2) == 0 ? anim->color : COLOR_BLACK);
+            break;
+    }
+    return anim->period_ms;
+}
+
+void anim_start(Court *court, AnimType type, int frames, uint32_t period_ms) {
+    Animation *anim = &court->anim;
+    anim->type = type;
+    anim->running = true;
+    anim->frame = 0;
+    anim->frames = frames;
+    anim->period_ms = period_ms;
+    timer_start(court, TIMER_ANIM, render_anim_frame(court));
+}
+
+void rainbowCycle(Court *court, int wait_ms, int cycles) {
+    anim_start(court, ANIM_RAINBOW, 256 * cycles, wait_ms);
+}
+
+void knightRiderAnimation(Court *court, rgb_t color, int width, int repeats, int anim_speed_ms) {
+    court->anim.color = color;
+    court->anim.width = width;
+    anim_start(court, ANIM_KNIGHT_RIDER, repeats * (2 * (court->num_leds - width) + 1), anim_speed_ms);
+}
+
+// Advances the running animation; returns true when it just finished
+bool anim_step(Court *court) {
+    Animation *anim = &court->anim;
+    if (!anim->running) return false;
+    anim->frame++;
+    if (anim->frame >= anim->frames) {
+        anim->running = false;
+        timer_stop(court, TIMER_ANIM);
+        return true;
+    }
+    timer_start(court, TIMER_ANIM, render_anim_frame(court));
+    return false;
+}
+
+// --- State Machine ---
+// Entry/exit actions per state, and a transition table mapping
+// (state, event) to an action that returns the next state. Events without an
+// entry for the current state are ignored.
+typedef GameState (*TransitionAction)(Court *court);
+
+typedef struct {
+    GameState state;
+    GameEvent event;
+    TransitionAction action;
+} Transition;
+
+typedef struct {
+    const char *name;
+    void (*enter)(Court *court);
+    void (*exit)(Court *court);
+} StateActions;
+
+void enter_init(Court *court) {
+    // knightRiderAnimation(court, COLOR_RED, 5, 1, 30); // Start animation
+    rainbowCycle(court, 10, 2);
+}
+
+void enter_wait_serve(Court *court) {
+    prepare_serve(court); // Sets ball position, direction=STOP
+    court->serveBlinkOn = true;
+    court->serveWaitStart = court->now;
+    timer_start(court, TIMER_BLINK, SERVE_BLINK_MS);
+}
+
+void exit_wait_serve(Court *court) {
+    timer_stop(court, TIMER_BLINK);
+}
+
+void enter_playing(Court *court) {
+    timer_start(court, TIMER_BALL, ball_tick_interval(court));
+}
+
+void exit_playing(Court *court) {
+    timer_stop(court, TIMER_BALL);
+}
+
+void enter_point_scored(Court *court) {
+    ESP_LOGI(TAG, "Court %d: P1 Lives: %d, P2 Lives: %d", court->id, court->player1.lives, court->player2.lives);
+    fill_color(court, COLOR_BLACK); // All off
+
+    // Scorer is the one NOT serving next
+    Player *scorer = (court->servingPlayer == &court->player1) ? &court->player2 : &court->player1;
+    court->anim.color = scorer->color;
+    court->anim.start_led = (scorer == &court->player1) ? 0 : court->num_leds / 2;
+    court->anim.end_led = (scorer == &court->player1) ? court->num_leds / 2 : court->num_leds;
+    anim_start(court, ANIM_SCORE_BLINK, 6, 200); // Blink scorer's side
+}
+
+void enter_game_over(Court *court) {
+    bool p1_wins = court->player1.lives > 0;
+    court->anim.color = p1_wins ? court->player1.color : court->player2.color;
+    ESP_LOGI(TAG, "Court %d: %s WINS!", court->id, p1_wins ? "Player 1" : "Player 2");
+    anim_start(court, ANIM_WINNER_FLASH, 10, 250); // Flash winner color 5 times
+}
+
+void enter_wait_restart(Court *court) {
+    ESP_LOGI(TAG, "Court %d: press any button to restart.", court->id);
+}
+
+GameState on_init_done(Court *court) {
+    init_game_elements(court); // Sets lives, player data
+    return GAME_STATE_WAIT_SERVE;
+}
+
+GameState on_serve_press(Court *court, Player *p) {
+    if (court->servingPlayer != p) return GAME_STATE_WAIT_SERVE;
+    court->ball.direction = (p->side == LEFT) ? RIGHT : LEFT;
+    ESP_LOGI(TAG, "Court %d: player %d serves %s.", court->id, (p == &court->player1) ? 1 : 2,
+             (p->side == LEFT) ? "right" : "left");
+    return GAME_STATE_PLAYING;
+}
+
+GameState on_serve_p1(Court *court) { return on_serve_press(court, &court->player1); }
+GameState on_serve_p2(Court *court) { return on_serve_press(court, &court->player2); }
+
+GameState on_serve_blink(Court *court) {
+    if (court->now - court->serveWaitStart >= SERVE_IDLE_AFTER_MS) {
+        court->serveBlinkOn = true; // Leave the marker lit and let the unit go idle
+        return GAME_STATE_WAIT_SERVE;
+    }
+    court->serveBlinkOn = !court->serveBlinkOn;
+    timer_start(court, TIMER_BLINK, SERVE_BLINK_MS);
+    return GAME_STATE_WAIT_SERVE;
+}
+
+GameState on_paddle_p1(Court *court) { return handle_paddle_input(court, &court->player1); }
+GameState on_paddle_p2(Court *court) { return handle_paddle_input(court, &court->player2); }
+
+GameState on_ball_tick(Court *court) {
+    GameState next = update_ball_position(court);
+    if (next == GAME_STATE_PLAYING) {
+        timer_start(court, TIMER_BALL, ball_tick_interval(court));
+    }
+    return next;
+}
+
+GameState on_point_done(Court *court) {
+    if (court->player1.lives == 0 || court->player2.lives == 0) {
+        return GAME_STATE_GAME_OVER;
+    }
+    return GAME_STATE_WAIT_SERVE; // Next serve
+}
+
+GameState on_game_over_press(Court *court) {
+    // Allow early exit from the winner flash, straight to the victory lap
+    if (court->anim.type == ANIM_WINNER_FLASH && court->anim.running) {
+        rainbowCycle(court, 15, 3);
+    }
+    return GAME_STATE_GAME_OVER;
+}
+
+GameState on_game_over_anim_done(Court *court) {
+    if (court->anim.type == ANIM_WINNER_FLASH) {
+        rainbowCycle(court, 15, 3); // Victory lap!
+        return GAME_STATE_GAME_OVER;
+    }
+    return GAME_STATE_WAIT_RESTART;
+}
+
+GameState on_restart(Court *court) {
+    return GAME_STATE_INIT; // Back to start
+}
+
+const StateActions state_actions[GAME_STATE_COUNT] = {
+    [GAME_STATE_INIT]         = { "INIT",         enter_init,         NULL },
+    [GAME_STATE_WAIT_SERVE]   = { "WAIT_SERVE",   enter_wait_serve,   exit_wait_serve },
+    [GAME_STATE_PLAYING]      = { "PLAYING",      enter_playing,      exit_playing },
+    [GAME_STATE_POINT_SCORED] = { "POINT_SCORED", enter_point_scored, NULL },
+    [GAME_STATE_GAME_OVER]    = { "GAME_OVER",    enter_game_over,    NULL },
+    [GAME_STATE_WAIT_RESTART] = { "WAIT_RESTART", enter_wait_restart, NULL },
+};
+
+const Transition transitions[] = {
+    { GAME_STATE_INIT,         EVENT_ANIM_DONE, on_init_done },
+    { GAME_STATE_WAIT_SERVE,   EVENT_P1_PRESS,  on_serve_p1 },
+    { GAME_STATE_WAIT_SERVE,   EVENT_P2_PRESS,  on_serve_p2 },
+    { GAME_STATE_WAIT_SERVE,   EVENT_BLINK,     on_serve_blink },
+    { GAME_STATE_PLAYING,      EVENT_P1_PRESS,  on_paddle_p1 },
+    { GAME_STATE_PLAYING,      EVENT_P2_PRESS,  on_paddle_p2 },
+    { GAME_STATE_PLAYING,      EVENT_BALL_TICK, on_ball_tick },
+    { GAME_STATE_POINT_SCORED, EVENT_ANIM_DONE, on_point_done },
+    { GAME_STATE_GAME_OVER,    EVENT_P1_PRESS,  on_game_over_press },
+    { GAME_STATE_GAME_OVER,    EVENT_P2_PRESS,  on_game_over_press },
+    { GAME_STATE_GAME_OVER,    EVENT_ANIM_DONE, on_game_over_anim_done },
+    { GAME_STATE_WAIT_RESTART, EVENT_P1_PRESS,  on_restart },
+    { GAME_STATE_WAIT_RESTART, EVENT_P2_PRESS,  on_restart },
+};
+
+void enter_state(Court *court, GameState state) {
+    court->state = state;
+    ESP_LOGI(TAG, "Court %d: state GAME_STATE_%s", court->id, state_actions[state].name);
+    if (state_actions[state].enter) state_actions[state].enter(court);
+}
+
+void dispatch_event(Court *court, GameEvent event) {
+    for (size_t i = 0; i < sizeof(transitions) / sizeof(transitions[0]); i++) {
+        const Transition *t = &transitions[i];
+        if (t->state != court->state || t->event != event) continue;
+
+        GameState next = t->action(court);
+        if (next != court->state) {
+            if (state_actions[court->state].exit) state_actions[court->state].exit(court);
+            enter_state(court, next);
+        }
+        return;
+    }
+}
+
+// --- Rendering ---
+// Play field layers, bottom to top. The compositor only recomposites from
+// the lowest layer that changed, so a moving ball costs a single layer blend.
+enum {
+    LAYER_BACKGROUND,
+    LAYER_PADDLES,
+    LAYER_LIVES,      // Lives HUD next to each paddle
+    LAYER_BALL,
+    LAYER_OVERLAY,    // Transient effects, e.g. serve blink
+    LAYER_COUNT
+};
+
+void render_paddles_and_lives(Court *court) {
+    compositor_t *scene = &court->scene;
+    Player *player1 = &court->player1;
+    Player *player2 = &court->player2;
+    int half = court->num_leds / 2;
+
+    // Player 1 Paddle
+    compositor_fill(scene, LAYER_PADDLES, player1->paddle_pos_start, PADDLE_SIZE, player1->color);
+    // Player 1 Lives (display next to paddle)
+    // Display active lives first, then lost lives
+    int life_led_idx_p1 = player1->paddle_pos_end + 2; // Start lives display 1 LED away from paddle
+    for (int i = 0; i < INITIAL_LIVES; i++) {
+        if (life_led_idx_p1 + i < half - PADDLE_SIZE) { // Ensure lives don't overlap P2 area
+            rgb_t color = (i < player1->lives) ? COLOR_LIFE_ACTIVE : COLOR_LIFE_LOST;
+            compositor_set_pixel(scene, LAYER_LIVES, life_led_idx_p1 + i, color);
+        }
+    }
+
+    // Player 2 Paddle
+    compositor_fill(scene, LAYER_PADDLES, player2->paddle_pos_start, PADDLE_SIZE, player2->color);
+    // Player 2 Lives
+    int life_led_idx_p2 = player2->paddle_pos_start - 2; // Start lives display 1 LED away from paddle
+    for (int i = 0; i < INITIAL_LIVES; i++) {
+         if (life_led_idx_p2 - i > half + PADDLE_SIZE) { // Ensure lives don't overlap P1 area
+            rgb_t color = (i < player2->lives) ? COLOR_LIFE_ACTIVE : COLOR_LIFE_LOST;
+            compositor_set_pixel(scene, LAYER_LIVES, life_led_idx_p2 - i, color);
+        }
+    }
+}
+
+// Moves the single lit LED of 'layer' to 'led' (-1 for none). Clearing and
+// redrawing an unmoved LED would dirty the layer and flush an identical frame.
+static void render_single_led(Court *court, size_t layer, int *shown, int led, rgb_t color) {
+    if (led != *shown) {
+        compositor_clear(&court->scene, layer);
+        *shown = led;
+    }
+    if (led >= 0) compositor_set_pixel(&court->scene, layer, led, color);
+}
+
+void render_ball(Court *court) {
+    int ball_led_idx = -1;
+    // Render ball only if it's in play or waiting for serve
+    if (court->state == GAME_STATE_PLAYING || court->state == GAME_STATE_WAIT_SERVE) {
+        ball_led_idx = (int)(court->ball.position + 0.5f); // Round to nearest LED
+    }
+    render_single_led(court, LAYER_BALL, &court->ball_led, ball_led_idx, court->ball.color);
+}
+
+void render_overlay(Court *court) {
+    int center = -1;
+    rgb_t color = COLOR_BLACK;
+    // Serving player's paddle center blinks while waiting for the serve
+    if (court->state == GAME_STATE_WAIT_SERVE) {
+        Player *server = court->servingPlayer;
+        center = server->paddle_pos_start + PADDLE_SIZE/2;
+        color = court->serveBlinkOn ? server->color : COLOR_BLACK;
+    }
+    render_single_led(court, LAYER_OVERLAY, &court->overlay_led, center, color);
+}
+
+const rgb_t *court_render(Court *court, bool *changed) {
+    // These states show full-court animations/displays
+    if (court->state == GAME_STATE_INIT ||
+        court->state == GAME_STATE_GAME_OVER ||
+        court->state == GAME_STATE_WAIT_RESTART ||
+        court->state == GAME_STATE_POINT_SCORED) {
+        court->scene_stale = true;
+        *changed = court->anim_dirty;
+        court->anim_dirty = false;
+        return court->anim_frame;
+    }
+
+    if (court->scene_stale) {
+        compositor_invalidate(&court->scene);
+        court->scene_stale = false;
+    }
+
+    render_paddles_and_lives(court);
+    render_ball(court);
+    render_overlay(court);
+
+    return compositor_render(&court->scene, changed);
+}
+
+void court_invalidate(Court *court) {
+    court->scene_stale = true;
+    court->anim_dirty = true;
+}
+
+// --- Court API ---
+esp_err_t court_init(Court *court, int id, int num_leds) {
+    *court = (Court){ .id = id, .num_leds = num_leds, .state = GAME_STATE_INIT, .serveBlinkOn = true,
+                      .scene_stale = true, .ball_led = -1, .overlay_led = -1 };
+
+    court->anim_frame = calloc(num_leds, sizeof(rgb_t));
+    if (!court->anim_frame)
+        return ESP_ERR_NO_MEM;
+
+    esp_err_t err = compositor_init(&court->scene, num_leds, LAYER_COUNT);
+    if (err != ESP_OK) {
+        free(court->anim_frame);
+        court->anim_frame = NULL;
+        return err;
+    }
+    compositor_fill(&court->scene, LAYER_BACKGROUND, 0, num_leds, COLOR_BLACK);
+    return ESP_OK;
+}
+
+void court_free(Court *court) {
+    compositor_free(&court->scene);
+    free(court->anim_frame);
+    court->anim_frame = NULL;
+}
+
+void court_start(Court *court, uint32_t now) {
+    court->now = now;
+    enter_state(court, GAME_STATE_INIT); // Initial state
+}
+
+void court_new_game(Court *court, uint32_t now) {
+    court->now = now;
+    if (state_actions[court->state].exit) state_actions[court->state].exit(court);
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        timer_stop(court, i);
+    }
+    court->anim.running = false;
+    init_game_elements(court);
+    enter_state(court, GAME_STATE_WAIT_SERVE);
+}
+
+void court_snapshot(const Court *court, CourtSnapshot *snap) {
+    *snap = (CourtSnapshot){
+        .lives = { court->player1.lives, court->player2.lives },
+        .state = court->state,
+        .serving = court->servingPlayer == &court->player2,
+        .ball_position = court->ball.position,
+        .ball_speed = court->ball.speed,
+        .ball_direction = court->ball.direction,
+        .serveBlinkOn = court->serveBlinkOn,
+        .rallyCount = court->rallyCount,
+        .serveWaitStart = court->serveWaitStart,
+        .now = court->now,
+        .anim = court->anim,
+    };
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        if (court->timers[i].armed) snap->timers_armed |= 1 << i;
+        snap->deadlines[i] = court->timers[i].deadline_ms;
+    }
+}
+
+void court_restore(Court *court, const CourtSnapshot *snap) {
+    court->player1.lives = snap->lives[0];
+    court->player2.lives = snap->lives[1];
+    court->state = snap->state;
+    court->servingPlayer = snap->serving ? &court->player2 : &court->player1;
+    court->ball.position = snap->ball_position;
+    court->ball.speed = snap->ball_speed;
+    court->ball.direction = snap->ball_direction;
+    court->serveBlinkOn = snap->serveBlinkOn;
+    court->rallyCount = snap->rallyCount;
+    court->serveWaitStart = snap->serveWaitStart;
+    court->now = snap->now;
+    court->anim = snap->anim;
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        court->timers[i].armed = snap->timers_armed & (1 << i);
+        court->timers[i].deadline_ms = snap->deadlines[i];
+    }
+
+    // Redraw the animation frame the restored state shows
+    court->scene_stale = true;
+    if (court->state != GAME_STATE_WAIT_SERVE && court->state != GAME_STATE_PLAYING) {
+        fill_color(court, COLOR_BLACK);
+        if (court->anim.frames > 0) render_anim_frame(court);
+    }
+}
+
+void court_dispatch(Court *court, GameEvent event, uint32_t now) {
+    court->now = now;
+    dispatch_event(court, event);
+}
+
+void court_process_timers(Court *court, uint32_t now) {
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        Timer *timer = &court->timers[i];
+        if (!timer->armed || (int32_t)(timer->deadline_ms - now) > 0) continue;
+        timer->armed = false;
+        // Run the handler at the deadline, so rescheduling from it keeps
+        // the cadence independent of how late the caller woke up
+        court->now = timer->deadline_ms;
+        switch ((GameTimer)i) {
+            case TIMER_BALL:
+                dispatch_event(court, EVENT_BALL_TICK);
+                break;
+            case TIMER_BLINK:
+                dispatch_event(court, EVENT_BLINK);
+                break;
+            case TIMER_ANIM:
+                if (anim_step(court)) dispatch_event(court, EVENT_ANIM_DONE);
+                break;
+            default:
+                break;
+        }
+    }
+    court->now = now;
+}
+
+int32_t courts_advance(Court *courts, size_t num, uint32_t now) {
+    int32_t next = -1;
+    for (size_t i = 0; i < num; i++) {
+        court_process_timers(&courts[i], now);
+        int32_t remaining = court_next_timer(&courts[i], now);
+        if (remaining >= 0 && (next < 0 || remaining < next)) {
+            next = remaining;
+        }
+    }
+    return next;
+}
@@ -0,0 +1,230 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "compositor.h"
+
+// One court is a complete, independent game: two players, a ball, a state
+// machine with its own timers, and a frame of 'num_leds' pixels. The engine
+// never touches hardware; the caller feeds it button events and the current
+// time in milliseconds and copies the rendered frames to the strip.
+
+#define GAME_LOG_TAG "PongGame" // Log tag of the engine, e.g. for esp_log_level_set()
+#define SERVE_IDLE_AFTER_MS 10000   // Serve blink stops after this long so the unit can go idle
+
+typedef enum {
+    LEFT,
+    RIGHT,
+    STOP
+} direction_type;
+
+typedef enum {
+    GAME_STATE_INIT,          // Game initializing / Start screen
+    GAME_STATE_WAIT_SERVE,    // Waiting for serve
+    GAME_STATE_PLAYING,       // Ball is in play
+    GAME_STATE_POINT_SCORED,  // Point scored, brief pause
+    GAME_STATE_GAME_OVER,     // Game over animation
+    GAME_STATE_WAIT_RESTART,  // Waiting for any button to start a new game
+    GAME_STATE_COUNT
+} GameState;
+
+// Everything the state machine reacts to. Button presses come from the
+// caller, the others from expired court timers.
+typedef enum {
+    EVENT_P1_PRESS,
+    EVENT_P2_PRESS,
+    EVENT_BALL_TICK,   // Ball moves one step
+    EVENT_BLINK,       // Serving paddle blink toggles
+    EVENT_ANIM_DONE,   // Current full-court animation finished
+    EVENT_WAKE,        // Left idle mode; no transition, the loop just re-evaluates idle
+} GameEvent;
+
+typedef enum {
+    TIMER_BALL,
+    TIMER_BLINK,
+    TIMER_ANIM,        // Next animation frame
+    TIMER_COUNT
+} GameTimer;
+
+typedef struct {
+    bool armed;
+    uint32_t deadline_ms;
+} Timer;
+
+typedef struct {
+    uint8_t lives;
+    direction_type side; // LEFT or RIGHT
+    rgb_t color;
+    int paddle_pos_start; // For rendering
+    int paddle_pos_end;   // For rendering
+} Player;
+
+typedef struct {
+    float position;
+    direction_type direction;
+    float speed;
+    rgb_t color;
+} Ball;
+
+// Full-court animations are played one frame per TIMER_ANIM expiry, so the
+// engine never blocks inside them. EVENT_ANIM_DONE follows the last frame.
+typedef enum {
+    ANIM_RAINBOW,      // Colour wheel cycling along the court
+    ANIM_KNIGHT_RIDER, // Block of 'width' LEDs sweeping back and forth
+    ANIM_SCORE_BLINK,  // Scorer's half blinks, then a pause
+    ANIM_WINNER_FLASH, // Whole court flashes in winner colour
+} AnimType;
+
+typedef struct {
+    AnimType type;
+    bool running;
+    int frame;
+    int frames;      // Total number of frames
+    uint32_t period_ms;
+    rgb_t color;
+    int width;       // Knight rider block width
+    int start_led;   // Score blink range
+    int end_led;
+} Animation;
+
+typedef struct {
+    int id;                 // For log messages
+    int num_leds;           // Court length
+
+    Player player1, player2;
+    Ball ball;
+    GameState state;
+    Player *servingPlayer;  // Pointer to the player who serves
+    int rallyCount;         // Successful hits in current game; drives difficulty curve
+    bool serveBlinkOn;      // Serving paddle center lit (toggled by EVENT_BLINK)
+    uint32_t serveWaitStart; // When the current WAIT_SERVE began (ms)
+
+    uint32_t now;           // Time of the event being processed (ms)
+    Timer timers[TIMER_COUNT];
+    Animation anim;
+
+    compositor_t scene;     // Play field layers
+    bool scene_stale;       // Frame was overwritten by an animation since last composite
+    int ball_led;           // LED lit on the ball layer, -1 for none
+    int overlay_led;        // LED lit on the overlay layer, -1 for none
+    rgb_t *anim_frame;      // Frame for full-court animations
+    bool anim_dirty;        // anim_frame changed since the last court_render()
+} Court;
+
+// Game state of a court without its frame buffers, for saving and restoring
+// (e.g. rolling back a networked game). Player colours and paddle positions
+// never change after court_init() and are not included.
+typedef struct {
+    uint8_t lives[2];
+    uint8_t state;          // GameState
+    uint8_t serving;        // 0 = player 1, 1 = player 2
+    float ball_position;
+    float ball_speed;
+    uint8_t ball_direction; // direction_type
+    bool serveBlinkOn;
+    uint16_t rallyCount;
+    uint32_t serveWaitStart;
+    uint32_t now;
+    uint8_t timers_armed;   // Bit per GameTimer
+    uint32_t deadlines[TIMER_COUNT];
+    Animation anim;
+} CourtSnapshot;
+
+/**
+ * @brief Allocate the court's frame buffers and reset it
+ *
+ * The court starts in GAME_STATE_INIT but does nothing until court_start().
+ *
+ * @param court Court descriptor
+ * @param id Court number, used in log messages
+ * @param num_leds Court length in LEDs
+ * @return `ESP_OK` on success
+ */
+esp_err_t court_init(Court *court, int id, int num_leds);
+
+/**
+ * @brief Free the court's frame buffers
+ */
+void court_free(Court *court);
+
+/**
+ * @brief Enter the initial state (start animation) at time 'now'
+ */
+void court_start(Court *court, uint32_t now);
+
+/**
+ * @brief Start a new game at time 'now', skipping the start animation
+ *
+ * Works from any state; the court goes straight to GAME_STATE_WAIT_SERVE.
+ */
+void court_new_game(Court *court, uint32_t now);
+
+/**
+ * @brief Save the game state of the court
+ */
+void court_snapshot(const Court *court, CourtSnapshot *snap);
+
+/**
+ * @brief Restore a game state saved with court_snapshot()
+ *
+ * The frame is redrawn from the restored state on the next court_render().
+ */
+void court_restore(Court *court, const CourtSnapshot *snap);
+
+/**
+ * @brief Feed one event into the court's state machine
+ *
+ * Events without a transition in the current state are ignored.
+ */
+void court_dispatch(Court *court, GameEvent event, uint32_t now);
+
+/**
+ * @brief Dispatch the events of all timers expired at 'now'
+ */
+void court_process_timers(Court *court, uint32_t now);
+
+/**
+ * @brief Time until the court's earliest timer expires
+ *
+ * @return Milliseconds (0 if already due), or -1 if no timer is armed
+ */
+int32_t court_next_timer(const Court *court, uint32_t now);
+
+/**
+ * @brief Current interval between ball ticks (ms)
+ *
+ * Shrinks with the rally; constant while the ball travels between paddles.
+ */
+uint32_t ball_tick_interval(Court *court);
+
+/**
+ * @brief Render the court's current frame
+ *
+ * @param court Court descriptor
+ * @param[out] changed Set to true if the frame differs from the previous call
+ * @return Frame of `num_leds` pixels, valid until the next court call
+ */
+const rgb_t *court_render(Court *court, bool *changed);
+
+/**
+ * @brief Make the next court_render() report a change
+ *
+ * For when the court's LEDs were overwritten by something else.
+ */
+void court_invalidate(Court *court);
+
+/**
+ * @brief Advance all courts to 'now'
+ *
+ * Fires expired timers on every court. The cost is linear in the number of
+ * courts; courts with nothing due only compare their timer deadlines.
+ *
+ * @return Milliseconds until the earliest deadline of all courts, or -1 if
+ *         all courts are idle
+ */
+int32_t courts_advance(Court *courts, size_t num, uint32_t now);
+
+#endif /* GAME_H */
@@ -1,10 +1,22 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "driver/gpio.h"
 #include "driver/rmt.h" // Kept as per your request, though led_strip.h abstracts its use
 #include "led_strip.h"
+#include "game.h"
+#include "frame_clock.h"
+#include "ai.h"
+#include "netplay.h"
+#include "wifi.h"
+#include "pixel_node.h"
+#include "pixel_mirror.h"
 #include <stdio.h>
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "esp_system.h"
 #include <stdbool.h> // For bool type
 #include <inttypes.h> // For PRIu32 in ESP_LOG
 
@@ -15,82 +27,56 @@ static const char *TAG = "PongGame";
 #define BUTTON1_PIN GPIO_NUM_25 // Player Left
 #define BUTTON2_PIN GPIO_NUM_27 // Player Right
 
-#define PADDLE_SIZE 6     // Number of LEDs for the paddle (as seen in video)
-#define INITIAL_LIVES 5
-#define INITIAL_BALL_SPEED 0.5f        // Start speed (LEDs per update-cycle)
-#define BALL_SPEED_MULT 1.12f          // Multiplicative speed growth per successful hit
-#define BALL_SPEED_CAP 4.0f            // Max ball speed (LEDs per tick)
-#define PADDLE_HIT_FACTOR 0.25f        // Max +/- speed modifier based on hit position on paddle (25%)
-#define BALL_UPDATE_INTERVAL_MS 30     // Base ball tick interval (ms); shrinks with rally
-#define BALL_UPDATE_INTERVAL_MIN_MS 15 // Floor for tick interval at high rally counts
-#define GAME_LOOP_DELAY_MS 10          // Main loop delay (ms)
-
-typedef enum {
-    LEFT,
-    RIGHT,
-    STOP
-} direction_type;
-
-typedef enum {
-    GAME_STATE_INIT,          // Game initializing / Start screen
-    GAME_STATE_WAIT_SERVE,    // Waiting for serve
-    GAME_STATE_PLAYING,       // Ball is in play
-    GAME_STATE_POINT_SCORED,  // Point scored, brief pause
-    GAME_STATE_GAME_OVER      // Game over animation
-} GameState;
+#define BUTTON_DEBOUNCE_MS 20          // Edges closer than this to the previous one are contact bounce
+#define EVENT_QUEUE_LEN 16
+#define CLOCK_EVENT_COURT 0xff         // CourtEvent.court of frame clock wake-ups
+#define NODE_EVENT_COURT 0xfe          // CourtEvent.court of pixel node packets
+#define AI_SKILL 200                   // Computer player timing accuracy, 0..255
+#define AI_REACTION_MS 180             // Computer player reaction time
+#define WIFI_CONNECT_TIMEOUT_MS 20000
+
+// Each court plays on its own segment of the strip with its own pair of
+// buttons. Add entries to run several games on one controller; NUM_LEDS must
+// cover all segments. A reversed court has Player Left at the far end of its
+// stretch, e.g. for a strip folded back on itself. Set 'ai_player' for a
+// single-player court; the human keeps the other button.
+typedef struct {
+    int offset;          // First LED of the court on the strip
+    int length;          // Court length in LEDs
+    bool reversed;       // Court runs from the end of its stretch to the start
+    gpio_num_t button1;  // Player Left
+    gpio_num_t button2;  // Player Right
+    int ai_player;       // 0 = two humans, 1 or 2 = that player is the computer
+} CourtConfig;
+
+const CourtConfig court_configs[] = {
+    { 0, NUM_LEDS, false, BUTTON1_PIN, BUTTON2_PIN, 0 },
+};
+
+#define NUM_COURTS (sizeof(court_configs) / sizeof(court_configs[0]))
+#define NUM_BUTTONS (NUM_COURTS * 2)
 
 typedef struct {
     gpio_num_t pin;
-    bool currentState;
-    bool lastState;
-    bool justPressed;
+    uint8_t court;        // Index of the court the button belongs to
+    GameEvent event;      // Posted on every debounced press
+    bool pressed;         // Last seen level, true = pressed
+    int64_t last_edge_us; // Time of last level change, for debouncing
 } Button;
 
+// Queue item: an event for one court, or a frame clock wake-up
 typedef struct {
-    uint8_t lives;
-    direction_type side; // LEFT or RIGHT
-    uint32_t color;
-    int paddle_pos_start; // For rendering
-    int paddle_pos_end;   // For rendering
-} Player;
+    uint8_t court;        // Court index or CLOCK_EVENT_COURT
+    uint8_t event;        // GameEvent
+} CourtEvent;
 
-typedef struct {
-    float position;
-    direction_type direction;
-    float speed;
-    uint32_t color;
-} Ball;
-
-Button button_p1, button_p2;
-Player player1, player2;
-Ball ball;
-GameState currentGameState = GAME_STATE_INIT;
-Player *servingPlayer; // Pointer to the player who serves
-int rallyCount = 0;    // Successful hits in current game; drives difficulty curve (reset on game over)
-
-// --- Color Definitions (RGB) ---
-uint32_t colorToUint32(uint8_t r, uint8_t g, uint8_t b) {
-    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
-}
+Court courts[NUM_COURTS];
+AiPlayer ai_players[NUM_COURTS]; // Used by courts with an ai_player
+led_strip_segment_t court_segments[NUM_COURTS];
+Button buttons[NUM_BUTTONS];
 
-rgb_t uint32ToRgb(uint32_t color) {
-    return (rgb_t){
-        .r = (uint8_t)((color >> 16) & 0xFF),
-        .g = (uint8_t)((color >> 8) & 0xFF),
-        .b = (uint8_t)(color & 0xFF)
-    };
-}
-
-const uint32_t COLOR_BLACK = 0x000000;
-const uint32_t COLOR_WHITE = 0xFFFFFF;
-const uint32_t COLOR_RED = 0xFF0000;
-const uint32_t COLOR_GREEN = 0x00FF00;
-const uint32_t COLOR_BLUE = 0x0000FF;
-const uint32_t COLOR_P1_PADDLE = 0xFF0000; // Red for P1 (left button in video)
-const uint32_t COLOR_P2_PADDLE = 0x00FF00; // Green for P2 (right button in video)
-const uint32_t COLOR_BALL = 0x00FFFF;   // Cyan ball (was white, changed for visibility)
-const uint32_t COLOR_LIFE_ACTIVE = 0xFFFF00; // Yellow for active lives
-const uint32_t COLOR_LIFE_LOST = 0x400000; // Dim Red for lost lives
+QueueHandle_t event_queue; // Button events from the GPIO ISR, frame clock wake-ups
+frame_clock_t frame_clock; // Wakes the game task at the next court deadline
 
 led_strip_t strip;
 
@@ -101,481 +87,436 @@ void init_led_strip() {
     strip.gpio = LED_PIN;
     strip.buf = NULL; // Buffer will be allocated by the library
     strip.brightness = 60; // Reduce brightness (0-255)
+    strip.rgb_buf = true; // Court frames and network pixel data are RGB, the encoder reorders them
 
     led_strip_install(); // Call this first!
     ESP_ERROR_CHECK(led_strip_init(&strip));
     ESP_ERROR_CHECK(led_strip_flush(&strip)); // Turn all LEDs off
-    ESP_LOGI(TAG, "LED strip initialized.");
-}
 
-void set_pixel_color(int index, uint32_t color_val) {
-    if (index >= 0 && index < NUM_LEDS) {
-        ESP_ERROR_CHECK(led_strip_set_pixel(&strip, index, uint32ToRgb(color_val)));
+    for (int i = 0; i < NUM_COURTS; i++) {
+        const CourtConfig *config = &court_configs[i];
+        ESP_ERROR_CHECK(led_strip_segment_init(&court_segments[i], &strip, config->offset, config->length,
+                                               config->reversed, 0));
     }
+    ESP_LOGI(TAG, "LED strip initialized.");
 }
 
-void fill_color(uint32_t color_val) {
-    for (int i = 0; i < NUM_LEDS; i++) {
-        set_pixel_color(i, color_val);
+// --- Button Functions ---
+// Presses are detected by a GPIO interrupt on both edges. A press is only
+// reported when the button was released for at least BUTTON_DEBOUNCE_MS, so
+// contact bounce on press and on release never produces extra events.
+bool idle_exit_from_isr(int64_t now, bool pressed);
+bool ai_plays(int court, int player);
+
+void IRAM_ATTR button_isr(void *arg) {
+    Button *button = (Button *)arg;
+    int64_t now = esp_timer_get_time();
+    bool pressed = !gpio_get_level(button->pin); // Active low due to PULLUP_ONLY
+    bool posted = false;
+    BaseType_t woken = pdFALSE;
+    if (pressed != button->pressed) {
+        bool settled = (now - button->last_edge_us) >= BUTTON_DEBOUNCE_MS * 1000;
+        button->pressed = pressed;
+        button->last_edge_us = now;
+        if (pressed && settled) {
+            CourtEvent ev = { button->court, button->event };
+            xQueueSendFromISR(event_queue, &ev, &woken);
+            posted = true;
+        }
+    }
+    if (idle_exit_from_isr(now, posted)) {
+        CourtEvent wake = { button->court, EVENT_WAKE };
+        xQueueSendFromISR(event_queue, &wake, &woken);
+    }
+    if (woken) {
+        portYIELD_FROM_ISR();
     }
 }
 
-// --- Button Functions ---
 void init_buttons() {
-    button_p1.pin = BUTTON1_PIN;
-    button_p2.pin = BUTTON2_PIN;
-    Button *buttons[] = {&button_p1, &button_p2};
-
-    for (int i = 0; i < 2; i++) {
-        gpio_reset_pin(buttons[i]->pin);
-        gpio_set_direction(buttons[i]->pin, GPIO_MODE_INPUT);
-        gpio_set_pull_mode(buttons[i]->pin, GPIO_PULLUP_ONLY); // Assuming buttons pull to GND when pressed
-        buttons[i]->currentState = gpio_get_level(buttons[i]->pin); // Initialize with current level
-        buttons[i]->lastState = buttons[i]->currentState;
-        buttons[i]->justPressed = false;
+    ESP_ERROR_CHECK(gpio_install_isr_service(0));
+    for (int i = 0; i < NUM_BUTTONS; i++) {
+        Button *button = &buttons[i];
+        const CourtConfig *config = &court_configs[i / 2];
+        button->pin = (i % 2 == 0) ? config->button1 : config->button2;
+        button->court = i / 2;
+        button->event = (i % 2 == 0) ? EVENT_P1_PRESS : EVENT_P2_PRESS;
+        if (ai_plays(button->court, i % 2 + 1)) {
+            button->pin = GPIO_NUM_NC; // The computer presses for this player, the pin stays unused
+            continue;
+        }
+
+        gpio_reset_pin(button->pin);
+        gpio_set_direction(button->pin, GPIO_MODE_INPUT);
+        gpio_set_pull_mode(button->pin, GPIO_PULLUP_ONLY); // Assuming buttons pull to GND when pressed
+        button->pressed = !gpio_get_level(button->pin); // Initialize with current level
+        button->last_edge_us = esp_timer_get_time();
+        gpio_set_intr_type(button->pin, GPIO_INTR_ANYEDGE);
+        ESP_ERROR_CHECK(gpio_isr_handler_add(button->pin, button_isr, button));
     }
     ESP_LOGI(TAG, "Buttons initialized.");
 }
 
-void update_button(Button *button) {
-    button->lastState = button->currentState;
-    button->currentState = !gpio_get_level(button->pin); // Active low due to PULLUP_ONLY
-    button->justPressed = button->currentState && !button->lastState;
+// --- Timers ---
+// Court timers are deadlines in this millisecond clock. The game task blocks
+// on the event queue; the frame clock posts a wake-up when the earliest
+// deadline is reached. Waiting with a queue timeout instead would round every
+// ball tick up to whole FreeRTOS ticks (10 ms).
+uint32_t now_ms() {
+    return (uint32_t)(esp_timer_get_time() / 1000);
 }
 
-void process_input() {
-    update_button(&button_p1);
-    update_button(&button_p2);
+void frame_clock_wake(void *arg) {
+    CourtEvent ev = { CLOCK_EVENT_COURT, EVENT_WAKE };
+    xQueueSend(event_queue, &ev, 0); // A full queue wakes the task anyway
 }
 
-// --- Game Initialization ---
-void init_game_elements() {
-    player1.side = LEFT;
-    player1.lives = INITIAL_LIVES;
-    player1.color = COLOR_P1_PADDLE;
-    player1.paddle_pos_start = 0;
-    player1.paddle_pos_end = PADDLE_SIZE - 1;
-
-    player2.side = RIGHT;
-    player2.lives = INITIAL_LIVES;
-    player2.color = COLOR_P2_PADDLE;
-    player2.paddle_pos_start = NUM_LEDS - PADDLE_SIZE;
-    player2.paddle_pos_end = NUM_LEDS - 1;
-
-    ball.color = COLOR_BALL;
-    ball.speed = INITIAL_BALL_SPEED;
-    rallyCount = 0; // Reset difficulty ramp for a new game
-
-    // Alternate starting player or P1 starts
-    if (servingPlayer == &player1) {
-        servingPlayer = &player2;
-    } else {
-        servingPlayer = &player1;
-    }
-    // servingPlayer = &player1; // Player 1 always starts first game
-    
-    ESP_LOGI(TAG, "Game elements initialized. Player %s serves.", (servingPlayer == &player1) ? "1 (Left)" : "2 (Right)");
+void log_frame_clock_stats() {
+    frame_clock_stats_t *stats = &frame_clock.stats;
+    if (stats->frames == 0) return;
+    ESP_LOGI(TAG, "Frame clock: %" PRIu32 " frames, %" PRIu32 " overruns, late avg %lld us, max %lld us",
+             stats->frames, stats->overruns, (long long)(stats->late_total_us / stats->frames),
+             (long long)stats->late_max_us);
+    frame_clock_reset_stats(&frame_clock);
 }
 
-void prepare_serve() {
-    // Reset ball speed to the initial value for every new serve (after each point).
-    ball.speed = INITIAL_BALL_SPEED;
-    rallyCount = 0;
-    if (servingPlayer->side == LEFT) {
-        ball.position = player1.paddle_pos_end + 1.0f; // Just in front of the paddle
-        ball.direction = STOP; // Waits for action
-    } else {
-        ball.position = player2.paddle_pos_start - 1.0f;
-        ball.direction = STOP;
+// --- Netplay ---
+// With CONFIG_PONG_NETPLAY court 0 is shared with a second controller. It
+// runs on its own frame clock (NET_FRAME_MS frames numbered from the start
+// of the session), so it is left out of courts_advance() and its buttons
+// feed the local player of the session.
+#if CONFIG_PONG_NETPLAY
+#define FIRST_LOCAL_COURT 1
+NetSession netplay;
+uint32_t netplay_due_ms; // Wall time of the next netplay frame
+
+void init_netplay() {
+    if (!wifi_connect(CONFIG_PONG_WIFI_SSID, CONFIG_PONG_WIFI_PASSWORD, pdMS_TO_TICKS(WIFI_CONNECT_TIMEOUT_MS))) {
+        ESP_LOGW(TAG, "No WiFi yet, netplay waits for the peer.");
     }
-    currentGameState = GAME_STATE_WAIT_SERVE;
-    ESP_LOGI(TAG, "Prepare serve. Ball at %.1f, Player %s to serve.", ball.position, (servingPlayer == &player1) ? "1" : "2");
+    ESP_ERROR_CHECK(netplay_init(&netplay, &courts[0], CONFIG_PONG_NETPLAY_PLAYER, CONFIG_PONG_NETPLAY_PORT,
+                                 CONFIG_PONG_NETPLAY_PEER_IP, CONFIG_PONG_NETPLAY_PORT));
+    netplay_due_ms = now_ms();
 }
 
-// --- Game Logic ---
-// Computes a speed modifier (1.0 +/- up to PADDLE_HIT_FACTOR) based on where the
-// ball hit the paddle. Center = 0% (1.0). Front (toward opponent) = up to -25%.
-// Back (toward the player/wall) = up to +25%. Linearly interpolated.
-float paddle_hit_factor(Player *p, int ball_led_idx) {
-    // Normalized position along the paddle: 0.0 at paddle_pos_start, 1.0 at paddle_pos_end
-    float t;
-    if (PADDLE_SIZE > 1) {
-        t = (float)(ball_led_idx - p->paddle_pos_start) / (float)(PADDLE_SIZE - 1);
-    } else {
-        t = 0.5f;
+// Runs the netplay frames that are due; returns ms until the next one
+int32_t run_netplay(uint32_t now) {
+    netplay_poll(&netplay, now);
+    if ((int32_t)(now - netplay_due_ms) > NET_MAX_ROLLBACK * NET_FRAME_MS) {
+        netplay_due_ms = now; // Fell far behind, do not try to catch up
     }
-    if (t < 0.0f) t = 0.0f;
-    if (t > 1.0f) t = 1.0f;
-
-    // Map t (0..1) to -1..+1 where -1 = paddle_pos_start end, +1 = paddle_pos_end end
-    float rel = (t - 0.5f) * 2.0f; // -1 .. +1, 0 = center
-
-    // Determine which end is "front" (toward opponent) and which is "back" (toward player).
-    // P1 (LEFT): front = paddle_pos_end (t=1, rel=+1), back = paddle_pos_start (t=0, rel=-1)
-    // P2 (RIGHT): front = paddle_pos_start (t=0, rel=-1), back = paddle_pos_end (t=1, rel=+1)
-    float back_amount; // -1 (full front) .. +1 (full back)
-    if (p->side == LEFT) {
-        back_amount = -rel; // back is at start (rel=-1) -> +1
-    } else {
-        back_amount = rel;  // back is at end (rel=+1) -> +1
+    while ((int32_t)(now - netplay_due_ms) >= 0) {
+        netplay_advance(&netplay, now);
+        netplay_due_ms += NET_FRAME_MS;
     }
-
-    return 1.0f + back_amount * PADDLE_HIT_FACTOR;
+    return (int32_t)(netplay_due_ms - now);
+}
+#else
+#define FIRST_LOCAL_COURT 0
+#endif
+
+// --- Computer Players ---
+// Courts shared through netplay take their presses from the session only,
+// a press dispatched on them directly would desync the two controllers.
+// Elsewhere the button of the computer's player is not registered.
+bool ai_plays(int court, int player) {
+    return court >= FIRST_LOCAL_COURT && court_configs[court].ai_player == player;
 }
 
-// Handles a fresh button press during play: either a paddle hit (if the ball is
-// on the player's paddle and moving toward them) or a penalty (if they press
-// while the ball is approaching but NOT on their paddle).
-// Called every loop iteration so a press is never missed between ball ticks.
-void handle_paddle_input() {
-    int ball_led_idx = (int)(ball.position + 0.5f);
-
-    // Player 1 (left)
-    if (button_p1.justPressed && ball.direction == LEFT) {
-        if (ball_led_idx >= player1.paddle_pos_start && ball_led_idx <= player1.paddle_pos_end) {
-            // Hit
-            ESP_LOGI(TAG, "Player 1 hit! Ball at %d, Paddle [%d-%d]", ball_led_idx, player1.paddle_pos_start, player1.paddle_pos_end);
-            ball.direction = RIGHT;
-            ball.position = player1.paddle_pos_end + 0.1f;
-            rallyCount++;
-            ball.speed *= BALL_SPEED_MULT;
-            ball.speed *= paddle_hit_factor(&player1, ball_led_idx);
-            if (ball.speed > BALL_SPEED_CAP) ball.speed = BALL_SPEED_CAP;
-            if (ball.speed < INITIAL_BALL_SPEED) ball.speed = INITIAL_BALL_SPEED;
-            ESP_LOGI(TAG, "New ball speed: %.2f (rally %d)", ball.speed, rallyCount);
-        } else {
-            // Mis-press penalty: ball approaching but not on paddle
-            ESP_LOGI(TAG, "Player 1 mis-press penalty! Ball at %d", ball_led_idx);
-            player1.lives--;
-            servingPlayer = &player1;
-            currentGameState = GAME_STATE_POINT_SCORED;
+void init_ai_players() {
+    for (int i = 0; i < FIRST_LOCAL_COURT; i++) {
+        if (court_configs[i].ai_player) {
+            ESP_LOGW(TAG, "Court %d is shared through netplay, its computer player is ignored.", i);
         }
-        return;
     }
-
-    // Player 2 (right)
-    if (button_p2.justPressed && ball.direction == RIGHT) {
-        if (ball_led_idx >= player2.paddle_pos_start && ball_led_idx <= player2.paddle_pos_end) {
-            // Hit
-            ESP_LOGI(TAG, "Player 2 hit! Ball at %d, Paddle [%d-%d]", ball_led_idx, player2.paddle_pos_start, player2.paddle_pos_end);
-            ball.direction = LEFT;
-            ball.position = player2.paddle_pos_start - 0.1f;
-            rallyCount++;
-            ball.speed *= BALL_SPEED_MULT;
-            ball.speed *= paddle_hit_factor(&player2, ball_led_idx);
-            if (ball.speed > BALL_SPEED_CAP) ball.speed = BALL_SPEED_CAP;
-            if (ball.speed < INITIAL_BALL_SPEED) ball.speed = INITIAL_BALL_SPEED;
-            ESP_LOGI(TAG, "New ball speed: %.2f (rally %d)", ball.speed, rallyCount);
-        } else {
-            // Mis-press penalty: ball approaching but not on paddle
-            ESP_LOGI(TAG, "Player 2 mis-press penalty! Ball at %d", ball_led_idx);
-            player2.lives--;
-            servingPlayer = &player2;
-            currentGameState = GAME_STATE_POINT_SCORED;
+    for (int i = FIRST_LOCAL_COURT; i < NUM_COURTS; i++) {
+        if (court_configs[i].ai_player) {
+            ai_init(&ai_players[i], court_configs[i].ai_player, AI_SKILL, AI_REACTION_MS, esp_random());
         }
-        return;
     }
 }
 
-void update_ball_position() {
-    if (ball.direction == LEFT) {
-        ball.position -= ball.speed;
-    } else if (ball.direction == RIGHT) {
-        ball.position += ball.speed;
-    }
-
-    // Collision with Walls (Points)
-    if (ball.position < 0) { // Ball went past player 1
-        ESP_LOGI(TAG, "Ball out on left. Player 2 scores.");
-        player1.lives--;
-        servingPlayer = &player1; // Loser serves
-        currentGameState = GAME_STATE_POINT_SCORED;
-        return; // Exit early as point is scored
-    } else if (ball.position >= NUM_LEDS -1) { // Ball went past player 2
-        ESP_LOGI(TAG, "Ball out on right. Player 1 scores.");
-        player2.lives--;
-        servingPlayer = &player2; // Loser serves
-        currentGameState = GAME_STATE_POINT_SCORED;
-        return; // Exit early
+// Feeds due AI presses into the courts; returns ms until the next planned
+// press, or -1 if none. 'pressed' tells if any court got a press.
+int32_t update_ai_players(uint32_t now, bool *pressed) {
+    int32_t next = -1;
+    *pressed = false;
+    for (int i = FIRST_LOCAL_COURT; i < NUM_COURTS; i++) {
+        if (!court_configs[i].ai_player) continue;
+        bool press;
+        int32_t remaining = ai_update(&ai_players[i], &courts[i], now, &press);
+        if (press) {
+            court_dispatch(&courts[i], court_configs[i].ai_player == 1 ? EVENT_P1_PRESS : EVENT_P2_PRESS, now);
+            *pressed = true;
+        }
+        if (remaining >= 0 && (next < 0 || remaining < next)) {
+            next = remaining;
+        }
     }
+    return next;
 }
 
-void rainbowCycle(int wait_ms, int cycles) {
-    uint16_t i, j;
-    for (j = 0; j < 256 * cycles; j++) { // 5 cycles of all colors on wheel
-        if (currentGameState != GAME_STATE_INIT && currentGameState != GAME_STATE_GAME_OVER) return;
-        for (i = 0; i < NUM_LEDS; i++) {
-            uint8_t r, g, b;
-            uint8_t wheelpos = ((i * 256 / NUM_LEDS) + j) & 255;
-            if (wheelpos < 85) { // R to G
-                r = 255 - wheelpos * 3;
-                g = wheelpos * 3;
-                b = 0;
-            } else if (wheelpos < 170) { // G to B
-                wheelpos -= 85;
-                r = 0;
-                g = 255 - wheelpos * 3;
-                b = wheelpos * 3;
-            } else { // B to R
-                wheelpos -= 170;
-                r = wheelpos * 3;
-                g = 0;
-                b = 255 - wheelpos * 3;
-            }
-            set_pixel_color(i, colorToUint32(r,g,b));
-        }
-        led_strip_flush(&strip);
-        vTaskDelay(pdMS_TO_TICKS(wait_ms));
+// --- Pixel Node ---
+// With CONFIG_PONG_PIXEL_NODE the strip shows network pixel data while all
+// courts are idle. A small task waits for packets and wakes the game task,
+// which receives them into the strip buffer (or drops them during a match).
+// The next button event hands the strip back to the courts and is not
+// played: a serve should not start behind the player who woke the courts.
+#if CONFIG_PONG_PIXEL_NODE
+#if CONFIG_PONG_PIXEL_NODE_E131
+#define PIXEL_NODE_PROTOCOL PIXEL_NODE_E131
+#define PIXEL_NODE_UNIVERSE CONFIG_PONG_PIXEL_NODE_UNIVERSE
+#else
+#define PIXEL_NODE_PROTOCOL PIXEL_NODE_DDP
+#define PIXEL_NODE_UNIVERSE 0
+#endif
+#define PIXEL_NODE_WAIT_MS 1000
+
+pixel_node_t pixel_node;
+TaskHandle_t pixel_node_waiter;
+bool pixel_node_shown; // Strip shows node frames, courts must redraw
+
+void pixel_node_task(void *pvParameters) {
+    while (true) {
+        if (pixel_node_wait(&pixel_node, PIXEL_NODE_WAIT_MS) != ESP_OK) continue;
+        CourtEvent ev = { NODE_EVENT_COURT, EVENT_WAKE };
+        xQueueSend(event_queue, &ev, portMAX_DELAY);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Until the game task has read the packets
     }
 }
 
-
-void knightRiderAnimation(uint32_t color, int width, int repeats, int anim_speed_ms) {
-    ESP_LOGI(TAG, "Knight Rider Animation Start");
-    for (int r = 0; r < repeats; r++) {
-        // Forward
-        for (int i = 0; i <= NUM_LEDS - width; i++) {
-            if (currentGameState != GAME_STATE_INIT && currentGameState != GAME_STATE_GAME_OVER) {
-                ESP_LOGI(TAG, "Knight Rider interrupted by state change.");
-                return;
-            }
-            fill_color(COLOR_BLACK);
-            for (int k = 0; k < width; k++) {
-                set_pixel_color(i + k, color);
-            }
-            led_strip_flush(&strip);
-            vTaskDelay(pdMS_TO_TICKS(anim_speed_ms));
-        }
-        // Backward
-        for (int i = NUM_LEDS - width -1; i >= 0; i--) {
-             if (currentGameState != GAME_STATE_INIT && currentGameState != GAME_STATE_GAME_OVER) {
-                ESP_LOGI(TAG, "Knight Rider interrupted by state change.");
-                return;
-            }
-            fill_color(COLOR_BLACK);
-            for (int k = 0; k < width; k++) {
-                set_pixel_color(i + k, color);
-            }
-            led_strip_flush(&strip);
-            vTaskDelay(pdMS_TO_TICKS(anim_speed_ms));
-        }
+void init_pixel_node() {
+    if (!wifi_connect(CONFIG_PONG_WIFI_SSID, CONFIG_PONG_WIFI_PASSWORD, pdMS_TO_TICKS(WIFI_CONNECT_TIMEOUT_MS))) {
+        ESP_LOGW(TAG, "No WiFi yet, pixel node waits for it.");
     }
-    ESP_LOGI(TAG, "Knight Rider Animation End");
+    ESP_ERROR_CHECK(pixel_node_init(&pixel_node, &strip, PIXEL_NODE_PROTOCOL, 0, PIXEL_NODE_UNIVERSE));
+    xTaskCreate(pixel_node_task, "pixel_node", 3072, NULL, 4, &pixel_node_waiter);
 }
 
-void game_update_logic() {
-    static uint32_t last_ball_update_time = 0;
-    uint32_t current_time_ms = esp_log_timestamp();
-
-    switch (currentGameState) {
-        case GAME_STATE_INIT:
-            ESP_LOGI(TAG, "State: GAME_STATE_INIT");
-            // knightRiderAnimation(COLOR_RED, 5, 1, 30); // Start animation
-            rainbowCycle(10, 2);
-            init_game_elements(); // Sets lives, player data
-            prepare_serve();      // Sets ball position, direction=STOP, and state to WAIT_SERVE
-            break;
-
-        case GAME_STATE_WAIT_SERVE:
-            // Ball is positioned by prepare_serve(), waiting for button
-            if (servingPlayer == &player1 && button_p1.justPressed) {
-                ball.direction = RIGHT;
-                currentGameState = GAME_STATE_PLAYING;
-                ESP_LOGI(TAG, "Player 1 serves right.");
-            } else if (servingPlayer == &player2 && button_p2.justPressed) {
-                ball.direction = LEFT;
-                currentGameState = GAME_STATE_PLAYING;
-                ESP_LOGI(TAG, "Player 2 serves left.");
-            }
-            // Show serving player's paddle blinking
-            if ((current_time_ms / 250) % 2 == 0) { // Blink every 250ms
-                if (servingPlayer == &player1) set_pixel_color(player1.paddle_pos_start + PADDLE_SIZE/2, player1.color);
-                else set_pixel_color(player2.paddle_pos_start + PADDLE_SIZE/2, player2.color);
-            } else {
-                 if (servingPlayer == &player1) set_pixel_color(player1.paddle_pos_start + PADDLE_SIZE/2, COLOR_BLACK);
-                 else set_pixel_color(player2.paddle_pos_start + PADDLE_SIZE/2, COLOR_BLACK);
-            }
-            break;
-
-        case GAME_STATE_PLAYING: {
-            // Handle paddle hits / mis-press penalties every loop so a fresh
-            // button press is never missed between (slower) ball ticks.
-            handle_paddle_input();
-            if (currentGameState != GAME_STATE_PLAYING) {
-                break; // A penalty may have ended the rally
-            }
-
-            // Dynamic tick interval: shrinks as the rally grows, clamped to a floor
-            uint32_t ball_tick_interval = BALL_UPDATE_INTERVAL_MS - (rallyCount / 2);
-            if (ball_tick_interval < BALL_UPDATE_INTERVAL_MIN_MS) {
-                ball_tick_interval = BALL_UPDATE_INTERVAL_MIN_MS;
-            }
-            if ((current_time_ms - last_ball_update_time) >= ball_tick_interval) {
-                update_ball_position();
-                last_ball_update_time = current_time_ms;
-            }
-            // Check for game over directly if a point was scored by update_ball_position
-            if (currentGameState == GAME_STATE_POINT_SCORED) { // update_ball_position might change state
-                 // Fall through to POINT_SCORED logic below
-            } else if (player1.lives == 0 || player2.lives == 0) {
-                currentGameState = GAME_STATE_GAME_OVER;
-            }
-            break;
-        }
-
-        case GAME_STATE_POINT_SCORED:
-            ESP_LOGI(TAG, "State: GAME_STATE_POINT_SCORED. P1 Lives: %d, P2 Lives: %d", player1.lives, player2.lives);
-            fill_color(COLOR_BLACK); // All off
-
-            Player *scorer = (servingPlayer == &player1) ? &player2 : &player1; // Scorer is the one NOT serving next
-            int start_led = (scorer == &player1) ? 0 : NUM_LEDS / 2;
-            int end_led = (scorer == &player1) ? NUM_LEDS / 2 : NUM_LEDS;
-
-            for(int i=0; i<3; i++){ // Blink scorer's side
-                for(int j=start_led; j < end_led; j++) set_pixel_color(j, scorer->color);
-                led_strip_flush(&strip);
-                vTaskDelay(pdMS_TO_TICKS(200));
-                for(int j=start_led; j < end_led; j++) set_pixel_color(j, COLOR_BLACK);
-                led_strip_flush(&strip);
-                vTaskDelay(pdMS_TO_TICKS(200));
-            }
-            vTaskDelay(pdMS_TO_TICKS(600)); // Longer pause after animation
-
-            if (player1.lives == 0 || player2.lives == 0) {
-                currentGameState = GAME_STATE_GAME_OVER;
-            } else {
-                prepare_serve(); // Prepares next serve and sets state to WAIT_SERVE
-            }
-            break;
-
-        case GAME_STATE_GAME_OVER:
-            ESP_LOGI(TAG, "State: GAME_STATE_GAME_OVER!");
-            uint32_t winner_color = (player1.lives > 0) ? player1.color : player2.color;
-            const char* winner_text = (player1.lives > 0) ? "Player 1" : "Player 2";
-            ESP_LOGI(TAG, "%s WINS!", winner_text);
-
-            // Flash winner color
-            for(int i=0; i<5; i++){
-                fill_color(winner_color);
-                led_strip_flush(&strip);
-                vTaskDelay(pdMS_TO_TICKS(250));
-                fill_color(COLOR_BLACK);
-                led_strip_flush(&strip);
-                vTaskDelay(pdMS_TO_TICKS(250));
-                 if (button_p1.justPressed || button_p2.justPressed) break; // Allow early exit
-            }
-            rainbowCycle(15, 3); // Victory lap!
-
-            // Wait for a button press to restart
-            ESP_LOGI(TAG, "Press any button to restart.");
-            bool button_pressed_for_restart = false;
-            while(!button_pressed_for_restart) {
-                process_input(); // Keep updating button states
-                if (button_p1.justPressed || button_p2.justPressed) {
-                    button_pressed_for_restart = true;
-                }
-                vTaskDelay(pdMS_TO_TICKS(50)); // Check for button press periodically
-            }
-            currentGameState = GAME_STATE_INIT; // Back to start
-            break;
+void run_pixel_node(bool courts_idle) {
+    if (courts_idle) {
+        uint32_t frames;
+        pixel_node_receive(&pixel_node, &frames);
+        if (frames) pixel_node_shown = true;
+    } else {
+        pixel_node_discard(&pixel_node);
     }
+    xTaskNotifyGive(pixel_node_waiter);
 }
 
-// --- Rendering ---
-void render_paddles_and_lives() {
-    // Player 1 Paddle
-    for (int i = 0; i < PADDLE_SIZE; i++) {
-        set_pixel_color(player1.paddle_pos_start + i, player1.color);
+// Gives the strip back to the courts; returns false if they had it already
+bool pixel_node_release() {
+    if (!pixel_node_shown) return false;
+    pixel_node_shown = false;
+    pixel_node_stats_t *stats = &pixel_node.stats;
+    ESP_LOGI(TAG, "Pixel node: %" PRIu32 " frames, %" PRIu32 " packets, %" PRIu32 " dropped, %" PRIu32 " late",
+             stats->frames, stats->packets, stats->dropped, stats->late);
+    pixel_node_reset_stats(&pixel_node);
+    led_strip_fill(&strip, 0, NUM_LEDS, (rgb_t){ 0 });
+    for (int i = 0; i < NUM_COURTS; i++) {
+        court_invalidate(&courts[i]);
     }
-    // Player 1 Lives (display next to paddle)
-    // Display active lives first, then lost lives
-    int life_led_idx_p1 = player1.paddle_pos_end + 2; // Start lives display 1 LED away from paddle
-    for (int i = 0; i < INITIAL_LIVES; i++) {
-        if (life_led_idx_p1 + i < NUM_LEDS / 2 - PADDLE_SIZE) { // Ensure lives don't overlap P2 area
-            if (i < player1.lives) {
-                set_pixel_color(life_led_idx_p1 + i, COLOR_LIFE_ACTIVE);
-            } else {
-                set_pixel_color(life_led_idx_p1 + i, COLOR_LIFE_LOST);
-            }
-        }
+    return true;
+}
+#endif
+
+// --- Spectator Mirror ---
+// With CONFIG_PONG_MIRROR every flushed frame is also streamed to a remote
+// DDP node. The mirror hooks into the strip and sends from its own task, so
+// rendering never waits for the network.
+#if CONFIG_PONG_MIRROR
+pixel_mirror_t mirror;
+
+void init_mirror() {
+    if (!wifi_connect(CONFIG_PONG_WIFI_SSID, CONFIG_PONG_WIFI_PASSWORD, pdMS_TO_TICKS(WIFI_CONNECT_TIMEOUT_MS))) {
+        ESP_LOGW(TAG, "No WiFi yet, the mirror sends once it is up.");
     }
+    pixel_mirror_config_t config = {
+        .peers = { CONFIG_PONG_MIRROR_PEER_IP },
+        .max_fps = CONFIG_PONG_MIRROR_MAX_FPS,
+    };
+    ESP_ERROR_CHECK(pixel_mirror_init(&mirror, &strip, &config));
+}
+#endif
+
+// --- Idle ---
+// With no timer armed on any court nothing is animating and the game task
+// blocks on the event queue without timeout. Before it does, it releases its
+// power management lock so FreeRTOS tickless idle can put the chip into
+// light sleep, and switches the buttons to level-triggered GPIO wake-up
+// (edge interrupts cannot wake the chip). The first button interrupt
+// restores edge interrupts and takes the lock again.
+portMUX_TYPE idle_mux = portMUX_INITIALIZER_UNLOCKED;
+volatile bool idle_active = false;
+volatile int64_t idle_wake_us = 0; // Interrupt time of the press that ended idle, 0 if none pending
+#if CONFIG_PM_ENABLE
+esp_pm_lock_handle_t awake_lock;   // Held (CPU at max frequency, no light sleep) except when idle
+#endif
+
+void init_idle() {
+#if CONFIG_PM_ENABLE
+    esp_pm_config_esp32_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = 40,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#endif
+    };
+    ESP_ERROR_CHECK(esp_pm_configure(&pm_config));
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "game", &awake_lock));
+    ESP_ERROR_CHECK(esp_pm_lock_acquire(awake_lock));
+    ESP_ERROR_CHECK(esp_sleep_enable_gpio_wakeup());
+#endif
+}
 
-    // Player 2 Paddle
-    for (int i = 0; i < PADDLE_SIZE; i++) {
-        set_pixel_color(player2.paddle_pos_start + i, player2.color);
-    }
-    // Player 2 Lives
-    int life_led_idx_p2 = player2.paddle_pos_start - 2; // Start lives display 1 LED away from paddle
-    for (int i = 0; i < INITIAL_LIVES; i++) {
-         if (life_led_idx_p2 - i > NUM_LEDS / 2 + PADDLE_SIZE) { // Ensure lives don't overlap P1 area
-            if (i < player2.lives) {
-                set_pixel_color(life_led_idx_p2 - i, COLOR_LIFE_ACTIVE);
-            } else {
-                set_pixel_color(life_led_idx_p2 - i, COLOR_LIFE_LOST);
-            }
-        }
+void idle_enter() {
+    if (idle_active) return;
+    log_frame_clock_stats();
+    ESP_LOGI(TAG, "Idle, waiting for button wake-up.");
+
+    portENTER_CRITICAL(&idle_mux);
+    idle_active = true;
+#if CONFIG_PM_ENABLE
+    // Wake on the opposite of the current level, so a held button wakes on release
+    for (int i = 0; i < NUM_BUTTONS; i++) {
+        if (buttons[i].pin == GPIO_NUM_NC) continue;
+        gpio_wakeup_enable(buttons[i].pin, buttons[i].pressed ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
     }
+#endif
+    portEXIT_CRITICAL(&idle_mux);
+
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_release(awake_lock);
+#endif
 }
 
-void render_ball() {
-    // Render ball only if it's in play or waiting for serve
-    if (currentGameState == GAME_STATE_PLAYING || currentGameState == GAME_STATE_WAIT_SERVE) {
-        int ball_led_idx = (int)(ball.position + 0.5f); // Round to nearest LED
-        if (ball_led_idx >=0 && ball_led_idx < NUM_LEDS) {
-             set_pixel_color(ball_led_idx, ball.color);
+// Called from every button interrupt; returns true if it ended idle mode.
+// 'pressed' records the wake time for the latency measurement, a wake by
+// releasing a held button has no frame to measure.
+bool IRAM_ATTR idle_exit_from_isr(int64_t now, bool pressed) {
+    bool exited = false;
+    portENTER_CRITICAL_ISR(&idle_mux);
+    if (idle_active) {
+        idle_active = false;
+        exited = true;
+        if (pressed) idle_wake_us = now;
+#if CONFIG_PM_ENABLE
+        esp_pm_lock_acquire(awake_lock);
+        for (int i = 0; i < NUM_BUTTONS; i++) {
+            if (buttons[i].pin == GPIO_NUM_NC) continue;
+            gpio_wakeup_disable(buttons[i].pin);
+            gpio_set_intr_type(buttons[i].pin, GPIO_INTR_ANYEDGE);
         }
+#endif
     }
+    portEXIT_CRITICAL_ISR(&idle_mux);
+    return exited;
 }
 
-void draw_game() {
-    // These states handle their own full-strip animations/displays
-    if (currentGameState == GAME_STATE_INIT || 
-        currentGameState == GAME_STATE_GAME_OVER || 
-        currentGameState == GAME_STATE_POINT_SCORED) {
-        return;
-    }
+// Logs the time from the wake-up press to the end of the first frame drawn
+// for it. Light sleep exit itself happens before the interrupt and is not
+// included.
+void idle_log_wake_latency() {
+    if (idle_wake_us == 0) return;
+    ESP_LOGI(TAG, "Wake-to-first-frame latency: %lld us", (long long)(esp_timer_get_time() - idle_wake_us));
+    idle_wake_us = 0;
+}
 
-    fill_color(COLOR_BLACK); // Clear background for dynamic elements
-    render_paddles_and_lives();
-    render_ball();
-    
-    // Blinking effect for serving player in WAIT_SERVE is handled in game_update_logic
-    // but we need to ensure the paddle is drawn consistently otherwise.
-    if (currentGameState == GAME_STATE_WAIT_SERVE) {
-        // Re-draw the serving player's paddle center to ensure it's visible
-        // (as the blinking logic in update might turn it off just before flush)
-        uint32_t current_time_ms = esp_log_timestamp();
-        bool show_blink = (current_time_ms / 250) % 2 == 0;
-        if (servingPlayer == &player1) {
-            set_pixel_color(player1.paddle_pos_start + PADDLE_SIZE/2, show_blink ? player1.color : COLOR_BLACK);
-        } else {
-            set_pixel_color(player2.paddle_pos_start + PADDLE_SIZE/2, show_blink ? player2.color : COLOR_BLACK);
+// --- Rendering ---
+// All courts share the strip: each changed court frame is copied straight
+// into its segment of the strip buffer, and the strip is flushed once if any
+// court changed. The strip buffer is in RGB order (rgb_buf), so the blit is
+// a plain copy of the rgb_t frame; the encoder reorders for the wire.
+void draw_courts() {
+    bool any_changed = false;
+    for (int i = 0; i < NUM_COURTS; i++) {
+        bool changed;
+        const rgb_t *frame = court_render(&courts[i], &changed);
+        if (changed) {
+            led_strip_segment_blit(&court_segments[i], 0, court_configs[i].length, frame);
+            any_changed = true;
         }
     }
-
-
-    led_strip_flush(&strip);
+    if (any_changed) {
+        led_strip_flush(&strip);
+    }
 }
 
 // --- Main Task ---
+// The task only wakes for a button event or when the frame clock reaches the
+// next court deadline; while nothing is scheduled it goes idle.
 void game_task(void *pvParameters) {
     ESP_LOGI(TAG, "Game task started.");
     init_led_strip();
+    event_queue = xQueueCreate(EVENT_QUEUE_LEN, sizeof(CourtEvent));
     init_buttons();
-    
-    currentGameState = GAME_STATE_INIT; // Initial state
+    ESP_ERROR_CHECK(frame_clock_init(&frame_clock, frame_clock_wake, NULL));
+    init_idle();
+
+    for (int i = 0; i < NUM_COURTS; i++) {
+        ESP_ERROR_CHECK(court_init(&courts[i], i, court_configs[i].length));
+        court_start(&courts[i], now_ms());
+    }
+    init_ai_players();
+#if CONFIG_PONG_NETPLAY
+    init_netplay();
+#endif
+#if CONFIG_PONG_PIXEL_NODE
+    init_pixel_node();
+#endif
+#if CONFIG_PONG_MIRROR
+    init_mirror();
+#endif
 
     while (true) {
-        process_input();        // Read button states
-        game_update_logic();    // Update game state machine and entity logic
-        draw_game();            // Render current game state to LEDs
-        vTaskDelay(pdMS_TO_TICKS(GAME_LOOP_DELAY_MS));
+        int64_t now_us = esp_timer_get_time();
+        uint32_t now = now_us / 1000;
+        int32_t next_ms, ai_ms;
+        bool ai_pressed;
+        do { // A press changes the court, let the timers and the AI see it
+            next_ms = courts_advance(courts + FIRST_LOCAL_COURT, NUM_COURTS - FIRST_LOCAL_COURT, now);
+            ai_ms = update_ai_players(now, &ai_pressed);
+        } while (ai_pressed);
+        if (ai_ms >= 0 && (next_ms < 0 || ai_ms < next_ms)) next_ms = ai_ms;
+#if CONFIG_PONG_NETPLAY
+        int32_t net_ms = run_netplay(now);
+        if (next_ms < 0 || net_ms < next_ms) next_ms = net_ms;
+#endif
+        draw_courts();          // Render all courts to LEDs
+        idle_log_wake_latency();
+
+        if (next_ms < 0) {
+            frame_clock_disarm(&frame_clock);
+            idle_enter();
+        } else {
+            frame_clock_arm(&frame_clock, (now_us / 1000 + next_ms) * 1000);
+        }
+
+        CourtEvent ev;
+        xQueueReceive(event_queue, &ev, portMAX_DELAY);
+#if CONFIG_PONG_PIXEL_NODE
+        // The press that takes the strip back only brings the courts up again
+        if (ev.court != CLOCK_EVENT_COURT && ev.court != NODE_EVENT_COURT && pixel_node_release()) continue;
+#endif
+        if (ev.court == CLOCK_EVENT_COURT) {
+            frame_clock_tick(&frame_clock, esp_timer_get_time());
+#if CONFIG_PONG_PIXEL_NODE
+        } else if (ev.court == NODE_EVENT_COURT) {
+            run_pixel_node(next_ms < 0);
+#endif
+#if CONFIG_PONG_NETPLAY
+        } else if (ev.court == 0) {
+            if (ev.event == EVENT_P1_PRESS || ev.event == EVENT_P2_PRESS) netplay_press(&netplay);
+#endif
+        } else {
+            court_dispatch(&courts[ev.court], (GameEvent)ev.event, now_ms());
+        }
     }
 }
 
 void app_main(void) {
     esp_log_level_set(TAG, ESP_LOG_INFO); // Set log level for this tag
     // esp_log_level_set("*", ESP_LOG_ERROR); // Optionally, reduce general ESP-IDF logging
-    
+
     xTaskCreate(game_task, "game_task", 4096 * 2, NULL, 5, NULL); // Increased stack for safety
-}
\ No newline at end of file
+}
@@ -0,0 +1,231 @@
+#include "netplay.h"
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include "esp_log.h"
+#ifdef ESP_PLATFORM
+#include "esp_system.h"
+#else
+#include <time.h>
+#endif
+
+static const char *TAG = "Netplay";
+
+#define NET_MAGIC 0x31504e47   // "GNP1"
+
+// Inputs of one player for frames first..first+count-1, bit i = press in
+// frame first+i
+typedef struct {
+    uint32_t magic;
+    uint32_t first;
+    uint32_t ack;              // Sender has the receiver's inputs for all frames before this
+    uint32_t session;          // Sender's session id
+    uint32_t peer_session;     // Receiver's session id as the sender knows it, 0 if not yet
+    uint8_t count;
+    uint8_t bits[NET_RING / 8];
+} NetPacket;
+
+#define SLOT(frame) ((frame) & (NET_RING - 1))
+
+// A new id on every start, different from the last one and never 0
+static uint32_t new_session_id(NetSession *net) {
+    uint32_t id;
+    do {
+#ifdef ESP_PLATFORM
+        id = esp_random();
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        id = (uint32_t)ts.tv_nsec ^ (uint32_t)ts.tv_sec << 12 ^ (uint32_t)getpid() << 20 ^ random32_r(&net->sim_rng);
+#endif
+    } while (!id || id == net->session);
+    return id;
+}
+
+esp_err_t netplay_init(NetSession *net, Court *court, int local_player, uint16_t local_port,
+                       const char *peer_ip, uint16_t peer_port) {
+    *net = (NetSession){ .court = court, .local_player = local_player, .rollback_from = UINT32_MAX, .sock = -1 };
+    random_state_init(&net->sim_rng, local_port, local_player);
+    net->session = new_session_id(net);
+
+    net->peer.sin_family = AF_INET;
+    net->peer.sin_port = htons(peer_port);
+    if (inet_pton(AF_INET, peer_ip, &net->peer.sin_addr) != 1) {
+        ESP_LOGE(TAG, "Bad peer address %s", peer_ip);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    net->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (net->sock < 0) {
+        ESP_LOGE(TAG, "socket() failed");
+        return ESP_FAIL;
+    }
+    struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = htons(local_port),
+                                 .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if (bind(net->sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        ESP_LOGE(TAG, "bind() to port %d failed", local_port);
+        netplay_free(net);
+        return ESP_FAIL;
+    }
+    fcntl(net->sock, F_SETFL, fcntl(net->sock, F_GETFL, 0) | O_NONBLOCK);
+
+    // Both ends start from the same state at frame 0
+    court_start(court, 0);
+    ESP_LOGI(TAG, "Player %d, port %d, peer %s:%d, session %08" PRIx32, local_player, local_port, peer_ip, peer_port,
+             net->session);
+    return ESP_OK;
+}
+
+void netplay_free(NetSession *net) {
+    if (net->sock >= 0) close(net->sock);
+    net->sock = -1;
+}
+
+void netplay_press(NetSession *net) {
+    net->pending_press = true;
+}
+
+// --- Transport ---
+void net_sendto(NetSession *net, const void *data, size_t len) {
+    sendto(net->sock, data, len, 0, (struct sockaddr *)&net->peer, sizeof(net->peer));
+    net->stats.sent++;
+}
+
+void net_send(NetSession *net, const void *data, size_t len, uint32_t now_ms) {
+    if (net->sim_loss_pct && random8_to_r(&net->sim_rng, 100) < net->sim_loss_pct) {
+        net->stats.sent++;
+        return;
+    }
+    if (!net->sim_delay_ms) {
+        net_sendto(net, data, len);
+        return;
+    }
+    if (net->sim_queued == NET_SIM_QUEUE || len > sizeof(net->sim_queue[0].data)) return; // Lost
+    NetDelayedPacket *p = &net->sim_queue[net->sim_queued++];
+    p->release_ms = now_ms + net->sim_delay_ms;
+    p->len = len;
+    memcpy(p->data, data, len);
+}
+
+// Sends all local inputs the peer has not acknowledged
+void net_send_inputs(NetSession *net, uint32_t now_ms) {
+    uint32_t known = net->frame + NET_INPUT_DELAY; // Local inputs recorded before this frame
+    uint32_t first = net->peer_ack;
+    if (known - first > NET_RING) first = known - NET_RING;
+
+    NetPacket pkt = { .magic = NET_MAGIC, .first = first, .ack = net->remote_confirmed, .session = net->session,
+                      .peer_session = net->peer_session, .count = known - first };
+    for (uint32_t f = first; f < known; f++) {
+        if (net->local_input[SLOT(f)]) pkt.bits[(f - first) / 8] |= 1 << ((f - first) % 8);
+    }
+    net_send(net, &pkt, sizeof(pkt), now_ms);
+}
+
+// Back to frame 0 with a new id after the peer started a new session; the
+// peer starts from the same state
+void net_restart(NetSession *net) {
+    net->frame = net->remote_confirmed = net->peer_ack = 0;
+    net->rollback_from = UINT32_MAX;
+    net->pending_press = false;
+    memset(net->local_input, 0, sizeof(net->local_input));
+    memset(net->remote_input, 0, sizeof(net->remote_input));
+    net->sim_queued = 0; // Packets of the old session
+    net->session = new_session_id(net);
+    net->stats.restarts++;
+    court_start(net->court, 0);
+}
+
+void net_receive(NetSession *net, const NetPacket *pkt) {
+    if (pkt->magic != NET_MAGIC || pkt->count > NET_RING || !pkt->session) return;
+    // Sent to an earlier session of ours, before the peer saw it restart
+    if (pkt->peer_session && pkt->peer_session != net->session) return;
+    if (pkt->session != net->peer_session) {
+        if (net->peer_session) {
+            ESP_LOGW(TAG, "Peer restarted (session %08" PRIx32 "), restarting at frame 0", pkt->session);
+            net_restart(net);
+        }
+        net->peer_session = pkt->session;
+    }
+    net->stats.received++;
+    if ((int32_t)(pkt->ack - net->peer_ack) > 0) net->peer_ack = pkt->ack;
+
+    // Only a packet that continues the known inputs is usable
+    uint32_t end = pkt->first + pkt->count;
+    if ((int32_t)(pkt->first - net->remote_confirmed) > 0 || (int32_t)(end - net->remote_confirmed) <= 0) return;
+
+    for (uint32_t f = net->remote_confirmed; f != end; f++) {
+        uint8_t press = (pkt->bits[(f - pkt->first) / 8] >> ((f - pkt->first) % 8)) & 1;
+        // Frames before net->frame were simulated with a prediction
+        if ((int32_t)(f - net->frame) < 0 && press != net->remote_input[SLOT(f)] &&
+            (net->rollback_from == UINT32_MAX || (int32_t)(f - net->rollback_from) < 0)) {
+            net->rollback_from = f;
+        }
+        net->remote_input[SLOT(f)] = press;
+    }
+    net->remote_confirmed = end;
+}
+
+void netplay_poll(NetSession *net, uint32_t now_ms) {
+    // Release delayed test packets in order
+    int sent = 0;
+    while (sent < net->sim_queued && (int32_t)(now_ms - net->sim_queue[sent].release_ms) >= 0) {
+        net_sendto(net, net->sim_queue[sent].data, net->sim_queue[sent].len);
+        sent++;
+    }
+    if (sent) {
+        net->sim_queued -= sent;
+        memmove(net->sim_queue, net->sim_queue + sent, net->sim_queued * sizeof(NetDelayedPacket));
+    }
+
+    NetPacket pkt;
+    while (recv(net->sock, &pkt, sizeof(pkt), 0) == sizeof(pkt)) {
+        net_receive(net, &pkt);
+    }
+}
+
+// --- Simulation ---
+void net_simulate(NetSession *net, uint32_t frame) {
+    court_snapshot(net->court, &net->snapshots[SLOT(frame)]);
+    if ((int32_t)(frame - net->remote_confirmed) >= 0) {
+        net->remote_input[SLOT(frame)] = 0; // Predict no press
+    }
+    uint8_t local = net->local_input[SLOT(frame)];
+    uint8_t remote = net->remote_input[SLOT(frame)];
+    uint8_t p1 = (net->local_player == 1) ? local : remote;
+    uint8_t p2 = (net->local_player == 1) ? remote : local;
+
+    uint32_t t = frame * NET_FRAME_MS;
+    if (p1) court_dispatch(net->court, EVENT_P1_PRESS, t);
+    if (p2) court_dispatch(net->court, EVENT_P2_PRESS, t);
+    court_process_timers(net->court, t + NET_FRAME_MS);
+}
+
+bool netplay_advance(NetSession *net, uint32_t now_ms) {
+    if (net->rollback_from != UINT32_MAX) {
+        uint32_t depth = net->frame - net->rollback_from;
+        court_restore(net->court, &net->snapshots[SLOT(net->rollback_from)]);
+        for (uint32_t f = net->rollback_from; f != net->frame; f++) {
+            net_simulate(net, f);
+        }
+        net->rollback_from = UINT32_MAX;
+        net->stats.rollbacks++;
+        net->stats.resimulated += depth;
+        if (depth > net->stats.max_rollback) net->stats.max_rollback = depth;
+    }
+
+    if ((int32_t)(net->frame - net->remote_confirmed) >= NET_MAX_ROLLBACK) {
+        net->stats.stalls++;
+        net_send_inputs(net, now_ms); // Keep the peer going if our last packets were lost
+        return false;
+    }
+
+    net->local_input[SLOT(net->frame + NET_INPUT_DELAY)] = net->pending_press;
+    net->pending_press = false;
+    net_simulate(net, net->frame);
+    net->frame++;
+    net_send_inputs(net, now_ms);
+    return true;
+}
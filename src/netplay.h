@@ -0,0 +1,128 @@
+#ifndef NETPLAY_H
+#define NETPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <netinet/in.h>
+#include "esp_err.h"
+#include "lib8tion.h"
+#include "game.h"
+
+// Rollback netcode: one court played by two controllers over UDP.
+//
+// Both controllers run the same deterministic court in fixed frames of
+// NET_FRAME_MS. Each one owns one player and sends that player's button
+// presses, tagged with frame numbers, to the peer. Frames are simulated
+// right away with the remote presses predicted as "not pressed"; when a
+// remote press arrives for a frame that was already simulated, the court is
+// restored from the snapshot taken before that frame and the frames up to
+// now are simulated again. A controller stalls instead of running more than
+// NET_MAX_ROLLBACK frames ahead of the inputs it has from its peer.
+//
+// Every packet repeats all inputs the peer has not acknowledged, so lost
+// packets need no retransmission. Packets are sent in host byte order; both
+// ends are expected to be the same (little-endian) platform.
+//
+// Every start of a session draws a new session id, sent in every packet
+// along with the id the sender has for the receiver. When the peer's id
+// changes (it rebooted), the session restarts at frame 0 with a new id of
+// its own; packets addressed to an earlier id of the receiver are dropped,
+// so stale packets in flight cannot restart it again.
+//
+// The transport uses BSD sockets only and runs unchanged in host builds.
+// 'sim_loss_pct' and 'sim_delay_ms' drop and delay outgoing packets to test
+// two instances on loopback.
+
+#define NET_FRAME_MS 10        // Simulation frame
+#define NET_MAX_ROLLBACK 8     // Frames simulated ahead of the peer's inputs
+#define NET_INPUT_DELAY 2      // Local presses take effect this many frames later
+#define NET_RING 64            // Frames of inputs and snapshots kept, power of 2
+#define NET_SIM_QUEUE 32       // Packets held back by 'sim_delay_ms'
+
+typedef struct {
+    uint32_t rollbacks;        // Mispredictions corrected
+    uint32_t resimulated;      // Frames simulated again
+    uint32_t max_rollback;     // Longest rollback (frames)
+    uint32_t stalls;           // Frames held back waiting for the peer
+    uint32_t sent, received;   // Packets
+    uint32_t restarts;         // Sessions restarted because the peer did
+} NetStats;
+
+typedef struct {
+    uint32_t release_ms;
+    uint16_t len;
+    uint8_t data[32];
+} NetDelayedPacket;
+
+typedef struct {
+    Court *court;
+    int local_player;          // 1 or 2
+    uint32_t frame;            // Next frame to simulate
+    uint32_t remote_confirmed; // Remote inputs are known for all frames before this
+    uint32_t peer_ack;         // Peer has our inputs for all frames before this
+    uint32_t rollback_from;    // Earliest mispredicted frame, UINT32_MAX if none
+    bool pending_press;        // Local press not yet assigned to a frame
+    uint8_t local_input[NET_RING];
+    uint8_t remote_input[NET_RING];         // Known, or predicted for frames >= remote_confirmed
+    CourtSnapshot snapshots[NET_RING];      // Court state before each frame
+
+    uint32_t session;          // Id of this start of the session, never 0
+    uint32_t peer_session;     // Peer's id, 0 until its first packet
+
+    int sock;
+    struct sockaddr_in peer;
+    NetStats stats;
+
+    uint8_t sim_loss_pct;      // Test: drop this share of outgoing packets
+    uint16_t sim_delay_ms;     // Test: delay outgoing packets
+    random_state_t sim_rng;
+    NetDelayedPacket sim_queue[NET_SIM_QUEUE];
+    int sim_queued;
+} NetSession;
+
+/**
+ * @brief Open the UDP socket and start the court at frame 0
+ *
+ * @param net Session
+ * @param court Initialized court; restarted by this call
+ * @param local_player Player owned by this controller, 1 or 2
+ * @param local_port UDP port to listen on
+ * @param peer_ip IPv4 address of the peer, dotted quad
+ * @param peer_port UDP port of the peer
+ * @return `ESP_OK` on success
+ */
+esp_err_t netplay_init(NetSession *net, Court *court, int local_player, uint16_t local_port,
+                       const char *peer_ip, uint16_t peer_port);
+
+/**
+ * @brief Close the socket
+ */
+void netplay_free(NetSession *net);
+
+/**
+ * @brief Record a press of the local player's button
+ *
+ * It takes effect NET_INPUT_DELAY frames after the next simulated frame.
+ */
+void netplay_press(NetSession *net);
+
+/**
+ * @brief Receive peer packets and send delayed test packets that are due
+ *
+ * Restarts the court at frame 0 if the peer has started a new session.
+ *
+ * @param now_ms Wall clock, for 'sim_delay_ms'
+ */
+void netplay_poll(NetSession *net, uint32_t now_ms);
+
+/**
+ * @brief Correct mispredictions and simulate the next frame
+ *
+ * Call once per NET_FRAME_MS, after netplay_poll().
+ *
+ * @param now_ms Wall clock, for 'sim_delay_ms'
+ * @return true if a frame was simulated, false if stalled waiting for the peer
+ */
+bool netplay_advance(NetSession *net, uint32_t now_ms);
+
+#endif /* NETPLAY_H */
@@ -0,0 +1,21 @@
+#ifndef WIFI_H
+#define WIFI_H
+
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @brief Join a WiFi access point as station and wait for an IP address
+ *
+ * Initializes NVS, netif and the default event loop. The connection is
+ * re-established in the background whenever it drops. Later calls only wait
+ * for the connection.
+ *
+ * @param ssid Access point name
+ * @param password Password, empty for an open network
+ * @param timeout Time to wait for an IP address
+ * @return true if connected within 'timeout'
+ */
+bool wifi_connect(const char *ssid, const char *password, TickType_t timeout);
+
+#endif /* WIFI_H */
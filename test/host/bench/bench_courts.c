@@ -0,0 +1,94 @@
+// Times the court engine with many courts on one controller: every court
+// is played by a bot that mostly hits, courts_advance() runs once per
+// simulated millisecond and every court is rendered. Prints the cost per
+// tick for one court and for all of them, which should grow linearly.
+//
+//   bench_courts [--courts N] [--ms MS]
+//
+// Defaults: 64 courts of 54 LEDs, 10 minutes of play.
+#include <stdlib.h>
+#include <string.h>
+#include "game.h"
+#include "esp_log.h"
+#include "frame_clock.h"
+
+#define NUM_LEDS 54
+#define DEFAULT_COURTS 64
+#define DEFAULT_MS 600000
+
+// Serves, and hits when the ball is on the paddle unless told to miss
+static void bot(Court *court, uint32_t now, bool miss) {
+    if (court->state == GAME_STATE_WAIT_SERVE) {
+        court_dispatch(court, court->servingPlayer == &court->player1 ? EVENT_P1_PRESS : EVENT_P2_PRESS, now);
+    } else if (court->state == GAME_STATE_WAIT_RESTART) {
+        court_dispatch(court, EVENT_P1_PRESS, now);
+    } else if (court->state == GAME_STATE_PLAYING && !miss) {
+        Player *player = court->ball.direction == LEFT ? &court->player1 : &court->player2;
+        int led = (int)(court->ball.position + 0.5f);
+        if (led >= player->paddle_pos_start && led <= player->paddle_pos_end) {
+            court_dispatch(court, player == &court->player1 ? EVENT_P1_PRESS : EVENT_P2_PRESS, now);
+        }
+    }
+}
+
+// Returns the time per tick (us)
+static double run(int num_courts, uint32_t ms, uint32_t *frames) {
+    Court *courts = calloc(num_courts, sizeof(Court));
+    if (!courts) {
+        fprintf(stderr, "Not enough memory for %d courts\n", num_courts);
+        exit(2);
+    }
+    for (int i = 0; i < num_courts; i++) {
+        if (court_init(&courts[i], i, NUM_LEDS) != ESP_OK) exit(2);
+        court_start(&courts[i], 0);
+    }
+
+    *frames = 0;
+    int64_t start = frame_clock_now_us();
+    for (uint32_t now = 0; now < ms; now++) {
+        bool miss = (now / 3000) % 3 == 0; // Some points are scored
+        for (int i = 0; i < num_courts; i++) bot(&courts[i], now, miss);
+        courts_advance(courts, num_courts, now);
+        for (int i = 0; i < num_courts; i++) {
+            bool changed;
+            court_render(&courts[i], &changed);
+            *frames += changed;
+        }
+    }
+    int64_t elapsed = frame_clock_now_us() - start;
+
+    for (int i = 0; i < num_courts; i++) court_free(&courts[i]);
+    free(courts);
+    return (double)elapsed / ms;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [--courts N] [--ms MS]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    int num_courts = DEFAULT_COURTS;
+    uint32_t ms = DEFAULT_MS;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--courts")) {
+            num_courts = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--ms")) {
+            ms = strtoul(argv[++i], NULL, 10);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (num_courts < 1 || !ms) usage(argv[0]);
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+
+    printf("%d LEDs per court, %u ms of play, one tick per ms\n", NUM_LEDS, (unsigned)ms);
+    uint32_t frames;
+    double single_us = run(1, ms, &frames);
+    printf("%3d court:  %8.3f us/tick, %u frames changed\n", 1, single_us, (unsigned)frames);
+    double all_us = run(num_courts, ms, &frames);
+    printf("%3d courts: %8.3f us/tick, %.3f us/tick per court (%.1fx one court), %u frames changed\n", num_courts,
+           all_us, all_us / num_courts, all_us / single_us, (unsigned)frames);
+    return 0;
+}
@@ -0,0 +1,183 @@
+// Times the training environment stepped from several threads: the
+// environments are split into disjoint ranges, one per thread, and every
+// thread steps its range with env_step() for the same number of steps. A
+// bot that sometimes misses plays both sides from the observations. Prints
+// the steps per second of each thread count and the speedup over the
+// first one.
+//
+// Every environment only sees its own actions, so the games must come out
+// the same for every thread count; the bench fails if they do not.
+//
+//   bench_env [--envs N] [--steps N] [--threads N,N,...] [--frames]
+//
+// Defaults: 1024 environments of 54 LEDs, 20000 steps each, 1, 2, 4 and 8
+// threads, without rendering.
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "env.h"
+#include "esp_log.h"
+#include "frame_clock.h"
+
+#define NUM_LEDS 54
+#define DEFAULT_ENVS 1024
+#define DEFAULT_STEPS 20000
+#define MAX_RUNS 16
+
+// Bot of one environment: decides on every rally whether to miss it
+typedef struct {
+    uint32_t rng;
+    int8_t direction;           // Ball direction of the decision
+    bool miss;
+} Bot;
+
+typedef struct {
+    Env *env;
+    size_t first, count;
+    uint32_t steps;
+    uint8_t *actions;
+    EnvObs *obs;
+    rgb_t *frames;              // NULL to skip rendering
+    Bot *bots;                  // Per environment
+    uint32_t *games;            // Games finished, per environment
+    pthread_barrier_t *start;
+} Worker;
+
+// Serves, and hits the ball at the paddle 7 times out of 8
+static uint8_t bot(const EnvObs *obs, Bot *bot) {
+    if (obs->ball_direction == 0) return obs->serving ? ENV_PRESS_P2 : ENV_PRESS_P1;
+    if (obs->ball_direction != bot->direction) {
+        bot->rng = bot->rng * 1664525 + 1013904223;
+        bot->direction = obs->ball_direction;
+        bot->miss = (bot->rng >> 24) < 32;
+    }
+    if (bot->miss) return 0;
+    if (obs->ball_direction < 0 && obs->ball_position < 3) return ENV_PRESS_P1;
+    if (obs->ball_direction > 0 && obs->ball_position > NUM_LEDS - 4) return ENV_PRESS_P2;
+    return 0;
+}
+
+static void *work(void *arg) {
+    Worker *w = arg;
+    pthread_barrier_wait(w->start);
+    for (uint32_t s = 0; s < w->steps; s++) {
+        for (size_t i = w->first; i < w->first + w->count; i++) w->actions[i] = bot(&w->obs[i], &w->bots[i]);
+        env_step(w->env, w->first, w->count, w->actions, w->obs, w->frames);
+        for (size_t i = w->first; i < w->first + w->count; i++) w->games[i] += w->obs[i].done;
+    }
+    return NULL;
+}
+
+// Steps all environments from new games with 'threads' threads; returns the
+// time (us), the games finished and a checksum of the final observations
+// and clocks
+static int64_t run(size_t num, uint32_t steps, int threads, bool render, uint32_t *total_games,
+                   uint64_t *checksum) {
+    Env env;
+    if (env_init(&env, num, NUM_LEDS, 0) != ESP_OK) exit(2);
+    uint8_t *actions = calloc(num, 1);
+    EnvObs *obs = calloc(num, sizeof(EnvObs));
+    Bot *bots = calloc(num, sizeof(Bot));
+    uint32_t *games = calloc(num, sizeof(uint32_t));
+    rgb_t *frames = render ? malloc(num * NUM_LEDS * sizeof(rgb_t)) : NULL;
+    Worker *workers = calloc(threads, sizeof(Worker));
+    pthread_t *ids = calloc(threads, sizeof(pthread_t));
+    if (!actions || !obs || !bots || !games || (render && !frames) || !workers || !ids) exit(2);
+    env_reset(&env, 0, num, obs);
+    for (size_t i = 0; i < num; i++) bots[i].rng = 0x9e3779b9 * (uint32_t)(i + 1);
+
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, threads + 1);
+    for (int t = 0; t < threads; t++) {
+        size_t first = num * t / threads, end = num * (t + 1) / threads;
+        workers[t] = (Worker){ &env, first, end - first, steps, actions, obs, frames, bots, games, &start };
+        if (pthread_create(&ids[t], NULL, work, &workers[t])) exit(2);
+    }
+    pthread_barrier_wait(&start);
+    int64_t begin = frame_clock_now_us();
+    for (int t = 0; t < threads; t++) pthread_join(ids[t], NULL);
+    int64_t elapsed = frame_clock_now_us() - begin;
+    pthread_barrier_destroy(&start);
+
+    uint64_t sum = 0;
+    *total_games = 0;
+    for (size_t i = 0; i < num; i++) {
+        *total_games += games[i];
+        sum = sum * 31 + games[i];
+        sum = sum * 31 + env.now[i];
+        sum = sum * 31 + obs[i].lives[0] * 8 + obs[i].lives[1];
+        sum = sum * 31 + (uint32_t)(obs[i].ball_position * 1000);
+    }
+    *checksum = sum;
+
+    free(ids);
+    free(workers);
+    free(frames);
+    free(games);
+    free(bots);
+    free(obs);
+    free(actions);
+    env_free(&env);
+    return elapsed;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [--envs N] [--steps N] [--threads N,N,...] [--frames]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    size_t num = DEFAULT_ENVS;
+    uint32_t steps = DEFAULT_STEPS;
+    int thread_counts[MAX_RUNS] = { 1, 2, 4, 8 };
+    int runs = 4;
+    bool render = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames")) {
+            render = true;
+            continue;
+        }
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--envs")) {
+            num = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--steps")) {
+            steps = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--threads")) {
+            runs = 0;
+            for (char *p = argv[++i]; *p && runs < MAX_RUNS; p += *p == ',') {
+                thread_counts[runs] = strtol(p, &p, 10);
+                if (thread_counts[runs] < 1) usage(argv[0]);
+                runs++;
+            }
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (!num || !steps || !runs) usage(argv[0]);
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+
+    printf("%u environments of %d LEDs, %u steps each, %s\n", (unsigned)num, NUM_LEDS, (unsigned)steps,
+           render ? "rendered" : "not rendered");
+    double base = 0;
+    uint64_t expected = 0;
+    int status = 0;
+    for (int r = 0; r < runs; r++) {
+        int threads = thread_counts[r];
+        if ((size_t)threads > num) threads = num;
+        uint32_t games;
+        uint64_t checksum;
+        int64_t us = run(num, steps, threads, render, &games, &checksum);
+        double rate = (double)num * steps / (us / 1e6);
+        if (!r) {
+            base = rate;
+            expected = checksum;
+        }
+        printf("%2d threads: %7.2f M steps/s, %6.2f M steps/s per thread, %.2fx the first, %u games\n", threads,
+               rate / 1e6, rate / 1e6 / threads, rate / base, (unsigned)games);
+        if (checksum != expected) {
+            fprintf(stderr, "%d threads: games differ from the first run\n", threads);
+            status = 1;
+        }
+    }
+    return status;
+}
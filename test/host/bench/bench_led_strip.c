@@ -0,0 +1,184 @@
+// Times the output stage of led_strip.
+//
+// White extraction of RGBW strips: led_strip_set_pixels() on an SK6812 RGBW
+// strip in every white mode, LED_STRIP_WHITE_CORRECTED both with its lookup
+// tables (CONFIG_LED_STRIP_WHITE_LUT) and with divisions. The two corrected
+// variants must fill the strip buffer identically.
+//
+// SPI encoding: led_strip_spi_encode() of an RGB strip buffer with 4 and 3
+// SPI bits per LED bit, at the firmware brightness, from a buffer in wire
+// order and through the channel map of an `rgb_buf` strip. Both must encode
+// the same bits.
+//
+//   bench_led_strip [--leds N] [--rounds N]
+//
+// Defaults: 1024 random pixels, 2000 rounds per batch. Prints the median
+// of BATCHES batches in ns per pixel.
+#include <stdlib.h>
+#include <string.h>
+#include "led_strip.h"
+#include "led_strip_spi.h"
+#include "frame_clock.h"
+
+#define DEFAULT_LEDS 1024
+#define DEFAULT_ROUNDS 2000
+#define BATCHES 9
+#define SPI_BRIGHTNESS 60       // As the firmware strip
+
+typedef struct {
+    const char *name;
+    led_strip_white_mode_t mode;
+    bool lut;               // Keep the lookup tables of LED_STRIP_WHITE_CORRECTED
+} WhiteCase;
+
+static const WhiteCase cases[] = {
+    { "luma", LED_STRIP_WHITE_LUMA, false },
+    { "min", LED_STRIP_WHITE_MIN, false },
+    { "corrected, tables", LED_STRIP_WHITE_CORRECTED, true },
+    { "corrected, divisions", LED_STRIP_WHITE_CORRECTED, false },
+};
+
+typedef struct {
+    const char *name;
+    uint8_t bits;
+    bool map;               // Encode through the GRB map of an `rgb_buf` strip
+} SpiCase;
+
+static const SpiCase spi_cases[] = {
+    { "spi 4 bits", 4, false },
+    { "spi 4 bits, map", 4, true },
+    { "spi 3 bits", 3, false },
+    { "spi 3 bits, map", 3, true },
+};
+
+static const uint8_t grb_map[] = { 1, 0, 2 };
+
+static int compare_us(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Times the case into 'buf' and returns the median batch (ns per pixel)
+static double run(const WhiteCase *c, rgb_t *pixels, size_t leds, int rounds, uint8_t *buf) {
+    led_strip_t strip = {
+        .type = LED_STRIP_SK6812,
+        .is_rgbw = true,
+        .length = leds,
+        .gpio = 18,
+        .channel = 0,
+        .white_mode = c->mode,
+        .white_point = { .r = 255, .g = 200, .b = 120 }, // Warm white LED
+    };
+    if (led_strip_init(&strip) != ESP_OK) exit(2);
+    uint8_t *lut = strip.white_lut;
+    if (!c->lut) strip.white_lut = NULL;
+    if (c->lut && !lut) {
+        fprintf(stderr, "%s: no lookup tables, is CONFIG_LED_STRIP_WHITE_LUT set?\n", c->name);
+        exit(2);
+    }
+
+    int64_t times[BATCHES];
+    for (int b = 0; b < BATCHES; b++) {
+        int64_t start = frame_clock_now_us();
+        for (int r = 0; r < rounds; r++) led_strip_set_pixels(&strip, 0, leds, pixels);
+        times[b] = frame_clock_now_us() - start;
+    }
+    qsort(times, BATCHES, sizeof(times[0]), compare_us);
+    memcpy(buf, strip.buf, leds * 4);
+
+    strip.white_lut = lut;
+    led_strip_free(&strip);
+    return times[BATCHES / 2] * 1000.0 / ((double)rounds * leds);
+}
+
+// Times the SPI case into 'dst' and returns the median batch (ns per pixel).
+// 'rgb' is the strip buffer in RGB order, 'grb' the same LEDs in wire order.
+static double run_spi(const SpiCase *c, const uint8_t *rgb, const uint8_t *grb, size_t leds, int rounds,
+                      uint8_t *dst) {
+    led_strip_spi_code_t code;
+    if (led_strip_spi_code_init(&code, c->bits, 300 + 900, 900) != ESP_OK) exit(2); // WS2812
+
+    int64_t times[BATCHES];
+    for (int b = 0; b < BATCHES; b++) {
+        int64_t start = frame_clock_now_us();
+        for (int r = 0; r < rounds; r++) {
+            if (c->map) {
+                led_strip_spi_encode(&code, rgb, leds * 3, dst, SPI_BRIGHTNESS, grb_map, 3);
+            } else {
+                led_strip_spi_encode(&code, grb, leds * 3, dst, SPI_BRIGHTNESS, NULL, 0);
+            }
+        }
+        times[b] = frame_clock_now_us() - start;
+    }
+    qsort(times, BATCHES, sizeof(times[0]), compare_us);
+    return times[BATCHES / 2] * 1000.0 / ((double)rounds * leds);
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [--leds N] [--rounds N]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    size_t leds = DEFAULT_LEDS;
+    int rounds = DEFAULT_ROUNDS;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--leds")) {
+            leds = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--rounds")) {
+            rounds = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (!leds || rounds < 1) usage(argv[0]);
+
+    rgb_t *pixels = malloc(leds * sizeof(rgb_t));
+    uint8_t *lut_buf = malloc(leds * 4), *buf = malloc(leds * 4);
+    if (!pixels || !lut_buf || !buf) return 2;
+    uint32_t x = 0x9e3779b9;
+    for (size_t i = 0; i < leds; i++) {
+        x = x * 1664525 + 1013904223;
+        pixels[i] = (rgb_t){ .r = x >> 24, .g = x >> 16, .b = x >> 8 };
+    }
+
+    led_strip_install();
+    printf("%u RGBW pixels, %d rounds per batch\n", (unsigned)leds, rounds);
+    int status = 0;
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        bool corrected = cases[c].mode == LED_STRIP_WHITE_CORRECTED;
+        double ns = run(&cases[c], pixels, leds, rounds, corrected && cases[c].lut ? lut_buf : buf);
+        printf("%-22s %7.2f ns/pixel\n", cases[c].name, ns);
+        if (corrected && !cases[c].lut && memcmp(lut_buf, buf, leds * 4)) {
+            fprintf(stderr, "%s: differs from the lookup tables\n", cases[c].name);
+            status = 1;
+        }
+    }
+
+    uint8_t *rgb = malloc(leds * 3), *grb = malloc(leds * 3);
+    uint8_t *spi_buf = malloc(leds * 3 * 4), *map_spi_buf = malloc(leds * 3 * 4);
+    if (!rgb || !grb || !spi_buf || !map_spi_buf) return 2;
+    for (size_t i = 0; i < leds; i++) {
+        memcpy(&rgb[i * 3], &pixels[i], 3);
+        for (int ch = 0; ch < 3; ch++) grb[i * 3 + ch] = rgb[i * 3 + grb_map[ch]];
+    }
+    printf("%u RGB pixels encoded for SPI, brightness %d\n", (unsigned)leds, SPI_BRIGHTNESS);
+    for (size_t c = 0; c < sizeof(spi_cases) / sizeof(spi_cases[0]); c++) {
+        const SpiCase *sc = &spi_cases[c];
+        double ns = run_spi(sc, rgb, grb, leds, rounds, sc->map ? map_spi_buf : spi_buf);
+        printf("%-22s %7.2f ns/pixel\n", sc->name, ns);
+        if (sc->map && memcmp(spi_buf, map_spi_buf, leds * 3 * sc->bits)) {
+            fprintf(stderr, "%s: differs from the encoding in wire order\n", sc->name);
+            status = 1;
+        }
+    }
+    free(map_spi_buf);
+    free(spi_buf);
+    free(grb);
+    free(rgb);
+    free(buf);
+    free(lut_buf);
+    free(pixels);
+    return status;
+}
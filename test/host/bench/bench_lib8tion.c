@@ -0,0 +1,61 @@
+// Runs the lib8tion/color microbenchmarks (see bench.h) and prints the
+// results as JSON, and/or compares them with a saved baseline:
+//
+//   bench_lib8tion --json base.json             # before the change
+//   bench_lib8tion --baseline base.json         # after; exit 1 on a regression
+//
+// Options: --min-us US time per case (default BENCH_MIN_US), --tolerance PCT
+// slowdown counted as a regression (default BENCH_TOLERANCE_PCT).
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [--json FILE] [--baseline FILE] [--tolerance PCT] [--min-us US]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    const char *json_path = NULL, *baseline_path = NULL;
+    float tolerance_pct = 0;
+    uint32_t min_us = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(arg, "--json")) {
+            json_path = argv[++i];
+        } else if (!strcmp(arg, "--baseline")) {
+            baseline_path = argv[++i];
+        } else if (!strcmp(arg, "--tolerance")) {
+            tolerance_pct = atof(argv[++i]);
+        } else if (!strcmp(arg, "--min-us")) {
+            min_us = strtoul(argv[++i], NULL, 10);
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    static BenchResult results[BENCH_MAX_RESULTS];
+    size_t count = bench_run(results, min_us);
+
+    if (json_path || !baseline_path) {
+        FILE *json = json_path ? fopen(json_path, "w") : stdout;
+        if (!json) {
+            perror(json_path);
+            return 2;
+        }
+        bench_write_json(json, results, count);
+        if (json != stdout) fclose(json);
+    }
+
+    if (!baseline_path) return 0;
+    FILE *baseline = fopen(baseline_path, "r");
+    if (!baseline) {
+        perror(baseline_path);
+        return 2;
+    }
+    int regressions = bench_compare(baseline, results, count, tolerance_pct, stdout);
+    fclose(baseline);
+    if (regressions) printf("%d regression(s)\n", regressions);
+    return regressions ? 1 : 0;
+}
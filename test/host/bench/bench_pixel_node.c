@@ -0,0 +1,145 @@
+// Times the network pixel receiver: frames are sent over loopback to a node
+// on an `rgb_buf` WS2812 strip, as DDP packets of 480 LEDs with PUSH on the
+// last one and as E1.31 universes of 170 LEDs without a sync address.
+// pixel_node_receive() reads them into the strip buffer and flushes it
+// through the RMT translator of the stub driver. Prints the time per frame
+// spent in pixel_node_receive(), the flush included, and the pixel rate.
+// The bench fails if a frame is not shown or packets are counted dropped.
+//
+//   bench_pixel_node [--leds N] [--frames N]
+//
+// Defaults: 600 LEDs, 2000 frames per protocol.
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include "pixel_node.h"
+#include "esp_log.h"
+#include "frame_clock.h"
+
+#define DEFAULT_LEDS 600            // Four E1.31 universes
+#define DEFAULT_FRAMES 2000
+#define DDP_LEDS 480                // 1440 data bytes
+#define E131_LEDS 170
+#define UNIVERSE 1
+
+static const uint8_t acn_id[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+
+// Builds the packets of one frame of 'leds' LEDs into 'packets'; returns
+// their number
+static int build_frame(pixel_node_protocol_t protocol, const uint8_t *rgb, size_t leds, uint8_t seq,
+                       uint8_t packets[][PIXEL_NODE_MAX_PACKET], size_t *lens) {
+    int n = 0;
+    size_t per_packet = protocol == PIXEL_NODE_DDP ? DDP_LEDS : E131_LEDS;
+    for (size_t first = 0; first < leds; first += per_packet, n++) {
+        size_t len = (leds - first < per_packet ? leds - first : per_packet) * 3;
+        size_t offset = first * 3;
+        uint8_t *p = packets[n];
+        if (protocol == PIXEL_NODE_DDP) {
+            bool last = first + per_packet >= leds;
+            uint8_t hdr[10] = { 0x40 | last, 1 + seq % 15, 0x0b, 1, offset >> 24, offset >> 16, offset >> 8, offset,
+                                len >> 8, len };
+            memcpy(p, hdr, sizeof(hdr));
+            memcpy(p + 10, rgb + offset, len);
+            lens[n] = 10 + len;
+        } else {
+            uint16_t universe = UNIVERSE + n;
+            memset(p, 0, 126);
+            p[1] = 0x10;
+            memcpy(p + 4, acn_id, sizeof(acn_id));
+            p[21] = 0x04;
+            p[43] = 0x02;
+            p[108] = 100;
+            p[111] = seq;
+            p[113] = universe >> 8, p[114] = universe;
+            p[117] = 0x02, p[118] = 0xa1;
+            p[122] = 1;
+            p[123] = (len + 1) >> 8, p[124] = len + 1;
+            memcpy(p + 126, rgb + offset, len);
+            lens[n] = 126 + len;
+        }
+    }
+    return n;
+}
+
+// Returns the time per frame in pixel_node_receive() (us)
+static double run(pixel_node_protocol_t protocol, size_t leds, uint32_t frames, uint16_t port) {
+    led_strip_t strip = {
+        .type = LED_STRIP_WS2812,
+        .length = leds,
+        .gpio = 18,
+        .channel = 0,
+        .brightness = 255,
+        .rgb_buf = true,
+    };
+    pixel_node_t node;
+    if (led_strip_init(&strip) != ESP_OK || pixel_node_init(&node, &strip, protocol, port, UNIVERSE) != ESP_OK) exit(2);
+    int sender = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port),
+                                .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    static uint8_t packets[PIXEL_NODE_MAX_UNIVERSES * 2][PIXEL_NODE_MAX_PACKET];
+    size_t lens[PIXEL_NODE_MAX_UNIVERSES * 2];
+    uint8_t *rgb = malloc(leds * 3);
+    if (sender < 0 || !rgb) exit(2);
+
+    int64_t total_us = 0;
+    for (uint32_t f = 0; f < frames; f++) {
+        for (size_t i = 0; i < leds * 3; i++) rgb[i] = (uint8_t)(i + f);
+        int n = build_frame(protocol, rgb, leds, f, packets, lens);
+        for (int i = 0; i < n; i++) sendto(sender, packets[i], lens[i], 0, (struct sockaddr *)&addr, sizeof(addr));
+        pixel_node_wait(&node, 1000);
+        int64_t begin = frame_clock_now_us();
+        uint32_t shown;
+        pixel_node_receive(&node, &shown);
+        total_us += frame_clock_now_us() - begin;
+        if (shown != 1 || memcmp(strip.buf, rgb, leds * 3)) {
+            fprintf(stderr, "%s frame %u: not shown\n", protocol == PIXEL_NODE_DDP ? "DDP" : "E1.31", (unsigned)f);
+            exit(1);
+        }
+    }
+    if (node.stats.dropped || node.stats.late) {
+        fprintf(stderr, "%u packets dropped, %u late\n", (unsigned)node.stats.dropped, (unsigned)node.stats.late);
+        exit(1);
+    }
+
+    close(sender);
+    free(rgb);
+    pixel_node_free(&node);
+    led_strip_free(&strip);
+    return (double)total_us / frames;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [--leds N] [--frames N]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    size_t leds = DEFAULT_LEDS;
+    uint32_t frames = DEFAULT_FRAMES;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--leds")) {
+            leds = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--frames")) {
+            frames = strtoul(argv[++i], NULL, 10);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (!leds || leds > PIXEL_NODE_MAX_UNIVERSES * E131_LEDS || !frames) usage(argv[0]);
+    esp_log_level_set("pixel_node", ESP_LOG_WARN);
+    led_strip_install();
+
+    uint16_t port = 30000 + getpid() % 15000 * 2;
+    printf("%u LEDs, %u frames\n", (unsigned)leds, (unsigned)frames);
+    for (int p = 0; p < 2; p++) {
+        pixel_node_protocol_t protocol = p ? PIXEL_NODE_E131 : PIXEL_NODE_DDP;
+        double us = run(protocol, leds, frames, port + p);
+        size_t per_packet = p ? E131_LEDS : DDP_LEDS;
+        printf("%-6s %zu packets per frame: %8.2f us per frame, %7.2f M pixels/s\n", p ? "E1.31" : "DDP",
+               (leds + per_packet - 1) / per_packet, us, leds / us);
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Minimal assertions for the host tests: a failed check prints where and
+// what, and fails the test. Unlike assert() they stay on in release builds.
+
+#define TEST_ASSERT(cond) do {                                                \
+        if (!(cond)) {                                                        \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                          \
+        }                                                                     \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual) do {                              \
+        long long e_ = (long long)(expected), a_ = (long long)(actual);       \
+        if (e_ != a_) {                                                       \
+            fprintf(stderr, "%s:%d: %s: expected %lld, got %lld\n", __FILE__, __LINE__, #actual, e_, a_); \
+            exit(1);                                                          \
+        }                                                                     \
+    } while (0)
+
+// Writes an input log (see replay.h) of a rally-heavy match: presses from
+// 'start_ms' to 'end_ms' at varying intervals, mostly player 2
+static inline void write_input_log(FILE *log, uint32_t start_ms, uint32_t end_ms) {
+    fprintf(log, "# generated by the host tests\n");
+    for (uint32_t t = start_ms, k = 0; t < end_ms; t += 300 + (k * 97) % 500, k++) {
+        fprintf(log, "%u %d\n", (unsigned)t, 1 + (k % 3 == 0));
+    }
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,220 @@
+#include "bench.h"
+#include <stdbool.h>
+#include <string.h>
+#include "color.h"
+#include "frame_clock.h"
+#include "lib8tion.h"
+
+#define COURT_LEDS 54
+#define STRIP_LEDS 300
+#define BUF_SIZE 1024
+
+// Inputs are filled once with varied values; outputs are read into the
+// sink so the compiler cannot drop the work
+static uint8_t in_a[BUF_SIZE], in_b[BUF_SIZE], out8[BUF_SIZE];
+static uint16_t in16[BUF_SIZE];
+static rgb_t leds[STRIP_LEDS];
+static rgb_t palette[16];
+static hsv_t hsv[STRIP_LEDS];
+static volatile uint32_t sink;
+static uint8_t round_no;        // Varies the arguments from call to call
+
+// --- Cases ---
+static void case_scale8(size_t n) {
+    uint8_t s = round_no;
+    for (size_t i = 0; i < n; i++) out8[i] = scale8(in_a[i], s);
+}
+
+static void case_nscale8x3(size_t n) {
+    uint8_t s = round_no | 0x80;
+    for (size_t i = 0; i < n; i++) nscale8x3(&leds[i].r, &leds[i].g, &leds[i].b, s);
+}
+
+static void case_qadd8(size_t n) {
+    for (size_t i = 0; i < n; i++) out8[i] = qadd8(in_a[i], in_b[i]);
+}
+
+static void case_sqrt16(size_t n) {
+    for (size_t i = 0; i < n; i++) out8[i] = sqrt16(in16[i]);
+}
+
+static void case_sin8(size_t n) {
+    uint8_t phase = round_no;
+    for (size_t i = 0; i < n; i++) out8[i] = sin8(in_a[i] + phase);
+}
+
+static void case_blend8(size_t n) {
+    uint8_t amount = round_no;
+    for (size_t i = 0; i < n; i++) out8[i] = blend8(in_a[i], in_b[i], amount);
+}
+
+static void case_hsv2rgb_rainbow(size_t n) {
+    for (size_t i = 0; i < n; i++) leds[i] = hsv2rgb_rainbow(hsv[i]);
+}
+
+static void case_rgb2hsv_approximate(size_t n) {
+    for (size_t i = 0; i < n; i++) hsv[i] = rgb2hsv_approximate(leds[i]);
+}
+
+static void case_rgb_fill_gradient_rgb(size_t n) {
+    rgb_t a = { .r = round_no, .g = 40, .b = 200 };
+    rgb_t b = { .r = 255, .g = round_no, .b = 10 };
+    rgb_fill_gradient_rgb(leds, 0, a, n - 1, b);
+}
+
+static void case_blur1d(size_t n) {
+    leds[n / 2] = (rgb_t){ .r = 255, .g = 255, .b = 255 }; // Keep something to blur
+    blur1d(leds, n, 64);
+}
+
+static void case_rgb_fade_to_black_by(size_t n) {
+    rgb_fade_to_black_by(leds, n, round_no | 1);
+}
+
+static void case_color_from_palette_rgb(size_t n) {
+    uint8_t offset = round_no;
+    for (size_t i = 0; i < n; i++) leds[i] = color_from_palette_rgb(palette, 16, in_a[i] + offset, 255, true);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(size_t n);
+    uint32_t size;
+} BenchCase;
+
+static const BenchCase cases[] = {
+    { "scale8", case_scale8, BUF_SIZE },
+    { "nscale8x3", case_nscale8x3, STRIP_LEDS },
+    { "qadd8", case_qadd8, BUF_SIZE },
+    { "sqrt16", case_sqrt16, BUF_SIZE },
+    { "sin8", case_sin8, BUF_SIZE },
+    { "blend8", case_blend8, BUF_SIZE },
+    { "hsv2rgb_rainbow", case_hsv2rgb_rainbow, STRIP_LEDS },
+    { "rgb2hsv_approximate", case_rgb2hsv_approximate, STRIP_LEDS },
+    { "rgb_fill_gradient_rgb", case_rgb_fill_gradient_rgb, STRIP_LEDS },
+    { "blur1d", case_blur1d, COURT_LEDS },
+    { "blur1d", case_blur1d, STRIP_LEDS },
+    { "rgb_fade_to_black_by", case_rgb_fade_to_black_by, STRIP_LEDS },
+    { "color_from_palette_rgb", case_color_from_palette_rgb, STRIP_LEDS },
+};
+
+// --- Runner ---
+static void fill_inputs() {
+    uint32_t x = 0x12345678;
+    for (size_t i = 0; i < BUF_SIZE; i++) {
+        x = x * 1664525 + 1013904223;
+        in_a[i] = x >> 24;
+        in_b[i] = x >> 16;
+        in16[i] = x >> 8;
+    }
+    for (size_t i = 0; i < STRIP_LEDS; i++) {
+        leds[i] = (rgb_t){ .r = in_a[i], .g = in_b[i], .b = in_a[i + 1] };
+        hsv[i] = hsv_from_values(in_b[i], 255 - (in_a[i] >> 2), in_a[i] | 0x40);
+    }
+    for (size_t i = 0; i < 16; i++) palette[i] = hsv2rgb_rainbow(hsv_from_values(i * 16, 255, 255));
+}
+
+// Runs 'reps' calls; returns the time taken
+static int64_t run_batch(const BenchCase *c, uint32_t reps) {
+    int64_t start = frame_clock_now_us();
+    for (uint32_t r = 0; r < reps; r++) {
+        round_no++;
+        c->run(c->size);
+    }
+    int64_t elapsed = frame_clock_now_us() - start;
+    sink += out8[round_no % BUF_SIZE] + leds[round_no % STRIP_LEDS].g + hsv[round_no % STRIP_LEDS].h;
+    return elapsed;
+}
+
+// Median of the batch times, sorts 'times'
+static int64_t median(int64_t *times, int count) {
+    for (int i = 1; i < count; i++) {
+        int64_t t = times[i];
+        int j = i;
+        for (; j > 0 && times[j - 1] > t; j--) times[j] = times[j - 1];
+        times[j] = t;
+    }
+    return times[count / 2];
+}
+
+size_t bench_run(BenchResult *results, uint32_t min_us) {
+    int64_t batch_us = (min_us ? min_us : BENCH_MIN_US) / BENCH_BATCHES;
+    size_t count = sizeof(cases) / sizeof(cases[0]);
+    if (count > BENCH_MAX_RESULTS) count = BENCH_MAX_RESULTS;
+    fill_inputs();
+
+    for (size_t i = 0; i < count; i++) {
+        const BenchCase *c = &cases[i];
+        // Grow the batch until it takes long enough to time
+        uint32_t reps = 1;
+        int64_t t;
+        while ((t = run_batch(c, reps)) < batch_us && reps < (1u << 30)) {
+            reps = t > 0 && t < batch_us / 4 ? reps * (uint32_t)(batch_us / t) : reps * 2;
+        }
+        int64_t times[BENCH_BATCHES];
+        times[0] = t;
+        for (int b = 1; b < BENCH_BATCHES; b++) times[b] = run_batch(c, reps);
+        double ns = median(times, BENCH_BATCHES) * 1000.0 / reps;
+        results[i] = (BenchResult){
+            .name = c->name,
+            .size = c->size,
+            .calls = reps,
+            .ns_per_call = ns,
+            .ns_per_item = ns / c->size,
+        };
+    }
+    return count;
+}
+
+// --- Output ---
+void bench_write_json(FILE *out, const BenchResult *results, size_t count) {
+    fprintf(out, "{\"benchmarks\": [\n");
+    for (size_t i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(out, "  {\"name\": \"%s\", \"size\": %u, \"calls\": %u, \"ns_per_call\": %.2f, \"ns_per_item\": %.3f}%s\n",
+                r->name, (unsigned)r->size, (unsigned)r->calls, r->ns_per_call, r->ns_per_item,
+                i + 1 < count ? "," : "");
+    }
+    fprintf(out, "]}\n");
+}
+
+// Finds '"key": ' in a JSON line and returns what follows
+static const char *json_value(const char *line, const char *key) {
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char *p = strstr(line, pattern);
+    return p ? p + strlen(pattern) : NULL;
+}
+
+int bench_compare(FILE *baseline, const BenchResult *results, size_t count, float tolerance_pct, FILE *report) {
+    if (!tolerance_pct) tolerance_pct = BENCH_TOLERANCE_PCT;
+    int regressions = 0;
+    char line[256];
+    fprintf(report, "%-24s %6s %12s %12s %8s\n", "case", "size", "base ns", "now ns", "change");
+    while (fgets(line, sizeof(line), baseline)) {
+        const char *name = json_value(line, "name");
+        const char *size = json_value(line, "size");
+        const char *ns = json_value(line, "ns_per_call");
+        char base_name[32];
+        unsigned base_size;
+        double base_ns;
+        if (!name || !size || !ns || sscanf(name, "\"%31[^\"]\"", base_name) != 1 ||
+            sscanf(size, "%u", &base_size) != 1 || sscanf(ns, "%lf", &base_ns) != 1) {
+            continue;
+        }
+        const BenchResult *r = NULL;
+        for (size_t i = 0; i < count && !r; i++) {
+            if (!strcmp(results[i].name, base_name) && results[i].size == base_size) r = &results[i];
+        }
+        if (!r) {
+            fprintf(report, "%-24s %6u %12.2f %12s\n", base_name, base_size, base_ns, "-");
+            continue;
+        }
+        double change = (r->ns_per_call - base_ns) * 100.0 / base_ns;
+        bool regression = change > tolerance_pct;
+        regressions += regression;
+        fprintf(report, "%-24s %6u %12.2f %12.2f %+7.1f%%%s\n", base_name, base_size, base_ns, r->ns_per_call, change,
+                regression ? "  REGRESSION" : change < -tolerance_pct ? "  faster" : "");
+    }
+    return regressions;
+}
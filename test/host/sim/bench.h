@@ -0,0 +1,59 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Microbenchmarks of the lib8tion and color helpers on the rendering paths,
+// at the sizes the courts use: a 54-LED court, a 300-LED strip and 1024
+// element buffers. Each case runs its kernel in BENCH_BATCHES batches of at
+// least min_us / BENCH_BATCHES and keeps the median batch, which is steadier
+// from run to run than the fastest one.
+//
+// Results are written as JSON, one case per line. Comparing against a
+// baseline saved from an earlier run shows the change of every case, so an
+// optimisation of these helpers comes with numbers. Repeated runs of the
+// same build on a shared machine differed by up to about 20% per case (a
+// full run takes about 15 s), so only slowdowns above BENCH_TOLERANCE_PCT
+// count as regressions. See bench/bench_lib8tion.c for the command line.
+
+#define BENCH_MAX_RESULTS 16
+#define BENCH_MIN_US 750000         // Default time per case
+#define BENCH_BATCHES 15
+#define BENCH_TOLERANCE_PCT 25.0f   // Default slowdown reported as a regression, above the run-to-run noise
+
+typedef struct {
+    const char *name;
+    uint32_t size;              // Elements per call
+    uint32_t calls;             // Calls per batch
+    double ns_per_call;
+    double ns_per_item;
+} BenchResult;
+
+/**
+ * @brief Run all benchmark cases
+ *
+ * @param results At least BENCH_MAX_RESULTS entries
+ * @param min_us Time per case, 0 for BENCH_MIN_US
+ * @return Number of results
+ */
+size_t bench_run(BenchResult *results, uint32_t min_us);
+
+/**
+ * @brief Write results as JSON
+ */
+void bench_write_json(FILE *out, const BenchResult *results, size_t count);
+
+/**
+ * @brief Compare results with a baseline written by bench_write_json()
+ *
+ * Prints a table with the change of every case found in the baseline.
+ *
+ * @param tolerance_pct Slowdown above which a case is a regression, 0 for
+ *                      BENCH_TOLERANCE_PCT
+ * @return Number of regressions
+ */
+int bench_compare(FILE *baseline, const BenchResult *results, size_t count, float tolerance_pct, FILE *report);
+
+#endif // BENCH_H
@@ -0,0 +1,99 @@
+#include "env.h"
+#include <stdlib.h>
+#include <string.h>
+
+void env_observe(const Env *env, size_t i, EnvObs *obs) {
+    const Court *court = &env->courts[i];
+    obs->ball_position = court->ball.position;
+    obs->ball_speed = court->ball.speed;
+    obs->ball_direction = court->ball.direction == LEFT ? -1 : court->ball.direction == RIGHT ? 1 : 0;
+    obs->state = court->state;
+    obs->lives[0] = court->player1.lives;
+    obs->lives[1] = court->player2.lives;
+    obs->serving = court->servingPlayer == &court->player2;
+}
+
+esp_err_t env_init(Env *env, size_t num, int num_leds, uint32_t step_ms) {
+    *env = (Env){ .num = num, .num_leds = num_leds, .step_ms = step_ms ? step_ms : ENV_STEP_MS };
+    env->courts = calloc(num, sizeof(Court));
+    env->now = calloc(num, sizeof(uint32_t));
+    if (!env->courts || !env->now) {
+        env_free(env);
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < num; i++) {
+        esp_err_t err = court_init(&env->courts[i], (int)i, num_leds);
+        if (err != ESP_OK) {
+            env->num = i;
+            env_free(env);
+            return err;
+        }
+    }
+    env_reset(env, 0, num, NULL);
+    return ESP_OK;
+}
+
+void env_free(Env *env) {
+    if (env->courts) {
+        for (size_t i = 0; i < env->num; i++) {
+            court_free(&env->courts[i]);
+        }
+    }
+    free(env->courts);
+    free(env->now);
+    env->courts = NULL;
+    env->now = NULL;
+}
+
+void env_reset(Env *env, size_t first, size_t count, EnvObs *obs) {
+    for (size_t i = first; i < first + count; i++) {
+        court_new_game(&env->courts[i], env->now[i]);
+        if (obs) {
+            env_observe(env, i, &obs[i]);
+            memset(obs[i].reward, 0, sizeof(obs[i].reward));
+            obs[i].done = false;
+        }
+    }
+}
+
+void env_step(Env *env, size_t first, size_t count, const uint8_t *actions, EnvObs *obs, rgb_t *frames) {
+    for (size_t i = first; i < first + count; i++) {
+        Court *court = &env->courts[i];
+        uint32_t now = env->now[i];
+        int lives1 = court->player1.lives;
+        int lives2 = court->player2.lives;
+
+        if (actions[i] & ENV_PRESS_P1) court_dispatch(court, EVENT_P1_PRESS, now);
+        if (actions[i] & ENV_PRESS_P2) court_dispatch(court, EVENT_P2_PRESS, now);
+        now += env->step_ms;
+        court_process_timers(court, now);
+
+        // Fast-forward the score blink from deadline to deadline
+        while (court->state == GAME_STATE_POINT_SCORED) {
+            int32_t wait = court_next_timer(court, now);
+            if (wait < 0) break;
+            now += wait;
+            court_process_timers(court, now);
+        }
+
+        int lost1 = lives1 - court->player1.lives;
+        int lost2 = lives2 - court->player2.lives;
+        bool done = court->state == GAME_STATE_GAME_OVER || court->state == GAME_STATE_WAIT_RESTART;
+        if (done) {
+            court_new_game(court, now);
+        }
+        env->now[i] = now;
+
+        EnvObs *o = &obs[i];
+        env_observe(env, i, o);
+        o->reward[0] = lost2 - lost1;
+        o->reward[1] = lost1 - lost2;
+        o->done = done;
+
+        if (frames) {
+            bool changed;
+            const rgb_t *frame = court_render(court, &changed);
+            memcpy(frames + i * env->num_leds, frame, env->num_leds * sizeof(rgb_t));
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "game.h"
+
+// Batched training environment on top of the court engine, for running many
+// independent games in lock-step (e.g. to train and evaluate AI opponents in
+// a host build). Every environment is one Court played by the real state
+// machine; a step feeds the chosen button presses and advances the court's
+// clock by a fixed time step. Stepping never allocates, and disjoint ranges
+// of environments can be stepped from different threads.
+//
+// Dead time is skipped: a game starts straight at the serve, the point
+// scored pause is fast-forwarded, and a finished game is reset on the spot.
+
+#define ENV_STEP_MS 15          // Default time step: shortest ball tick interval
+
+#define ENV_PRESS_P1 0x01       // Action bits: press player 1 (left) button
+#define ENV_PRESS_P2 0x02       // press player 2 (right) button
+
+typedef struct {
+    float ball_position;
+    float ball_speed;           // LEDs per ball tick
+    int8_t ball_direction;      // -1 left, 0 waiting for serve, +1 right
+    uint8_t state;              // GameState
+    uint8_t lives[2];           // Player 1, player 2
+    uint8_t serving;            // 0 = player 1 serves next, 1 = player 2
+    int8_t reward[2];           // Per player: lives the opponent lost minus lives lost in this step
+    bool done;                  // A game ended in this step and the environment was reset
+} EnvObs;
+
+typedef struct {
+    Court *courts;
+    uint32_t *now;              // Clock of each court (ms)
+    size_t num;                 // Number of environments
+    int num_leds;               // Court length
+    uint32_t step_ms;           // Time step
+} Env;
+
+/**
+ * @brief Allocate 'num' environments
+ *
+ * Log levels are left to the caller; per-hit log lines would dominate the
+ * step time, so raise GAME_LOG_TAG to warnings first.
+ *
+ * @param env Environment batch
+ * @param num Number of environments
+ * @param num_leds Court length in LEDs
+ * @param step_ms Time step, 0 for ENV_STEP_MS
+ * @return `ESP_OK` on success
+ */
+esp_err_t env_init(Env *env, size_t num, int num_leds, uint32_t step_ms);
+
+/**
+ * @brief Free all environments
+ */
+void env_free(Env *env);
+
+/**
+ * @brief Start new games in environments first..first+count-1
+ *
+ * @param obs Observations, indexed by environment number, may be NULL
+ */
+void env_reset(Env *env, size_t first, size_t count, EnvObs *obs);
+
+/**
+ * @brief Advance environments first..first+count-1 by one time step
+ *
+ * @param env Environment batch
+ * @param first First environment
+ * @param count Number of environments
+ * @param actions ENV_PRESS_* bits, indexed by environment number
+ * @param[out] obs Observations, indexed by environment number
+ * @param[out] frames Rendered courts, 'num_leds' pixels per environment and
+ *             indexed by environment number, or NULL to skip rendering
+ */
+void env_step(Env *env, size_t first, size_t count, const uint8_t *actions, EnvObs *obs, rgb_t *frames);
+
+#endif /* ENV_H */
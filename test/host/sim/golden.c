@@ -0,0 +1,228 @@
+#include "golden.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replay.h"
+
+#define HASH_SEED 0x243f6a8885a308d3ull
+#define HASH_MUL 0x9e3779b97f4a7c15ull
+#define REPORT_MAX_LEDS 16          // LEDs listed in a mismatch report
+
+static const char *state_names[GAME_STATE_COUNT] = {
+    "INIT", "WAIT_SERVE", "PLAYING", "POINT_SCORED", "GAME_OVER", "WAIT_RESTART",
+};
+
+// --- Hash ---
+static inline uint64_t mix(uint64_t h, uint64_t w) {
+    h = (h ^ w) * HASH_MUL;
+    return h ^ (h >> 29);
+}
+
+uint64_t golden_hash(uint64_t hash, const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint64_t w;
+    for (; len >= 8; p += 8, len -= 8) {
+        memcpy(&w, p, 8); // Little-endian on both the ESP32 and common hosts
+        hash = mix(hash, w);
+    }
+    w = (uint64_t)len << 56;
+    memcpy(&w, p, len);
+    return mix(hash, w);
+}
+
+static uint64_t hash_frame(uint64_t hash, uint32_t frame, const rgb_t *pixels, int num_leds) {
+    return golden_hash(mix(hash, frame), pixels, num_leds * sizeof(rgb_t));
+}
+
+// --- Golden file ---
+typedef struct {
+    char *line;                 // Current line, from getline()
+    size_t size;
+    bool have;                  // 'frame', 'hash' and 'changes' hold the next flushed frame
+    uint32_t frame;
+    uint64_t hash;
+    const char *changes;        // "<led>=<rrggbb>..." of that frame
+} GoldenReader;
+
+// Reads the next "<frame> <hash> <changes>" line; false at "end" or the end
+// of the file
+static bool next_golden(GoldenReader *reader, FILE *golden) {
+    while (getline(&reader->line, &reader->size, golden) > 0) {
+        if (reader->line[0] == '#') continue;
+        int n = 0;
+        reader->have = sscanf(reader->line, "%" SCNu32 " %" SCNx64 "%n", &reader->frame, &reader->hash, &n) == 2;
+        reader->changes = reader->line + n;
+        return reader->have;
+    }
+    return reader->have = false;
+}
+
+// Applies the LED changes of a golden line to 'frame'; false if malformed
+static bool apply_changes(const char *changes, rgb_t *frame, int num_leds) {
+    int led, n;
+    unsigned color;
+    while (sscanf(changes, " %d=%6x%n", &led, &color, &n) == 2) {
+        if (led < 0 || led >= num_leds) return false;
+        frame[led] = (rgb_t){ .r = color >> 16, .g = color >> 8, .b = color };
+        changes += n;
+    }
+    return true;
+}
+
+static void put_color(FILE *f, rgb_t c) {
+    fprintf(f, "%02x%02x%02x", c.r, c.g, c.b);
+}
+
+// Writes the LEDs of 'pixels' that differ from 'prev'
+static void put_changes(FILE *golden, const rgb_t *prev, const rgb_t *pixels, int num_leds) {
+    for (int i = 0; i < num_leds; i++) {
+        if (!memcmp(&prev[i], &pixels[i], sizeof(rgb_t))) continue;
+        fprintf(golden, " %d=", i);
+        put_color(golden, pixels[i]);
+    }
+}
+
+esp_err_t golden_record(FILE *inputs, int num_leds, FILE *golden, GoldenResult *result) {
+    size_t frame_size = num_leds * sizeof(rgb_t);
+    rgb_t *prev = calloc(num_leds, sizeof(rgb_t)); // The strip starts dark
+    if (!prev) return ESP_ERR_NO_MEM;
+    Replay replay;
+    esp_err_t err = replay_init(&replay, inputs, num_leds, 0);
+    if (err != ESP_OK) {
+        free(prev);
+        return err;
+    }
+    *result = (GoldenResult){ .hash = HASH_SEED, .match = true };
+
+    fprintf(golden, "# golden %d LEDs, %d ms frames\n", num_leds, GOLDEN_FRAME_MS);
+    const rgb_t *pixels;
+    bool changed; // Dirty flag of the engine, a flush may still be byte-identical
+    for (uint32_t f = 0; (pixels = replay_frame(&replay, f * GOLDEN_FRAME_MS, &changed)); f++) {
+        result->frames++;
+        if (!memcmp(pixels, prev, frame_size)) continue;
+        result->flushed++;
+        result->hash = hash_frame(result->hash, f, pixels, num_leds);
+        fprintf(golden, "%" PRIu32 " %016" PRIx64, f, result->hash);
+        put_changes(golden, prev, pixels, num_leds);
+        fputc('\n', golden);
+        memcpy(prev, pixels, frame_size);
+    }
+    fprintf(golden, "end %" PRIu32 " %016" PRIx64 "\n", result->frames, result->hash);
+    replay_free(&replay);
+    free(prev);
+    return ferror(golden) ? ESP_FAIL : ESP_OK;
+}
+
+// --- Report ---
+// One character per LED: '.' off, otherwise the strongest channel
+static void put_strip(FILE *f, const rgb_t *pixels, int num_leds) {
+    for (int i = 0; i < num_leds; i++) {
+        rgb_t c = pixels[i];
+        char ch = '.';
+        if (c.r || c.g || c.b) {
+            ch = c.r >= c.g && c.r >= c.b ? 'R' : c.g >= c.b ? 'G' : 'B';
+            if (c.r && c.g && c.b) ch = 'W';
+        }
+        fputc(ch, f);
+    }
+    fputc('\n', f);
+}
+
+// 'reader' holds the next golden line, 'expected' the frame the golden
+// file shows at 'frame'
+static void report_mismatch(FILE *report, const Replay *replay, uint32_t frame, bool flushed,
+                            const GoldenReader *reader, uint64_t actual_hash, const rgb_t *expected,
+                            const rgb_t *actual, int num_leds) {
+    const Court *court = &replay->court;
+    fprintf(report, "First divergent frame %" PRIu32 " (%" PRIu32 " ms)", frame, frame * GOLDEN_FRAME_MS);
+    if (!flushed) {
+        fprintf(report, ": expected a change, got none\n");
+    } else if (!reader->have) {
+        fprintf(report, ": changed after the last golden frame\n");
+    } else if (reader->frame != frame) {
+        fprintf(report, ": changed, expected no change until frame %" PRIu32 "\n", reader->frame);
+    } else {
+        fprintf(report, ": hash %016" PRIx64 ", expected %016" PRIx64 "\n", actual_hash, reader->hash);
+    }
+    fprintf(report, "Court: %s, ball %.1f moving %s, lives %d:%d, rally %d\n", state_names[court->state],
+            court->ball.position, court->ball.direction == LEFT ? "left" : court->ball.direction == RIGHT ? "right" : "-",
+            court->player1.lives, court->player2.lives, court->rallyCount);
+    fprintf(report, "Expected: ");
+    put_strip(report, expected, num_leds);
+    fprintf(report, "Actual:   ");
+    put_strip(report, actual, num_leds);
+    int shown = 0, differing = 0;
+    for (int i = 0; i < num_leds; i++) {
+        if (!memcmp(&expected[i], &actual[i], sizeof(rgb_t))) continue;
+        if (differing++ >= REPORT_MAX_LEDS) continue;
+        fprintf(report, "  LED %3d: expected ", i);
+        put_color(report, expected[i]);
+        fprintf(report, ", got ");
+        put_color(report, actual[i]);
+        fputc('\n', report);
+        shown++;
+    }
+    if (differing > shown) fprintf(report, "  ... %d more LEDs differ\n", differing - shown);
+}
+
+esp_err_t golden_check(FILE *inputs, int num_leds, FILE *golden, FILE *report, GoldenResult *result) {
+    size_t frame_size = num_leds * sizeof(rgb_t);
+    rgb_t *prev = calloc(num_leds, sizeof(rgb_t));      // Previous actual frame
+    rgb_t *expected = calloc(num_leds, sizeof(rgb_t));  // Frame rebuilt from the golden file
+    if (!prev || !expected) {
+        free(prev);
+        free(expected);
+        return ESP_ERR_NO_MEM;
+    }
+    Replay replay;
+    esp_err_t err = replay_init(&replay, inputs, num_leds, 0);
+    if (err != ESP_OK) {
+        free(prev);
+        free(expected);
+        return err;
+    }
+    *result = (GoldenResult){ .hash = HASH_SEED, .match = true };
+
+    GoldenReader reader = { 0 };
+    next_golden(&reader, golden);
+    const rgb_t *pixels;
+    bool changed;
+    for (uint32_t f = 0; (pixels = replay_frame(&replay, f * GOLDEN_FRAME_MS, &changed)); f++) {
+        result->frames++;
+        bool flushed = memcmp(pixels, prev, frame_size) != 0;
+        bool due = reader.have && reader.frame == f;
+        if (due && !apply_changes(reader.changes, expected, num_leds)) {
+            if (report) fprintf(report, "Malformed golden line for frame %" PRIu32 "\n", f);
+            err = ESP_FAIL;
+            break;
+        }
+        if (flushed) {
+            result->flushed++;
+            result->hash = hash_frame(result->hash, f, pixels, num_leds);
+        }
+        if (flushed != due || (flushed && result->hash != reader.hash)) {
+            result->match = false;
+            result->first_mismatch = f;
+            if (report) report_mismatch(report, &replay, f, flushed, &reader, result->hash, expected, pixels, num_leds);
+            break;
+        }
+        if (flushed) {
+            memcpy(prev, pixels, frame_size);
+            next_golden(&reader, golden);
+        }
+    }
+    if (err == ESP_OK && result->match && reader.have) {
+        // The scenario ended early
+        result->match = false;
+        result->first_mismatch = result->frames;
+        if (report) {
+            fprintf(report, "Scenario ended after %" PRIu32 " frames, expected a change at frame %" PRIu32 "\n",
+                    result->frames, reader.frame);
+        }
+    }
+    free(reader.line);
+    free(prev);
+    free(expected);
+    replay_free(&replay);
+    return err;
+}
@@ -0,0 +1,61 @@
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "rgb.h"
+
+// Golden-frame regression checks for render changes (colours, layout,
+// animations) without eyes on the hardware, e.g. in a host build. A
+// scenario is an input log (see replay.h) played through the court engine
+// in GOLDEN_FRAME_MS frames. Every frame that would be flushed, i.e. whose
+// bytes differ from the previous frame (the strip starts dark), is folded
+// into a rolling 64-bit hash together with its frame number.
+//
+// Golden file: text, a header line, then "<frame> <hash> <led>=<rrggbb>..."
+// for each flushed frame, listing the LEDs that changed and their new
+// colours, and "end <frames> <hash>" with the final hash. The first line
+// that differs from the golden file is the first divergent frame; as the
+// hash rolls, nothing before it differs. The LED changes let the check
+// rebuild the expected frame, so the report shows expected against actual
+// pixels at that frame.
+
+#define GOLDEN_FRAME_MS 10          // Frame step, as netplay
+
+typedef struct {
+    uint32_t frames;            // Frames played
+    uint32_t flushed;           // ... of them differing from the previous frame
+    uint64_t hash;              // Rolling hash after the last flushed frame
+    bool match;                 // golden_check(): all frames matched
+    uint32_t first_mismatch;    // golden_check(): first divergent frame if not
+} GoldenResult;
+
+/**
+ * @brief Fold 'len' bytes into a hash
+ */
+uint64_t golden_hash(uint64_t hash, const void *data, size_t len);
+
+/**
+ * @brief Play a scenario and write its golden file
+ *
+ * @param inputs Input log of the scenario
+ * @param num_leds Court length
+ * @param golden Golden file to write
+ */
+esp_err_t golden_record(FILE *inputs, int num_leds, FILE *golden, GoldenResult *result);
+
+/**
+ * @brief Play a scenario and compare it with its golden file
+ *
+ * Stops at the first divergent frame and describes it on 'report'.
+ *
+ * @param report Where to describe a mismatch, e.g. stderr, or NULL
+ * @return `ESP_OK` if the scenario ran, also on a mismatch (see 'result'),
+ *         `ESP_FAIL` on a malformed golden file
+ */
+esp_err_t golden_check(FILE *inputs, int num_leds, FILE *golden, FILE *report, GoldenResult *result);
+
+#endif // GOLDEN_H
@@ -0,0 +1,57 @@
+#include "replay.h"
+#include <string.h>
+
+// Reads the next press of the input log
+static void next_press(Replay *replay) {
+    char line[80];
+    while (fgets(line, sizeof(line), replay->log)) {
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        unsigned long t;
+        int player;
+        if (sscanf(line, "%lu %d", &t, &player) == 2 && (player == 1 || player == 2)) {
+            replay->press_ms = t;
+            replay->player = player;
+            replay->pending = true;
+            return;
+        }
+    }
+    replay->pending = false;
+}
+
+// Fires the court's timers from deadline to deadline up to 'until'
+static void run_until(Replay *replay, uint32_t until) {
+    int32_t wait;
+    while ((wait = court_next_timer(&replay->court, replay->now)) >= 0 && replay->now + wait <= until) {
+        replay->now += wait;
+        court_process_timers(&replay->court, replay->now);
+    }
+    replay->now = until;
+}
+
+esp_err_t replay_init(Replay *replay, FILE *log, int num_leds, uint32_t tail_ms) {
+    *replay = (Replay){ .log = log, .tail_ms = tail_ms ? tail_ms : REPLAY_TAIL_MS };
+    esp_err_t err = court_init(&replay->court, 0, num_leds);
+    if (err != ESP_OK) return err;
+    court_start(&replay->court, 0);
+    replay->end_ms = replay->tail_ms;
+    next_press(replay);
+    return ESP_OK;
+}
+
+void replay_free(Replay *replay) {
+    court_free(&replay->court);
+}
+
+const rgb_t *replay_frame(Replay *replay, uint32_t frame_ms, bool *changed) {
+    while (replay->pending && replay->press_ms <= frame_ms) {
+        run_until(replay, replay->press_ms < replay->now ? replay->now : replay->press_ms);
+        court_dispatch(&replay->court, replay->player == 1 ? EVENT_P1_PRESS : EVENT_P2_PRESS, replay->now);
+        replay->presses++;
+        replay->end_ms = replay->now + replay->tail_ms;
+        next_press(replay);
+    }
+    if (!replay->pending && frame_ms > replay->end_ms) return NULL;
+    run_until(replay, frame_ms);
+    return court_render(&replay->court, changed);
+}
@@ -0,0 +1,53 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "game.h"
+
+// Plays a recorded input log through the court engine, frame by frame, as
+// fast as the caller takes the frames (e.g. for video export or golden-frame
+// checks in a host build).
+//
+// Input log: text lines "<ms> <player>", a button press of player 1 or 2 at
+// that time since the court started; '#' starts a comment. The court starts
+// with court_start() at 0 ms and its timers fire at their exact deadlines
+// between frames, so the frames do not depend on the frame rate. Log levels
+// are left to the caller, e.g. GAME_LOG_TAG raised to warnings for long logs.
+
+#define REPLAY_TAIL_MS 5000         // Default time played after the last press
+
+typedef struct {
+    Court court;
+    FILE *log;
+    uint32_t now;               // Court time (ms)
+    uint32_t tail_ms;
+    uint32_t end_ms;            // Replay ends after this
+    bool pending;               // 'press_ms'/'player' hold the next press
+    uint32_t press_ms;
+    int player;
+    uint32_t presses;           // Presses dispatched
+} Replay;
+
+/**
+ * @brief Start a court of 'num_leds' LEDs on an input log
+ *
+ * @param tail_ms Time played after the last press, 0 for REPLAY_TAIL_MS
+ */
+esp_err_t replay_init(Replay *replay, FILE *log, int num_leds, uint32_t tail_ms);
+
+void replay_free(Replay *replay);
+
+/**
+ * @brief Play up to 'frame_ms' and render the frame shown then
+ *
+ * @param frame_ms Frame time, not before the previous one
+ * @param[out] changed Set to true if the frame differs from the previous one
+ * @return Frame of 'num_leds' pixels, or NULL once the log and its tail are over
+ */
+const rgb_t *replay_frame(Replay *replay, uint32_t frame_ms, bool *changed);
+
+#endif // REPLAY_H
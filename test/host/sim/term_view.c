@@ -0,0 +1,213 @@
+#include "term_view.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "env.h"
+
+#define CELL_MAX_BYTES 35           // "\e[rrrrr;cccccH" + "\e[48;2;rrr;ggg;bbbm" + "  "
+#define FRAME_EXTRA_BYTES 32        // Colour reset and cursor park
+
+#define ESC "\x1b"
+
+static const char clear_screen[] = ESC "[2J" ESC "[?25l"; // Also hides the cursor
+static const char restore_screen[] = ESC "[0m" ESC "[?25h";
+
+// --- Output ---
+static char *put_str(char *p, const char *s, size_t len) {
+    memcpy(p, s, len);
+    return p + len;
+}
+
+static char *put_uint(char *p, unsigned v) {
+    char digits[10];
+    int n = 0;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    while (n) *p++ = digits[--n];
+    return p;
+}
+
+static char *put_move(char *p, int row, int col) {
+    p = put_str(p, ESC "[", 2);
+    p = put_uint(p, row);
+    *p++ = ';';
+    p = put_uint(p, col);
+    *p++ = 'H';
+    return p;
+}
+
+static char *put_background(char *p, rgb_t c) {
+    p = put_str(p, ESC "[48;2;", 7);
+    p = put_uint(p, c.r);
+    *p++ = ';';
+    p = put_uint(p, c.g);
+    *p++ = ';';
+    p = put_uint(p, c.b);
+    *p++ = 'm';
+    return p;
+}
+
+static bool write_all(int fd, const char *buf, size_t len) {
+    while (len) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            // Non-blocking, e.g. through a keyboard descriptor sharing the tty
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+                if (poll(&pfd, 1, -1) >= 0 || errno == EINTR) continue;
+            }
+            return false;
+        }
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+
+static inline bool same_color(rgb_t a, rgb_t b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+// --- View ---
+esp_err_t term_view_init(TermView *view, int out_fd, int in_fd, int num_leds, int columns, uint32_t max_fps) {
+    if (num_leds <= 0) return ESP_ERR_INVALID_ARG;
+    *view = (TermView){
+        .out_fd = out_fd,
+        .in_fd = in_fd,
+        .in_flags = -1,
+        .num_leds = num_leds,
+        .columns = columns > 0 ? columns : TERM_VIEW_COLUMNS,
+        .keys_p1 = TERM_VIEW_KEYS_P1,
+        .keys_p2 = TERM_VIEW_KEYS_P2,
+        .min_interval_us = max_fps ? 1000000 / max_fps : 0,
+        .out_size = (size_t)num_leds * CELL_MAX_BYTES + FRAME_EXTRA_BYTES,
+    };
+    view->last_draw_us = -view->min_interval_us;
+    view->shown = calloc(num_leds, sizeof(rgb_t));
+    view->out = malloc(view->out_size);
+    if (!view->shown || !view->out) {
+        term_view_free(view);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (in_fd >= 0 && isatty(in_fd) && tcgetattr(in_fd, &view->saved_termios) == 0) {
+        struct termios raw = view->saved_termios;
+        raw.c_lflag &= ~(ICANON | ECHO | ISIG); // Ctrl-C arrives as a key
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        view->raw = tcsetattr(in_fd, TCSANOW, &raw) == 0;
+    }
+    // A raw terminal returns from read() at once. Anything else is made
+    // non-blocking; on a tty that also affects the output descriptors
+    // sharing it, which write_all() copes with.
+    if (in_fd >= 0 && !view->raw) {
+        int flags = fcntl(in_fd, F_GETFL, 0);
+        if (flags >= 0 && !(flags & O_NONBLOCK) && fcntl(in_fd, F_SETFL, flags | O_NONBLOCK) == 0) {
+            view->in_flags = flags;
+        }
+    }
+
+    write_all(out_fd, clear_screen, sizeof(clear_screen) - 1);
+    return ESP_OK;
+}
+
+void term_view_free(TermView *view) {
+    if (view->out) {
+        // Leave the cursor below the strip
+        char *p = put_str(view->out, restore_screen, sizeof(restore_screen) - 1);
+        p = put_move(p, (view->num_leds + view->columns - 1) / view->columns + 1, 1);
+        *p++ = '\n';
+        write_all(view->out_fd, view->out, p - view->out);
+    }
+    if (view->raw) tcsetattr(view->in_fd, TCSANOW, &view->saved_termios);
+    view->raw = false;
+    // The descriptor is usually shared with the shell, leave it blocking again
+    if (view->in_flags >= 0) fcntl(view->in_fd, F_SETFL, view->in_flags);
+    view->in_flags = -1;
+    free(view->shown);
+    free(view->out);
+    view->shown = NULL;
+    view->out = NULL;
+}
+
+void term_view_invalidate(TermView *view) {
+    view->shown_valid = false;
+}
+
+void term_view_reset_stats(TermView *view) {
+    memset(&view->stats, 0, sizeof(view->stats));
+}
+
+bool term_view_draw(TermView *view, const rgb_t *frame, int64_t now_us) {
+    if (now_us - view->last_draw_us < view->min_interval_us) {
+        view->stats.skipped++;
+        return false;
+    }
+    view->last_draw_us = now_us;
+
+    char *p = view->out;
+    int next = -1;              // Cell the cursor is at after the last one written
+    bool have_color = false;
+    rgb_t color = { 0 };        // Current background
+    uint32_t cells = 0;
+    for (int i = 0; i < view->num_leds; i++) {
+        rgb_t c = frame[i];
+        if (view->shown_valid && same_color(c, view->shown[i])) continue;
+        view->shown[i] = c;
+        if (i != next || i % view->columns == 0) {
+            p = put_move(p, i / view->columns + 1, i % view->columns * 2 + 1);
+        }
+        if (!have_color || !same_color(c, color)) {
+            p = put_background(p, c);
+            color = c;
+            have_color = true;
+        }
+        p = put_str(p, "  ", 2);
+        next = i + 1;
+        cells++;
+    }
+    view->shown_valid = true;
+    if (!cells) {
+        view->stats.frames++; // Nothing changed, the screen is up to date
+        return true;
+    }
+    p = put_str(p, ESC "[0m", 4);
+    p = put_move(p, (view->num_leds + view->columns - 1) / view->columns + 1, 1);
+
+    size_t len = p - view->out;
+    if (!write_all(view->out_fd, view->out, len)) {
+        view->shown_valid = false; // Unknown what made it to the screen
+        return false;
+    }
+    view->stats.frames++;
+    view->stats.cells += cells;
+    view->stats.bytes += len;
+    return true;
+}
+
+// --- Keyboard ---
+uint8_t term_view_keys(TermView *view) {
+    if (view->in_fd < 0) return 0;
+    uint8_t presses = 0;
+    char keys[32];
+    ssize_t n;
+    while ((n = read(view->in_fd, keys, sizeof(keys))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            char k = keys[i];
+            if (k == 0x1b || k == 0x03) {
+                presses |= TERM_VIEW_QUIT;
+            } else if (k && strchr(view->keys_p1, k)) {
+                presses |= ENV_PRESS_P1;
+            } else if (k && strchr(view->keys_p2, k)) {
+                presses |= ENV_PRESS_P2;
+            }
+        }
+    }
+    return presses;
+}
@@ -0,0 +1,97 @@
+#ifndef TERM_VIEW_H
+#define TERM_VIEW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <termios.h>
+#include "esp_err.h"
+#include "rgb.h"
+
+// Live view of a strip in an ANSI truecolor terminal, for watching courts run
+// in a host build (e.g. through env_step()). Each LED is a cell of two
+// spaces on a background of its colour, wrapped into rows of 'columns' cells.
+//
+// Only cells whose colour changed since the last drawn frame are redrawn: a
+// run of changed cells needs one cursor move and cells of the same colour
+// one colour escape. The escape sequences of a frame are collected in a
+// buffer sized for the worst case at init and written with a single write().
+// A frame rate limit skips frames the terminal could not show anyway, so
+// fast replays are not held up by the view; the next drawn frame catches up
+// with everything that changed.
+//
+// The keyboard maps to the two buttons: keys are read without echo or line
+// buffering and returned as ENV_PRESS_P1/ENV_PRESS_P2 bits.
+
+#define TERM_VIEW_COLUMNS 40        // Default cells per row, 80 terminal columns
+#define TERM_VIEW_KEYS_P1 "aA"      // Default keys of player 1 (left button)
+#define TERM_VIEW_KEYS_P2 "lL"      // Default keys of player 2 (right button)
+#define TERM_VIEW_QUIT 0x80         // term_view_keys(): Esc or Ctrl-C pressed
+
+typedef struct {
+    uint32_t frames;            // Frames written
+    uint32_t skipped;           // Frames left out by the rate limit
+    uint32_t cells;             // Cells redrawn
+    uint32_t bytes;             // Bytes written
+} TermViewStats;
+
+typedef struct {
+    int out_fd;
+    int in_fd;                  // Keyboard, -1 for none
+    int in_flags;               // File status flags of 'in_fd' before init, -1 if unchanged
+    int num_leds;
+    int columns;                // Cells per row
+    const char *keys_p1;
+    const char *keys_p2;
+    int64_t min_interval_us;    // From max_fps
+    int64_t last_draw_us;
+    rgb_t *shown;               // Colours on screen
+    bool shown_valid;           // 'shown' matches the screen
+    char *out;                  // Escape sequences of one frame
+    size_t out_size;
+    struct termios saved_termios; // Restored by term_view_free()
+    bool raw;
+    TermViewStats stats;        // Since init or term_view_reset_stats()
+} TermView;
+
+/**
+ * @brief Clear the terminal and prepare the view
+ *
+ * @param out_fd Terminal to draw on, e.g. STDOUT_FILENO
+ * @param in_fd Terminal to read keys from, e.g. STDIN_FILENO, or -1
+ * @param num_leds Strip length
+ * @param columns Cells per row, 0 for TERM_VIEW_COLUMNS
+ * @param max_fps Frame rate limit, 0 for none
+ */
+esp_err_t term_view_init(TermView *view, int out_fd, int in_fd, int num_leds, int columns, uint32_t max_fps);
+
+/**
+ * @brief Restore the terminal and free the buffers
+ */
+void term_view_free(TermView *view);
+
+/**
+ * @brief Draw a frame, redrawing only the cells that changed
+ *
+ * @param frame 'num_leds' colours
+ * @param now_us Current time for the frame rate limit
+ * @return true if the frame was written, false if skipped or the write failed
+ */
+bool term_view_draw(TermView *view, const rgb_t *frame, int64_t now_us);
+
+/**
+ * @brief Redraw every cell with the next frame, e.g. after other output
+ */
+void term_view_invalidate(TermView *view);
+
+/**
+ * @brief Read the pending keys without blocking
+ *
+ * @return ENV_PRESS_P1/ENV_PRESS_P2 bits of the buttons pressed, plus
+ *         TERM_VIEW_QUIT if Esc or Ctrl-C was pressed
+ */
+uint8_t term_view_keys(TermView *view);
+
+void term_view_reset_stats(TermView *view);
+
+#endif // TERM_VIEW_H
@@ -0,0 +1,270 @@
+#include "video.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "replay.h"
+
+static const char *TAG = "Video";
+
+#define GLOW_CORE 0.30f             // Core width, fraction of 'scale'
+#define GLOW_HALO 0.90f             // Halo width, fraction of 'scale'
+#define GLOW_HALO_LEVEL 0.35f       // Halo brightness relative to the core
+#define PNG_BLOCK 65535             // Longest stored deflate block
+
+// --- Glow ---
+static float glow(float d, int scale) {
+    float core = d / (GLOW_CORE * scale);
+    float halo = d / (GLOW_HALO * scale);
+    float w = expf(-core * core) + GLOW_HALO_LEVEL * expf(-halo * halo);
+    return w > 1.0f ? 1.0f : w;
+}
+
+// Spreads the LEDs over one row of pixels; black LEDs cost nothing
+static void render_row(Video *video, const rgb_t *frame) {
+    int width = video->width;
+    memset(video->row, 0, width * 3 * sizeof(uint16_t));
+    for (int i = 0; i < video->num_leds; i++) {
+        rgb_t c = frame[i];
+        if (!c.r && !c.g && !c.b) continue;
+        int center = i * video->scale + video->scale / 2;
+        int from = center - video->radius < 0 ? 0 : center - video->radius;
+        int to = center + video->radius >= width ? width - 1 : center + video->radius;
+        const uint16_t *k = video->kernel_x + video->radius - center;
+        for (int x = from; x <= to; x++) {
+            uint16_t *p = &video->row[x * 3];
+            p[0] += (c.r * k[x]) >> 8;
+            p[1] += (c.g * k[x]) >> 8;
+            p[2] += (c.b * k[x]) >> 8;
+        }
+    }
+}
+
+static inline uint8_t glow_pixel(uint16_t v, uint16_t ky) {
+    uint32_t p = ((uint32_t)v * ky) >> 8;
+    return p > 255 ? 255 : p;
+}
+
+// --- Y4M ---
+static esp_err_t write_y4m(Video *video) {
+    int w = video->width;
+    size_t plane = (size_t)w * video->height;
+    uint8_t *y_plane = video->image;
+    uint8_t *u_plane = y_plane + plane;
+    uint8_t *v_plane = u_plane + plane;
+    for (int y = 0; y < video->height; y++) {
+        uint16_t ky = video->kernel_y[y];
+        for (int x = 0; x < w; x++) {
+            const uint16_t *p = &video->row[x * 3];
+            int r = glow_pixel(p[0], ky), g = glow_pixel(p[1], ky), b = glow_pixel(p[2], ky);
+            // BT.601, studio range
+            size_t o = (size_t)y * w + x;
+            y_plane[o] = 16 + ((66 * r + 129 * g + 25 * b + 128) >> 8);
+            u_plane[o] = 128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8);
+            v_plane[o] = 128 + ((112 * r - 94 * g - 18 * b + 128) >> 8);
+        }
+    }
+    if (fputs("FRAME\n", video->out) < 0 || fwrite(video->image, 3, plane, video->out) != plane) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// --- PNG ---
+// Uncompressed (stored deflate blocks): no zlib needed, and writing stays
+// far faster than real time.
+static uint32_t crc_table[256];
+
+static void crc_init() {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+        crc_table[n] = c;
+    }
+}
+
+static uint32_t crc_update(uint32_t crc, const uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) crc = crc_table[(crc ^ buf[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static bool write_chunk(FILE *f, const char *type, const uint8_t *data, size_t len) {
+    uint8_t head[8], tail[4];
+    put_be32(head, len);
+    memcpy(head + 4, type, 4);
+    put_be32(tail, crc_update(crc_update(0xffffffff, head + 4, 4), data, len) ^ 0xffffffff);
+    return fwrite(head, 1, 8, f) == 8 && (!len || fwrite(data, 1, len, f) == len) && fwrite(tail, 1, 4, f) == 4;
+}
+
+static size_t png_raw_size(const Video *video) {
+    return (size_t)video->height * (1 + video->width * 3); // Filter byte per row
+}
+
+// 'image' holds the zlib stream: header, stored blocks, Adler-32
+static size_t png_zlib_size(const Video *video) {
+    size_t raw = png_raw_size(video);
+    return 2 + (raw + PNG_BLOCK - 1) / PNG_BLOCK * 5 + raw + 4;
+}
+
+static uint32_t adler32(const uint8_t *buf, size_t len) {
+    uint32_t a = 1, b = 0;
+    while (len) {
+        size_t n = len < 5552 ? len : 5552; // Longest run before b can overflow
+        len -= n;
+        while (n--) {
+            a += *buf++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+static esp_err_t write_png(Video *video) {
+    int w = video->width;
+    size_t raw_size = png_raw_size(video);
+    uint8_t *raw = video->image + png_zlib_size(video);
+    uint8_t *p = raw;
+    for (int y = 0; y < video->height; y++) {
+        uint16_t ky = video->kernel_y[y];
+        *p++ = 0; // Filter: none
+        for (int x = 0; x < w * 3; x++) *p++ = glow_pixel(video->row[x], ky);
+    }
+
+    uint8_t *z = video->image;
+    *z++ = 0x78; // Deflate, 32K window
+    *z++ = 0x01;
+    for (size_t done = 0; done < raw_size;) {
+        size_t n = raw_size - done < PNG_BLOCK ? raw_size - done : PNG_BLOCK;
+        *z++ = done + n == raw_size; // Last block
+        *z++ = n;
+        *z++ = n >> 8;
+        *z++ = ~n;
+        *z++ = ~n >> 8;
+        memcpy(z, raw + done, n);
+        z += n;
+        done += n;
+    }
+    put_be32(z, adler32(raw, raw_size));
+
+    char name[256];
+    snprintf(name, sizeof(name), video->png_pattern, (int)video->frames);
+    FILE *f = fopen(name, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Cannot create %s", name);
+        return ESP_FAIL;
+    }
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    uint8_t ihdr[13] = { 0 };
+    put_be32(ihdr, w);
+    put_be32(ihdr + 4, video->height);
+    ihdr[8] = 8; // Bits per channel
+    ihdr[9] = 2; // RGB
+    bool ok = fwrite(signature, 1, sizeof(signature), f) == sizeof(signature) &&
+              write_chunk(f, "IHDR", ihdr, sizeof(ihdr)) &&
+              write_chunk(f, "IDAT", video->image, png_zlib_size(video)) &&
+              write_chunk(f, "IEND", NULL, 0);
+    if (fclose(f) != 0) ok = false;
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+// --- Video ---
+esp_err_t video_open(Video *video, VideoFormat format, const char *path, int num_leds, int scale, int fps) {
+    if (num_leds <= 0 || !path) return ESP_ERR_INVALID_ARG;
+    *video = (Video){
+        .format = format,
+        .num_leds = num_leds,
+        .scale = scale > 0 ? scale : VIDEO_SCALE,
+        .fps = fps > 0 ? fps : VIDEO_FPS,
+    };
+    video->width = num_leds * video->scale;
+    video->height = video->scale;
+    video->radius = video->scale * 3 / 2; // Into the neighbours' cells
+
+    size_t image_size = format == VIDEO_Y4M ? (size_t)video->width * video->height * 3
+                                             : png_zlib_size(video) + png_raw_size(video);
+    video->kernel_x = malloc((2 * video->radius + 1) * sizeof(uint16_t));
+    video->kernel_y = malloc(video->height * sizeof(uint16_t));
+    video->row = malloc(video->width * 3 * sizeof(uint16_t));
+    video->image = malloc(image_size);
+    video->frame = malloc(num_leds * sizeof(rgb_t));
+    if (!video->kernel_x || !video->kernel_y || !video->row || !video->image || !video->frame) {
+        video_close(video);
+        return ESP_ERR_NO_MEM;
+    }
+    for (int d = -video->radius; d <= video->radius; d++) {
+        video->kernel_x[d + video->radius] = 256 * glow(d, video->scale) + 0.5f;
+    }
+    for (int y = 0; y < video->height; y++) {
+        video->kernel_y[y] = 256 * glow(y - (video->height - 1) / 2.0f, video->scale) + 0.5f;
+    }
+
+    if (format == VIDEO_PNG) {
+        crc_init();
+        video->png_pattern = path;
+    } else {
+        video->out = strcmp(path, "-") ? fopen(path, "wb") : stdout;
+        if (!video->out) {
+            ESP_LOGE(TAG, "Cannot create %s", path);
+            video_close(video);
+            return ESP_FAIL;
+        }
+        fprintf(video->out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", video->width, video->height, video->fps);
+    }
+    return ESP_OK;
+}
+
+esp_err_t video_close(Video *video) {
+    esp_err_t err = ESP_OK;
+    if (video->out && video->out != stdout && fclose(video->out) != 0) err = ESP_FAIL;
+    if (video->out == stdout && fflush(stdout) != 0) err = ESP_FAIL;
+    video->out = NULL;
+    free(video->kernel_x);
+    free(video->kernel_y);
+    free(video->row);
+    free(video->image);
+    free(video->frame);
+    video->kernel_x = video->kernel_y = video->row = NULL;
+    video->image = NULL;
+    video->frame = NULL;
+    return err;
+}
+
+esp_err_t video_write(Video *video, const rgb_t *frame) {
+    render_row(video, frame);
+    esp_err_t err = video->format == VIDEO_Y4M ? write_y4m(video) : write_png(video);
+    if (err == ESP_OK) video->frames++;
+    return err;
+}
+
+// --- Replays ---
+esp_err_t video_replay_inputs(Video *video, FILE *log, uint32_t tail_ms) {
+    Replay replay;
+    esp_err_t err = replay_init(&replay, log, video->num_leds, tail_ms);
+    if (err != ESP_OK) return err;
+    const rgb_t *frame;
+    bool changed;
+    // Frame times are rounded down to whole ms, without drifting
+    for (uint32_t n = 0; (frame = replay_frame(&replay, (uint64_t)n * 1000 / video->fps, &changed)); n++) {
+        err = video_write(video, frame);
+        if (err != ESP_OK) break;
+    }
+    replay_free(&replay);
+    return err;
+}
+
+esp_err_t video_replay_frames(Video *video, FILE *log) {
+    while (fread(video->frame, sizeof(rgb_t), video->num_leds, log) == (size_t)video->num_leds) {
+        esp_err_t err = video_write(video, video->frame);
+        if (err != ESP_OK) return err;
+    }
+    return ferror(log) ? ESP_FAIL : ESP_OK;
+}
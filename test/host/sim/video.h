@@ -0,0 +1,85 @@
+#ifndef VIDEO_H
+#define VIDEO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "rgb.h"
+
+// Video export of court frames, for match highlights and for reviewing
+// render changes off the hardware (e.g. in a host build). The output is a
+// Y4M stream (4:4:4, read by ffmpeg and most players) or a numbered PNG
+// sequence. Each LED becomes a dot of 'scale' x 'scale' pixels with a soft
+// glow that bleeds into its neighbours, much like the strip looks in a dark
+// room.
+//
+// Frames are rendered one at a time into buffers allocated at open and
+// written straight out, so memory stays flat however long the replay is.
+// Replays run as fast as the frames can be written, not in real time, from
+// an input log (see replay.h; a frame is taken every 1000 / fps ms) or from
+// a frame log: raw frames of 'num_leds' R, G, B bytes each, e.g. dumped
+// from a host run.
+
+#define VIDEO_SCALE 16              // Default pixels per LED
+#define VIDEO_FPS 50                // Default frame rate
+
+typedef enum {
+    VIDEO_Y4M,                  // One Y4M stream
+    VIDEO_PNG,                  // One PNG file per frame
+} VideoFormat;
+
+typedef struct {
+    VideoFormat format;
+    FILE *out;                  // Y4M stream
+    const char *png_pattern;    // printf pattern of the PNG file names, takes the frame number
+    int num_leds;
+    int scale;
+    int fps;
+    int width, height;          // Of the video
+    int radius;                 // Glow reach in pixels from the LED centre
+    uint16_t *kernel_x;         // 2 * radius + 1 horizontal glow weights, 256 = 1.0
+    uint16_t *kernel_y;         // 'height' vertical glow weights, 256 = 1.0
+    uint16_t *row;              // Glow of one frame along the strip, R, G, B per pixel
+    uint8_t *image;             // Encoded frame: Y4M planes, or a PNG zlib stream followed by its rows
+    rgb_t *frame;               // Frame read from a frame log
+    uint32_t frames;            // Frames written
+} Video;
+
+/**
+ * @brief Open a video and allocate all buffers
+ *
+ * @param format VIDEO_Y4M or VIDEO_PNG
+ * @param path Y4M: output file, "-" for stdout; PNG: printf pattern of the
+ *             file names, e.g. "frames/%06d.png"
+ * @param num_leds Strip length
+ * @param scale Pixels per LED, 0 for VIDEO_SCALE
+ * @param fps Frame rate, 0 for VIDEO_FPS
+ */
+esp_err_t video_open(Video *video, VideoFormat format, const char *path, int num_leds, int scale, int fps);
+
+/**
+ * @brief Finish the stream and free the buffers
+ */
+esp_err_t video_close(Video *video);
+
+/**
+ * @brief Render and write one frame of 'num_leds' pixels
+ */
+esp_err_t video_write(Video *video, const rgb_t *frame);
+
+/**
+ * @brief Play an input log through the court engine and write its frames
+ *
+ * @param log Input log
+ * @param tail_ms Time recorded after the last press, 0 for REPLAY_TAIL_MS
+ */
+esp_err_t video_replay_inputs(Video *video, FILE *log, uint32_t tail_ms);
+
+/**
+ * @brief Write every frame of a frame log
+ */
+esp_err_t video_replay_frames(Video *video, FILE *log);
+
+#endif // VIDEO_H
@@ -0,0 +1,11 @@
+/*
+ * Host stub of driver/gpio.h: pin numbers only
+ */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_NC -1
@@ -0,0 +1,7 @@
+/*
+ * Host stub of esp_attr.h: no memory placement on the host
+ */
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
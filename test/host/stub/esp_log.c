@@ -0,0 +1,56 @@
+/*
+ * Host stub of the ESP-IDF log: levels per tag, output to stderr
+ */
+#include "esp_log.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+
+#define MAX_TAGS 32
+
+static struct {
+    const char *tag;
+    esp_log_level_t level;
+} tags[MAX_TAGS];
+static size_t num_tags;
+static esp_log_level_t default_level = ESP_LOG_INFO;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    if (!strcmp(tag, "*")) {
+        default_level = level;
+        num_tags = 0;
+        return;
+    }
+    for (size_t i = 0; i < num_tags; i++) {
+        if (!strcmp(tags[i].tag, tag)) {
+            tags[i].level = level;
+            return;
+        }
+    }
+    if (num_tags < MAX_TAGS) {
+        tags[num_tags].tag = tag; // Tags are string constants, as on the device
+        tags[num_tags++].level = level;
+    }
+}
+
+esp_log_level_t esp_log_level_get(const char *tag) {
+    for (size_t i = 0; i < num_tags; i++) {
+        if (!strcmp(tags[i].tag, tag)) return tags[i].level;
+    }
+    return default_level;
+}
+
+uint32_t esp_log_timestamp(void) {
+    static int64_t start;
+    int64_t now = esp_timer_get_time();
+    if (!start) start = now;
+    return (now - start) / 1000;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
@@ -0,0 +1,106 @@
+/*
+ * Host stub of the RMT driver: runs the translators, sends nothing
+ */
+#include "driver/rmt.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    bool installed;
+    sample_to_rmt_t translator;
+    void *context;
+    size_t item_num;            // Passed to the translator, finds the channel again
+    rmt_item32_t *items;
+    size_t num_items;
+    size_t items_size;
+} channel_t;
+
+static channel_t channels[RMT_CHANNEL_MAX];
+static rmt_tx_end_callback_t tx_end;
+
+#define CHECK_CHANNEL(ch) do { if ((ch) < 0 || (ch) >= RMT_CHANNEL_MAX) return ESP_ERR_INVALID_ARG; } while (0)
+
+esp_err_t rmt_config(const rmt_config_t *config) {
+    CHECK_CHANNEL(config->channel);
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags) {
+    CHECK_CHANNEL(channel);
+    if (channels[channel].installed) return ESP_ERR_INVALID_STATE;
+    channels[channel].installed = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel) {
+    CHECK_CHANNEL(channel);
+    free(channels[channel].items);
+    memset(&channels[channel], 0, sizeof(channel_t));
+    return ESP_OK;
+}
+
+esp_err_t rmt_translator_init(rmt_channel_t channel, sample_to_rmt_t fn) {
+    CHECK_CHANNEL(channel);
+    if (!channels[channel].installed) return ESP_ERR_INVALID_STATE;
+    channels[channel].translator = fn;
+    return ESP_OK;
+}
+
+esp_err_t rmt_translator_set_context(rmt_channel_t channel, void *context) {
+    CHECK_CHANNEL(channel);
+    channels[channel].context = context;
+    return ESP_OK;
+}
+
+esp_err_t rmt_translator_get_context(const size_t *item_num, void **context) {
+    for (int i = 0; i < RMT_CHANNEL_MAX; i++) {
+        if (item_num == &channels[i].item_num) {
+            *context = channels[i].context;
+            return channels[i].context ? ESP_OK : ESP_ERR_INVALID_STATE;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rmt_write_sample(rmt_channel_t channel, const uint8_t *src, size_t src_size, bool wait_tx_done) {
+    CHECK_CHANNEL(channel);
+    channel_t *c = &channels[channel];
+    if (!c->translator) return ESP_ERR_INVALID_STATE;
+    c->num_items = 0;
+    while (src_size) {
+        if (c->num_items + RMT_STUB_CHUNK_ITEMS > c->items_size) {
+            size_t size = c->items_size ? c->items_size * 2 : 1024;
+            rmt_item32_t *items = realloc(c->items, size * sizeof(rmt_item32_t));
+            if (!items) return ESP_ERR_NO_MEM;
+            c->items = items;
+            c->items_size = size;
+        }
+        size_t translated = 0;
+        c->translator(src, c->items + c->num_items, src_size, RMT_STUB_CHUNK_ITEMS, &translated, &c->item_num);
+        if (!translated) break;
+        c->num_items += c->item_num;
+        src += translated;
+        src_size -= translated;
+    }
+    if (tx_end.function) tx_end.function(channel, tx_end.arg);
+    return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, TickType_t wait_time) {
+    CHECK_CHANNEL(channel);
+    return ESP_OK;
+}
+
+rmt_tx_end_callback_t rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void *arg) {
+    rmt_tx_end_callback_t previous = tx_end;
+    tx_end = (rmt_tx_end_callback_t){ .function = function, .arg = arg };
+    return previous;
+}
+
+void ets_delay_us(uint32_t us) {
+}
+
+const rmt_item32_t *rmt_stub_items(rmt_channel_t channel, size_t *num) {
+    *num = channels[channel].num_items;
+    return channels[channel].items;
+}
@@ -0,0 +1,9 @@
+/*
+ * Host stub: the sdkconfig of a plain ESP32 build with the component
+ * defaults, as far as the host sources look at it.
+ */
+#pragma once
+
+#define CONFIG_IDF_TARGET_ESP32 1
+#define CONFIG_IDF_TARGET "esp32"
+#define CONFIG_LED_STRIP_WHITE_LUT 1
@@ -0,0 +1,6 @@
+/*
+ * Host stub of soc/soc.h
+ */
+#pragma once
+
+#define APB_CLK_FREQ (80 * 1000000)
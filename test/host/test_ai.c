@@ -0,0 +1,96 @@
+// Computer players against each other through the training environment:
+// a match is decided by the seeds alone, so replaying a seed gives the same
+// winner, length and score, and the more accurate player wins most matches
+// from either side of the court.
+#include <stdbool.h>
+#include <string.h>
+#include "ai.h"
+#include "env.h"
+#include "esp_log.h"
+#include "host_test.h"
+
+#define NUM_LEDS 54
+#define MATCHES 64
+#define STEP_MS 1                   // Presses land on the millisecond the AI plans
+#define MAX_STEPS (30 * 60 * 1000)  // Half an hour of play
+#define REACTION_MS 180             // As the firmware
+// Below skill 128 the timing error can leave the paddle window, so both miss
+#define STRONG 100
+#define WEAK 60
+
+typedef struct {
+    int winner;                     // 1 or 2, 0 if the match did not end
+    uint32_t ms;                    // Match length
+    int winner_lives;               // Lives the winner had left
+} Result;
+
+static bool same(const Result *a, const Result *b) {
+    for (int i = 0; i < MATCHES; i++) {
+        if (a[i].winner != b[i].winner || a[i].ms != b[i].ms || a[i].winner_lives != b[i].winner_lives) return false;
+    }
+    return true;
+}
+
+// Plays one match in each of MATCHES environments, AI against AI; the AIs of
+// environment i get seeds derived from 'seed' and i
+static void play(Result *results, uint8_t skill1, uint8_t skill2, uint32_t seed) {
+    Env env;
+    static EnvObs obs[MATCHES];
+    static uint8_t actions[MATCHES];
+    static AiPlayer ai1[MATCHES], ai2[MATCHES];
+    TEST_ASSERT_EQUAL(ESP_OK, env_init(&env, MATCHES, NUM_LEDS, STEP_MS));
+    env_reset(&env, 0, MATCHES, obs);
+    memset(results, 0, MATCHES * sizeof(Result));
+    for (int i = 0; i < MATCHES; i++) {
+        ai_init(&ai1[i], 1, skill1, REACTION_MS, seed + 2 * i);
+        ai_init(&ai2[i], 2, skill2, REACTION_MS, seed + 2 * i + 1);
+    }
+
+    int open = MATCHES;
+    for (uint32_t step = 0; step < MAX_STEPS && open; step++) {
+        for (int i = 0; i < MATCHES; i++) {
+            bool p1, p2;
+            ai_update(&ai1[i], &env.courts[i], env.now[i], &p1);
+            ai_update(&ai2[i], &env.courts[i], env.now[i], &p2);
+            actions[i] = (p1 ? ENV_PRESS_P1 : 0) | (p2 ? ENV_PRESS_P2 : 0);
+        }
+        uint8_t lives[MATCHES][2];
+        for (int i = 0; i < MATCHES; i++) memcpy(lives[i], obs[i].lives, 2);
+        env_step(&env, 0, MATCHES, actions, obs, NULL);
+        for (int i = 0; i < MATCHES; i++) {
+            if (!obs[i].done || results[i].winner) continue;
+            // The loser lost the last life in this step
+            int winner = obs[i].reward[0] > 0 ? 1 : 2;
+            results[i] = (Result){ .winner = winner, .ms = env.now[i], .winner_lives = lives[i][winner - 1] };
+            open--;
+        }
+    }
+    env_free(&env);
+}
+
+int main() {
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+    static Result first[MATCHES], again[MATCHES], swapped[MATCHES];
+
+    // The same seeds play the same matches
+    play(first, STRONG, WEAK, 1000);
+    play(again, STRONG, WEAK, 1000);
+    TEST_ASSERT(same(first, again));
+    play(again, STRONG, WEAK, 2000);
+    TEST_ASSERT(!same(first, again));
+
+    // The stronger player wins from both sides
+    play(swapped, WEAK, STRONG, 1000);
+    int strong_wins = 0, ended = 0;
+    uint64_t total_ms = 0;
+    for (int i = 0; i < MATCHES; i++) {
+        TEST_ASSERT(first[i].winner && swapped[i].winner);
+        strong_wins += (first[i].winner == 1) + (swapped[i].winner == 2);
+        ended += 2;
+        total_ms += first[i].ms + swapped[i].ms;
+    }
+    printf("skill %d beat skill %d in %d of %d matches, %.1f s per match\n", STRONG, WEAK, strong_wins, ended,
+           total_ms / 1000.0 / ended);
+    TEST_ASSERT(strong_wins * 4 >= ended * 3);
+    return 0;
+}
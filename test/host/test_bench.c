@@ -0,0 +1,35 @@
+// Smoke test of the microbenchmarks: a short run times every case, and its
+// JSON output reads back as a baseline without regressions.
+#include <string.h>
+#include "bench.h"
+#include "host_test.h"
+
+int main() {
+    static BenchResult results[BENCH_MAX_RESULTS];
+    size_t count = bench_run(results, 20000);
+    TEST_ASSERT(count >= 12);
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT(results[i].name && results[i].size > 0 && results[i].calls > 0);
+        TEST_ASSERT(results[i].ns_per_call > 0);
+    }
+
+    FILE *json = tmpfile(), *report = tmpfile();
+    TEST_ASSERT(json && report);
+    bench_write_json(json, results, count);
+    rewind(json);
+    TEST_ASSERT_EQUAL(0, bench_compare(json, results, count, 0, report));
+
+    // Every case of the baseline is found again
+    static char text[8192];
+    rewind(report);
+    size_t len = fread(text, 1, sizeof(text) - 1, report);
+    text[len] = '\0';
+    size_t lines = 0;
+    for (char *p = text; (p = strchr(p, '\n')); p++) lines++;
+    TEST_ASSERT_EQUAL(count + 1, lines);
+    TEST_ASSERT(!strstr(text, " - \n"));
+    fputs(text, stdout);
+    fclose(report);
+    fclose(json);
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Blur and fade kernels of color: blur1d(), blur_rows(), blur_columns()
+// and blur2d() on row-major buffers (xy == NULL) match a scalar per-pixel
+// reference on random buffers, including 1-pixel and 1-line cases and
+// sizes around the kernels' chunk size, and write nothing outside the
+// buffer. rgb_fade_to_black_by() matches scale8() per channel.
+#include <string.h>
+#include "color.h"
+#include "host_test.h"
+
+#define MAX_PIXELS (40 * 40)
+#define GUARD 0xa5
+
+static const uint8_t amounts[] = { 0, 1, 2, 64, 127, 128, 200, 255 };
+
+// The per-pixel blur of 'count' pixels 'stride' apart, as blur1d() was
+// written before the byte-wise kernels
+static void ref_blur(rgb_t *leds, size_t count, size_t stride, fract8 amount) {
+    uint8_t keep = 255 - amount, seep = amount >> 1;
+    rgb_t carry = { 0 };
+    for (size_t i = 0; i < count; i++) {
+        rgb_t cur = leds[i * stride];
+        rgb_t part = rgb_scale(cur, seep);
+        cur = rgb_add_rgb(rgb_scale(cur, keep), carry);
+        if (i) leds[(i - 1) * stride] = rgb_add_rgb(leds[(i - 1) * stride], part);
+        leds[i * stride] = cur;
+        carry = part;
+    }
+}
+
+static uint32_t seed = 0x1234567;
+
+static void fill_random(rgb_t *leds, size_t num) {
+    uint8_t *p = (uint8_t *)leds;
+    for (size_t i = 0; i < num * sizeof(rgb_t); i++) {
+        seed = seed * 1664525 + 1013904223;
+        p[i] = seed >> 24;
+    }
+}
+
+// Random pixels followed by a guard pixel in both buffers
+static void prepare(rgb_t *actual, rgb_t *expected, size_t num) {
+    fill_random(actual, num);
+    memcpy(expected, actual, num * sizeof(rgb_t));
+    memset(&actual[num], GUARD, sizeof(rgb_t));
+}
+
+static void check(const rgb_t *actual, const rgb_t *expected, size_t num, const char *what, size_t w, size_t h,
+                  uint8_t amount) {
+    if (memcmp(actual, expected, num * sizeof(rgb_t))) {
+        fprintf(stderr, "%s %ux%u, amount %d: differs from the reference\n", what, (unsigned)w, (unsigned)h, amount);
+        exit(1);
+    }
+    const uint8_t *guard = (const uint8_t *)&actual[num];
+    TEST_ASSERT(guard[0] == GUARD && guard[1] == GUARD && guard[2] == GUARD);
+}
+
+static size_t row_major(void *ctx, size_t x, size_t y) {
+    return y * *(size_t *)ctx + x;
+}
+
+int main() {
+    static rgb_t actual[MAX_PIXELS + 1], expected[MAX_PIXELS + 1];
+    static const size_t lengths[] = { 0, 1, 2, 31, 32, 33, 64, 65, 97, 300 };
+    static const size_t shapes[][2] = { { 1, 1 }, { 1, 17 }, { 17, 1 }, { 2, 2 }, { 33, 5 }, { 5, 40 }, { 40, 40 } };
+    int cases = 0;
+
+    for (size_t a = 0; a < sizeof(amounts); a++) {
+        uint8_t amount = amounts[a];
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            size_t n = lengths[l];
+            prepare(actual, expected, n);
+            blur1d(actual, n, amount);
+            ref_blur(expected, n, 1, amount);
+            check(actual, expected, n, "blur1d", n, 1, amount);
+            cases++;
+        }
+
+        for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+            size_t w = shapes[s][0], h = shapes[s][1], n = w * h;
+
+            prepare(actual, expected, n);
+            blur_rows(actual, w, h, amount, NULL, NULL);
+            for (size_t y = 0; y < h; y++) ref_blur(&expected[y * w], w, 1, amount);
+            check(actual, expected, n, "blur_rows", w, h, amount);
+
+            prepare(actual, expected, n);
+            blur_columns(actual, w, h, amount, NULL, NULL);
+            for (size_t x = 0; x < w; x++) ref_blur(&expected[x], h, w, amount);
+            check(actual, expected, n, "blur_columns", w, h, amount);
+
+            // The row-major shortcut equals the callback path
+            prepare(actual, expected, n);
+            blur2d(actual, w, h, amount, NULL, NULL);
+            blur2d(expected, w, h, amount, row_major, &w);
+            check(actual, expected, n, "blur2d", w, h, amount);
+            cases += 3;
+        }
+
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            size_t n = lengths[l];
+            prepare(actual, expected, n);
+            rgb_fade_to_black_by(actual, n, amount);
+            for (size_t i = 0; i < n; i++) {
+                expected[i] = (rgb_t){ .r = scale8(expected[i].r, 255 - amount),
+                                       .g = scale8(expected[i].g, 255 - amount),
+                                       .b = scale8(expected[i].b, 255 - amount) };
+            }
+            check(actual, expected, n, "rgb_fade_to_black_by", n, 1, amount);
+            cases++;
+        }
+    }
+    printf("%d blur and fade cases match the reference\n", cases);
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Expanded palettes of color: rgb_palette256_from_rgb() and
+// rgb_palette256_from_hsv() hold, for every index, what
+// color_from_palette_rgb() and color_from_palette_hsv() return for it,
+// with and without interpolation, and rgb_fill_palette256() applies
+// brightness as color_from_palette_rgb() does.
+#include <string.h>
+#include "color.h"
+#include "host_test.h"
+
+#define MAX_PAL 128
+
+static const uint8_t brightnesses[] = { 255, 254, 128, 1, 0 };
+
+static bool same(rgb_t a, rgb_t b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+int main() {
+    static rgb_t rgb_pal[MAX_PAL];
+    static hsv_t hsv_pal[MAX_PAL];
+    static rgb_palette256_t expanded;
+    uint32_t x = 0x51ed270b;
+    for (int i = 0; i < MAX_PAL; i++) {
+        x = x * 1664525 + 1013904223;
+        rgb_pal[i] = (rgb_t){ .r = x >> 24, .g = x >> 16, .b = x >> 8 };
+        // Black and white entries exercise the hue special case
+        uint8_t sat = i % 5 == 1 ? 0 : x >> 4, val = i % 7 == 3 ? 0 : x;
+        hsv_pal[i] = hsv_from_values(x >> 12, sat, val);
+    }
+
+    int checked = 0;
+    for (int size = 2; size <= MAX_PAL; size *= 2) {
+        for (int interpolate = 0; interpolate <= 1; interpolate++) {
+            rgb_palette256_from_rgb(&expanded, rgb_pal, size, interpolate);
+            for (int i = 0; i < 256; i++) {
+                rgb_t expected = color_from_palette_rgb(rgb_pal, size, i, 255, interpolate);
+                if (!same(expanded.entries[i], expected)) {
+                    fprintf(stderr, "RGB palette of %d, interpolate %d, index %d differs\n", size, interpolate, i);
+                    return 1;
+                }
+            }
+
+            // Brightness as color_from_palette_rgb(), one palette step per LED
+            static rgb_t strip[256];
+            for (size_t b = 0; b < sizeof(brightnesses); b++) {
+                rgb_fill_palette256(strip, 256, &expanded, 0, 256, brightnesses[b]);
+                for (int i = 0; i < 256; i++) {
+                    rgb_t expected = color_from_palette_rgb(rgb_pal, size, i, brightnesses[b], interpolate);
+                    if (!same(strip[i], expected)) {
+                        fprintf(stderr, "RGB palette of %d, interpolate %d, brightness %d, index %d differs\n", size,
+                                interpolate, brightnesses[b], i);
+                        return 1;
+                    }
+                }
+            }
+
+            rgb_palette256_from_hsv(&expanded, hsv_pal, size, interpolate);
+            for (int i = 0; i < 256; i++) {
+                rgb_t expected = hsv2rgb_rainbow(color_from_palette_hsv(hsv_pal, size, i, 255, interpolate));
+                if (!same(expanded.entries[i], expected)) {
+                    fprintf(stderr, "HSV palette of %d, interpolate %d, index %d differs\n", size, interpolate, i);
+                    return 1;
+                }
+            }
+            checked += 2;
+        }
+    }
+    printf("%d expanded palettes match the per-index lookups\n", checked);
+    return 0;
+}
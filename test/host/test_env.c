@@ -0,0 +1,53 @@
+// Smoke test of the training environment: every environment is fed the
+// same actions, so all of them must play the same games.
+#include <string.h>
+#include "env.h"
+#include "esp_log.h"
+#include "host_test.h"
+
+#define NUM_ENVS 8
+#define NUM_LEDS 54
+#define STEPS 20000
+
+// Player 1 hits whenever the ball reaches its paddle, player 2 only in some
+// stretches of steps, so points are scored and games end
+static uint8_t policy(const EnvObs *obs, int step) {
+    int led = (int)(obs->ball_position + 0.5f);
+    if (obs->state == GAME_STATE_WAIT_SERVE) return obs->serving ? ENV_PRESS_P2 : ENV_PRESS_P1;
+    if (obs->ball_direction < 0 && led <= 5) return ENV_PRESS_P1;
+    if (obs->ball_direction > 0 && led >= NUM_LEDS - 6 && (step / 2000) % 2) return ENV_PRESS_P2;
+    return 0;
+}
+
+int main() {
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+    Env env;
+    static EnvObs obs[NUM_ENVS];
+    static uint8_t actions[NUM_ENVS];
+    static rgb_t frames[NUM_ENVS * NUM_LEDS];
+    TEST_ASSERT_EQUAL(ESP_OK, env_init(&env, NUM_ENVS, NUM_LEDS, 0));
+    env_reset(&env, 0, NUM_ENVS, obs);
+    TEST_ASSERT_EQUAL(GAME_STATE_WAIT_SERVE, obs[0].state);
+
+    int games = 0, points = 0;
+    for (int step = 0; step < STEPS; step++) {
+        for (int i = 0; i < NUM_ENVS; i++) actions[i] = policy(&obs[0], step);
+        env_step(&env, 0, NUM_ENVS, actions, obs, step % 10 ? NULL : frames);
+        for (int i = 1; i < NUM_ENVS; i++) {
+            TEST_ASSERT(obs[i].state == obs[0].state && obs[i].ball_position == obs[0].ball_position);
+            TEST_ASSERT(!memcmp(obs[i].lives, obs[0].lives, sizeof(obs[0].lives)) && obs[i].done == obs[0].done);
+            if (step % 10 == 0) {
+                TEST_ASSERT(!memcmp(&frames[i * NUM_LEDS], frames, NUM_LEDS * sizeof(rgb_t)));
+            }
+        }
+        TEST_ASSERT(obs[0].lives[0] <= 5 && obs[0].lives[1] <= 5);
+        TEST_ASSERT_EQUAL(-obs[0].reward[0], obs[0].reward[1]);
+        points += obs[0].reward[0] != 0;
+        games += obs[0].done;
+    }
+    TEST_ASSERT(points > 0);
+    TEST_ASSERT(games > 0);
+    printf("%d steps: %d points, %d games\n", STEPS, points, games);
+    env_free(&env);
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Frame clock pacing: frames armed at absolute deadlines are woken by
+// frame_clock_wait() no earlier than their deadline, and work done in a
+// frame does not push the later deadlines back. A deadline that has already
+// passed counts as an overrun and fires at once; frame_clock_tick() records
+// lateness only for the deadline still armed, once.
+#include "frame_clock.h"
+#include "host_test.h"
+
+#define PERIOD_US 5000
+#define FRAMES 40
+#define WORK_US 3000        // Per frame, below the period
+#define SLACK_US 60000      // Scheduling noise allowed over the whole run
+
+static int calls;
+
+static void on_deadline(void *arg) {
+    (*(int *)arg)++;
+}
+
+static void busy_wait(int64_t us) {
+    for (int64_t end = frame_clock_now_us() + us; frame_clock_now_us() < end;) {}
+}
+
+int main() {
+    frame_clock_t fc;
+    TEST_ASSERT_EQUAL(ESP_OK, frame_clock_init(&fc, on_deadline, &calls));
+    TEST_ASSERT(!frame_clock_wait(&fc)); // Nothing armed
+
+    // Deadlines a period apart from a fixed start, with work in every frame.
+    // Relative sleeps would drift by FRAMES * WORK_US = 120 ms.
+    int64_t start = frame_clock_now_us() + PERIOD_US;
+    for (int k = 0; k < FRAMES; k++) {
+        int64_t deadline = start + k * PERIOD_US;
+        TEST_ASSERT_EQUAL(ESP_OK, frame_clock_arm(&fc, deadline));
+        TEST_ASSERT(frame_clock_wait(&fc));
+        int64_t now = frame_clock_now_us();
+        TEST_ASSERT(now >= deadline);
+        TEST_ASSERT_EQUAL(k + 1, calls);
+        TEST_ASSERT(frame_clock_tick(&fc, now));
+        busy_wait(WORK_US);
+    }
+    int64_t elapsed = frame_clock_now_us() - start;
+    TEST_ASSERT(elapsed >= (FRAMES - 1) * PERIOD_US + WORK_US);
+    TEST_ASSERT(elapsed < (FRAMES - 1) * PERIOD_US + WORK_US + SLACK_US);
+    TEST_ASSERT_EQUAL(FRAMES, fc.stats.frames);
+    TEST_ASSERT(fc.stats.late_total_us >= 0 && fc.stats.late_max_us >= 0);
+    TEST_ASSERT(fc.stats.late_max_us * FRAMES >= fc.stats.late_total_us);
+    printf("%d frames of %d us in %lld us: %u overruns, lateness mean %lld us, max %lld us\n", FRAMES, PERIOD_US,
+           (long long)elapsed, (unsigned)fc.stats.overruns, (long long)(fc.stats.late_total_us / FRAMES),
+           (long long)fc.stats.late_max_us);
+
+    // A deadline in the past is an overrun and does not sleep
+    frame_clock_reset_stats(&fc);
+    TEST_ASSERT_EQUAL(0, fc.stats.frames);
+    int64_t past = frame_clock_now_us() - 3000;
+    TEST_ASSERT_EQUAL(ESP_OK, frame_clock_arm(&fc, past));
+    TEST_ASSERT_EQUAL(1, fc.stats.overruns);
+    int64_t before = frame_clock_now_us();
+    TEST_ASSERT(frame_clock_wait(&fc));
+    TEST_ASSERT(frame_clock_now_us() - before < PERIOD_US);
+    TEST_ASSERT(frame_clock_tick(&fc, frame_clock_now_us()));
+    TEST_ASSERT(fc.stats.late_max_us >= 3000);
+
+    // Lateness is recorded against the armed deadline, once
+    frame_clock_reset_stats(&fc);
+    int64_t deadline = frame_clock_now_us() + 1000000000;
+    TEST_ASSERT_EQUAL(ESP_OK, frame_clock_arm(&fc, deadline));
+    TEST_ASSERT_EQUAL(0, fc.stats.overruns);
+    TEST_ASSERT(!frame_clock_tick(&fc, deadline - 1)); // Too early
+    TEST_ASSERT(frame_clock_tick(&fc, deadline + 250));
+    TEST_ASSERT(!frame_clock_tick(&fc, deadline + 300)); // Already reported
+    TEST_ASSERT_EQUAL(ESP_OK, frame_clock_arm(&fc, deadline + PERIOD_US));
+    TEST_ASSERT(frame_clock_tick(&fc, deadline + PERIOD_US + 1000));
+    TEST_ASSERT_EQUAL(2, fc.stats.frames);
+    TEST_ASSERT_EQUAL(1250, fc.stats.late_total_us);
+    TEST_ASSERT_EQUAL(1000, fc.stats.late_max_us);
+
+    // Replaced and cancelled deadlines are not reported
+    TEST_ASSERT_EQUAL(ESP_OK, frame_clock_arm(&fc, deadline));
+    TEST_ASSERT_EQUAL(ESP_OK, frame_clock_arm(&fc, deadline + PERIOD_US));
+    TEST_ASSERT(!frame_clock_tick(&fc, deadline));
+    TEST_ASSERT_EQUAL(ESP_OK, frame_clock_disarm(&fc));
+    TEST_ASSERT(!frame_clock_tick(&fc, deadline + PERIOD_US));
+    TEST_ASSERT(!frame_clock_wait(&fc));
+    TEST_ASSERT_EQUAL(2, fc.stats.frames);
+    TEST_ASSERT_EQUAL(0, fc.stats.overruns);
+
+    TEST_ASSERT_EQUAL(ESP_OK, frame_clock_free(&fc));
+    return 0;
+}
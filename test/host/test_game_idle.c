@@ -0,0 +1,79 @@
+// Idle transitions of the court engine: a court waiting for a serve stops
+// its timers after SERVE_IDLE_AFTER_MS, a court waiting for a restart has
+// none, so court_next_timer() and courts_advance() report -1 and the
+// controller may sleep; a press arms the timers again.
+#include "game.h"
+#include "esp_log.h"
+#include "host_test.h"
+
+#define NUM_LEDS 54
+#define TIMEOUT_MS 600000
+
+static Court court;
+static uint32_t now;
+
+// Advances the court millisecond by millisecond until it reaches 'state'
+static void run_until(GameState state, bool serve) {
+    for (uint32_t end = now + TIMEOUT_MS; court.state != state; now++) {
+        TEST_ASSERT(now < end);
+        if (serve && court.state == GAME_STATE_WAIT_SERVE) {
+            court_dispatch(&court, court.servingPlayer == &court.player1 ? EVENT_P1_PRESS : EVENT_P2_PRESS, now);
+        }
+        courts_advance(&court, 1, now);
+    }
+}
+
+// Advances the court by 'ms' without input
+static void run_for(uint32_t ms) {
+    for (uint32_t end = now + ms; now < end; now++) courts_advance(&court, 1, now);
+}
+
+int main() {
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+    TEST_ASSERT_EQUAL(ESP_OK, court_init(&court, 0, NUM_LEDS));
+    court_start(&court, now);
+    TEST_ASSERT(court_next_timer(&court, now) >= 0); // Start animation
+
+    // Waiting for a serve: blinks, then goes idle
+    run_until(GAME_STATE_WAIT_SERVE, false);
+    uint32_t wait_start = now;
+    TEST_ASSERT(court_next_timer(&court, now) >= 0);
+    while (court_next_timer(&court, now) >= 0) {
+        TEST_ASSERT(now - wait_start < 2 * SERVE_IDLE_AFTER_MS);
+        run_for(1);
+    }
+    // The blink in progress at the deadline ends it
+    TEST_ASSERT(now - wait_start >= SERVE_IDLE_AFTER_MS && now - wait_start <= SERVE_IDLE_AFTER_MS + 1000);
+    TEST_ASSERT_EQUAL(GAME_STATE_WAIT_SERVE, court.state);
+    TEST_ASSERT_EQUAL(-1, courts_advance(&court, 1, now));
+    TEST_ASSERT(court.serveBlinkOn); // The marker stays lit
+    printf("WAIT_SERVE idle after %u ms\n", (unsigned)(now - wait_start));
+
+    // Idle lasts, and the serve arms the ball timer
+    run_for(TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(-1, court_next_timer(&court, now));
+    court_dispatch(&court, court.servingPlayer == &court.player1 ? EVENT_P1_PRESS : EVENT_P2_PRESS, now);
+    TEST_ASSERT_EQUAL(GAME_STATE_PLAYING, court.state);
+    TEST_ASSERT(court_next_timer(&court, now) >= 0);
+    TEST_ASSERT(courts_advance(&court, 1, now) >= 0);
+
+    // Nobody returns a ball: the game ends and waits for a restart with no
+    // timer armed
+    run_until(GAME_STATE_WAIT_RESTART, true);
+    TEST_ASSERT_EQUAL(-1, court_next_timer(&court, now));
+    TEST_ASSERT_EQUAL(-1, courts_advance(&court, 1, now));
+    run_for(TIMEOUT_MS);
+    TEST_ASSERT_EQUAL(GAME_STATE_WAIT_RESTART, court.state);
+    TEST_ASSERT_EQUAL(-1, court_next_timer(&court, now));
+
+    // A press starts a new game with its start animation
+    court_dispatch(&court, EVENT_P2_PRESS, now);
+    TEST_ASSERT_EQUAL(GAME_STATE_INIT, court.state);
+    TEST_ASSERT(court_next_timer(&court, now) >= 0);
+    run_until(GAME_STATE_WAIT_SERVE, false);
+    TEST_ASSERT(court_next_timer(&court, now) >= 0);
+    printf("WAIT_RESTART idle, restarted at %u ms\n", (unsigned)now);
+
+    court_free(&court);
+    return 0;
+}
@@ -0,0 +1,60 @@
+// Smoke test of golden frames: a scenario matches the golden file it just
+// recorded, and a changed scenario is caught and reported with the
+// expected and actual pixels.
+#include <string.h>
+#include "golden.h"
+#include "game.h"
+#include "esp_log.h"
+#include "host_test.h"
+
+#define NUM_LEDS 54
+
+int main() {
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+    FILE *inputs = tmpfile(), *golden = tmpfile(), *report = tmpfile();
+    TEST_ASSERT(inputs && golden && report);
+    write_input_log(inputs, 3000, 120000);
+
+    GoldenResult recorded, checked;
+    rewind(inputs);
+    TEST_ASSERT_EQUAL(ESP_OK, golden_record(inputs, NUM_LEDS, golden, &recorded));
+    TEST_ASSERT(recorded.flushed > 0 && recorded.flushed < recorded.frames);
+
+    rewind(inputs);
+    rewind(golden);
+    TEST_ASSERT_EQUAL(ESP_OK, golden_check(inputs, NUM_LEDS, golden, report, &checked));
+    TEST_ASSERT(checked.match);
+    TEST_ASSERT_EQUAL(recorded.frames, checked.frames);
+    TEST_ASSERT_EQUAL(recorded.flushed, checked.flushed);
+    TEST_ASSERT(recorded.hash == checked.hash);
+
+    // Leave out a few presses in the middle of the match
+    FILE *changed = tmpfile();
+    TEST_ASSERT(changed);
+    rewind(inputs);
+    char line[80];
+    for (int n = 0; fgets(line, sizeof(line), inputs); n++) {
+        if (n < 11 || n > 14) fputs(line, changed);
+    }
+    rewind(changed);
+    rewind(golden);
+    TEST_ASSERT_EQUAL(ESP_OK, golden_check(changed, NUM_LEDS, golden, report, &checked));
+    TEST_ASSERT(!checked.match);
+    TEST_ASSERT(checked.first_mismatch > 0 && checked.first_mismatch < recorded.frames);
+
+    static char text[4096];
+    rewind(report);
+    size_t len = fread(text, 1, sizeof(text) - 1, report);
+    text[len] = '\0';
+    TEST_ASSERT(strstr(text, "First divergent frame"));
+    TEST_ASSERT(strstr(text, "Expected: ") && strstr(text, "Actual:   "));
+    TEST_ASSERT(strstr(text, ": expected ") && strstr(text, ", got "));
+    printf("%u frames, %u flushed; changed scenario diverges at frame %u\n%s", (unsigned)recorded.frames,
+           (unsigned)recorded.flushed, (unsigned)checked.first_mismatch, text);
+
+    fclose(changed);
+    fclose(report);
+    fclose(golden);
+    fclose(inputs);
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Waveform check of led_strip: led_strip_check_waveform() accepts what the
+// RMT translator and the SPI encoder generate for every LED type, byte value
+// and brightness, reports the wire time of the bytes, and rejects LED types
+// whose bits cannot be placed in their datasheet windows. The driver is
+// built into this test with CONFIG_LED_STRIP_CHECK_WAVEFORM, so
+// led_strip_init() runs the check as well and fails cleanly with it.
+//
+// Built twice: test_led_strip_check_skewed defines SKEWED_WS2812 and builds
+// the driver with a WS2812 T1H of 1100 ns, outside the 650..950 ns window,
+// which the check must catch on the RMT items of both WS2812 types.
+#include <string.h>
+#include "led_strip.h"
+#include "host_test.h"
+
+#define NUM_LEDS 8
+
+typedef struct {
+    const char *name;
+    led_strip_type_t type;
+    bool is_rgbw;
+} LedType;
+
+static const LedType types[] = {
+    { "WS2812", LED_STRIP_WS2812, false },
+    { "WS2812 inv", LED_STRIP_WS2812_INV, false },
+    { "SK6812", LED_STRIP_SK6812, false },
+    { "SK6812 RGBW", LED_STRIP_SK6812, true },
+    { "APA106", LED_STRIP_APA106, false },
+};
+
+typedef struct {
+    const char *name;
+    led_strip_backend_t backend;
+    uint8_t spi_bits;
+} Backend;
+
+static const Backend backends[] = {
+    { "RMT", LED_STRIP_BACKEND_RMT, 0 },
+    { "SPI/4", LED_STRIP_BACKEND_SPI, 4 },
+    { "SPI/3", LED_STRIP_BACKEND_SPI, 3 },
+};
+
+static const uint8_t brightnesses[] = { 255, 100, 1 };
+
+// scale8_video() written out
+static uint8_t ref_scale(uint8_t v, uint8_t brightness) {
+    return v * brightness / 256 + (v && brightness);
+}
+
+// Whether the driver has to refuse the combination: SPI cannot invert the
+// output, and 3 SPI bits only fit the WS2812 windows
+static esp_err_t expected_result(const LedType *type, const Backend *backend, const uint8_t *data, size_t len) {
+    if (backend->backend == LED_STRIP_BACKEND_SPI) {
+        if (type->type == LED_STRIP_WS2812_INV) return ESP_ERR_NOT_SUPPORTED;
+        if (backend->spi_bits == 3 && type->type != LED_STRIP_WS2812) return ESP_ERR_NOT_SUPPORTED;
+    }
+#ifdef SKEWED_WS2812
+    // The RMT items carry the skewed T1H; the SPI encoder rounds T1H to at
+    // most bits - 1 units, which is back inside the window
+    bool ws2812 = type->type == LED_STRIP_WS2812 || type->type == LED_STRIP_WS2812_INV;
+    if (ws2812 && backend->backend == LED_STRIP_BACKEND_RMT) {
+        for (size_t i = 0; i < len; i++) {
+            if (data[i]) return ESP_FAIL; // Only 1 bits are out of window
+        }
+    }
+#endif
+    return ESP_OK;
+}
+
+int main() {
+    led_strip_install();
+    static uint8_t all[256], zeros[16];
+    for (int i = 0; i < 256; i++) all[i] = i;
+    int accepted = 0, rejected = 0;
+
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+            const LedType *type = &types[t];
+            const Backend *backend = &backends[b];
+            led_strip_t strip = {
+                .type = type->type,
+                .is_rgbw = type->is_rgbw,
+                .length = NUM_LEDS,
+                .gpio = 18,
+                .backend = backend->backend,
+                .channel = 0,
+                .spi_host = SPI2_HOST,
+                .spi_bits = backend->spi_bits,
+                .brightness = 255,
+            };
+
+            // led_strip_init() runs the check on its own pattern
+            esp_err_t init_expected = expected_result(type, backend, all, sizeof(all));
+            esp_err_t r = led_strip_init(&strip);
+            if (r != init_expected) {
+                fprintf(stderr, "%s on %s: led_strip_init() returned %d, expected %d\n", type->name, backend->name,
+                        r, init_expected);
+                return 1;
+            }
+            if (r != ESP_OK) {
+                // Nothing is left allocated, the peripheral can be used again
+                TEST_ASSERT(strip.buf == NULL);
+                TEST_ASSERT_EQUAL(init_expected, led_strip_check_waveform(&strip, all, sizeof(all), NULL));
+                TEST_ASSERT_EQUAL(expected_result(type, backend, zeros, sizeof(zeros)),
+                                  led_strip_check_waveform(&strip, zeros, sizeof(zeros), NULL));
+                printf("%-12s %-6s rejected (%d)\n", type->name, backend->name, init_expected);
+                rejected++;
+                continue;
+            }
+
+            // Every byte value at every brightness, wire time from the bit
+            // timings the driver reports
+            led_strip_timing_t timing;
+            TEST_ASSERT_EQUAL(ESP_OK, led_strip_get_timing(&strip, &timing));
+            for (size_t n = 0; n < sizeof(brightnesses); n++) {
+                strip.brightness = brightnesses[n];
+                uint64_t wire_ns = 0, expected_ns = 0;
+                TEST_ASSERT_EQUAL(ESP_OK, led_strip_check_waveform(&strip, all, sizeof(all), &wire_ns));
+                for (int i = 0; i < 256; i++) {
+                    uint8_t v = strip.brightness == 255 ? all[i] : ref_scale(all[i], strip.brightness);
+                    int ones = __builtin_popcount(v);
+                    expected_ns += ones * (uint64_t)(timing.t1h_ns + timing.t1l_ns)
+                                   + (8 - ones) * (uint64_t)(timing.t0h_ns + timing.t0l_ns);
+                }
+                TEST_ASSERT_EQUAL(expected_ns, wire_ns);
+            }
+            strip.brightness = 255;
+            TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_check_waveform(&strip, all, 0, NULL));
+            TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_check_waveform(&strip, NULL, 1, NULL));
+            printf("%-12s %-6s T0H %u ns, T1H %u ns\n", type->name, backend->name, (unsigned)timing.t0h_ns,
+                   (unsigned)timing.t1h_ns);
+            TEST_ASSERT_EQUAL(ESP_OK, led_strip_free(&strip));
+            accepted++;
+        }
+    }
+#ifdef SKEWED_WS2812
+    TEST_ASSERT_EQUAL(7, rejected);
+#else
+    TEST_ASSERT_EQUAL(5, rejected);
+#endif
+    printf("%d waveforms accepted, %d rejected\n", accepted, rejected);
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Segments of led_strip: led_strip_segment_set_pixel(), _fill(),
+// _fill_color() and _blit() on straight, reversed and serpentine segments
+// write exactly the strip LEDs a per-pixel index mapping gives, for every
+// pixel and range, and leave the rest of the strip alone, in wire order and
+// `rgb_buf` buffers; out-of-range arguments are rejected without touching
+// the buffer.
+#include <string.h>
+#include "led_strip.h"
+#include "host_test.h"
+
+#define STRIP_LEDS 40
+#define BACKGROUND 0x5a
+#define BUF_SIZE(strip) (STRIP_LEDS * (3 + (strip)->is_rgbw))
+
+typedef struct {
+    size_t offset, length;
+    bool reversed;
+    size_t serpentine_width;
+} Layout;
+
+static const Layout layouts[] = {
+    { 0, 1, false, 0 },  { 0, 1, true, 0 },   { 39, 1, true, 1 },  { 0, 40, false, 0 }, { 0, 40, true, 0 },
+    { 5, 12, false, 0 }, { 5, 12, true, 0 },  { 5, 12, false, 1 }, { 5, 12, false, 4 }, { 5, 12, true, 4 },
+    { 3, 24, false, 6 }, { 3, 24, true, 6 },  { 3, 24, false, 12 }, { 3, 24, true, 12 }, { 16, 24, true, 3 },
+    { 0, 40, false, 8 }, { 0, 40, true, 5 },  { 7, 9, true, 9 },
+};
+
+// Strip LED of segment pixel 'num', one pixel at a time
+static size_t ref_index(const Layout *l, size_t num) {
+    size_t k = l->reversed ? l->length - 1 - num : num;
+    size_t w = l->serpentine_width;
+    if (w && (k / w) & 1) k = k / w * w + (w - 1 - k % w);
+    return l->offset + k;
+}
+
+static rgb_t color_of(size_t i, uint8_t salt) {
+    return (rgb_t){ .r = i * 7 + salt, .g = i ^ salt, .b = 255 - i };
+}
+
+static void clear(led_strip_t *actual, led_strip_t *expected) {
+    memset(actual->buf, BACKGROUND, BUF_SIZE(actual));
+    memset(expected->buf, BACKGROUND, BUF_SIZE(expected));
+}
+
+static void check(const led_strip_t *actual, const led_strip_t *expected, const Layout *l, const char *what,
+                  size_t start, size_t len) {
+    if (memcmp(actual->buf, expected->buf, BUF_SIZE(actual))) {
+        fprintf(stderr, "%s at %u+%u, %u LEDs from %u%s, serpentine %u: wrong LEDs\n", what, (unsigned)start,
+                (unsigned)len, (unsigned)l->length, (unsigned)l->offset, l->reversed ? " reversed" : "",
+                (unsigned)l->serpentine_width);
+        exit(1);
+    }
+}
+
+// Every call must fail and leave the buffer as it was
+static void check_rejected(led_strip_segment_t *seg, led_strip_t *actual, led_strip_t *expected, const Layout *l) {
+    static const size_t huge = (size_t)-1;
+    static const rgb_t data[STRIP_LEDS + 2];
+    led_strip_color_t c;
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_color(actual, color_of(1, 1), &c));
+    clear(actual, expected);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_segment_set_pixel(seg, l->length, color_of(1, 1)));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_segment_set_pixel(seg, huge, color_of(1, 1)));
+    const size_t ranges[][2] = {
+        { 0, 0 }, { l->length, 1 }, { 0, l->length + 1 }, { l->length - 1, 2 }, { 1, l->length },
+        { huge, 2 }, { 2, huge }, { huge, huge },
+    };
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        size_t start = ranges[r][0], len = ranges[r][1];
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_segment_fill(seg, start, len, color_of(1, 1)));
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_segment_fill_color(seg, start, len, c));
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_segment_blit(seg, start, len, data));
+        check(actual, expected, l, "rejected range", start, len);
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_segment_blit(seg, 0, 1, NULL));
+    check(actual, expected, l, "blit of NULL", 0, 1);
+}
+
+static int run(led_strip_t *actual, led_strip_t *expected) {
+    int cases = 0;
+    for (size_t n = 0; n < sizeof(layouts) / sizeof(layouts[0]); n++) {
+        const Layout *l = &layouts[n];
+        led_strip_segment_t seg;
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_segment_init(&seg, actual, l->offset, l->length, l->reversed,
+                                                         l->serpentine_width));
+
+        // One pixel at a time, each landing on its own LED
+        clear(actual, expected);
+        for (size_t i = 0; i < l->length; i++) {
+            TEST_ASSERT_EQUAL(ESP_OK, led_strip_segment_set_pixel(&seg, i, color_of(i, 3)));
+            TEST_ASSERT_EQUAL(ESP_OK, led_strip_set_pixel(expected, ref_index(l, i), color_of(i, 3)));
+            check(actual, expected, l, "set_pixel", i, 1);
+        }
+
+        // Every range
+        static rgb_t data[STRIP_LEDS];
+        for (size_t start = 0; start < l->length; start++) {
+            for (size_t len = 1; start + len <= l->length; len++) {
+                rgb_t color = color_of(start, len);
+                led_strip_color_t c;
+                TEST_ASSERT_EQUAL(ESP_OK, led_strip_color(actual, color, &c));
+
+                clear(actual, expected);
+                TEST_ASSERT_EQUAL(ESP_OK, led_strip_segment_fill(&seg, start, len, color));
+                for (size_t i = start; i < start + len; i++) led_strip_set_pixel(expected, ref_index(l, i), color);
+                check(actual, expected, l, "fill", start, len);
+
+                memset(actual->buf, BACKGROUND, BUF_SIZE(actual));
+                TEST_ASSERT_EQUAL(ESP_OK, led_strip_segment_fill_color(&seg, start, len, c));
+                check(actual, expected, l, "fill_color", start, len);
+
+                clear(actual, expected);
+                for (size_t i = 0; i < len; i++) data[i] = color_of(i, start);
+                TEST_ASSERT_EQUAL(ESP_OK, led_strip_segment_blit(&seg, start, len, data));
+                for (size_t i = 0; i < len; i++) led_strip_set_pixel(expected, ref_index(l, start + i), data[i]);
+                check(actual, expected, l, "blit", start, len);
+                cases += 3;
+            }
+        }
+
+        check_rejected(&seg, actual, expected, l);
+    }
+    return cases;
+}
+
+int main() {
+    led_strip_install();
+
+    // Layouts the strip cannot hold
+    led_strip_t strip = { .type = LED_STRIP_WS2812, .length = STRIP_LEDS, .gpio = 18, .channel = 0, .brightness = 255 };
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_init(&strip));
+    led_strip_segment_t seg;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_segment_init(&seg, &strip, 0, 0, false, 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_segment_init(&seg, &strip, 0, STRIP_LEDS + 1, false, 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_segment_init(&seg, &strip, 1, STRIP_LEDS, false, 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_segment_init(&seg, &strip, (size_t)-1, 2, false, 0));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, led_strip_segment_init(&seg, &strip, 0, 12, false, 5));
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_free(&strip));
+
+    // RGB and RGBW strips, in wire order and RGB order, the reference
+    // written through led_strip_set_pixel()
+    int cases = 0;
+    for (int kind = 0; kind < 4; kind++) {
+        bool rgbw = kind & 1;
+        led_strip_t actual = {
+            .type = rgbw ? LED_STRIP_SK6812 : LED_STRIP_WS2812,
+            .is_rgbw = rgbw,
+            .rgb_buf = kind & 2,
+            .length = STRIP_LEDS,
+            .gpio = 18,
+            .channel = 0,
+            .brightness = 255,
+        };
+        led_strip_t expected = actual;
+        expected.channel = 1;
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_init(&actual));
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_init(&expected));
+        cases += run(&actual, &expected);
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_free(&actual));
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_free(&expected));
+    }
+    printf("%d segment writes on %d layouts land on the mapped LEDs\n", cases,
+           4 * (int)(sizeof(layouts) / sizeof(layouts[0])));
+    return 0;
+}
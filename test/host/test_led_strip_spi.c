@@ -0,0 +1,127 @@
+// SPI encoder of led_strip: led_strip_spi_code_init() picks a clock and
+// high times that fit each LED type, and led_strip_spi_encode() matches a
+// bit-by-bit reference encoder for 3 and 4 SPI bits, with and without a
+// channel map and brightness.
+#include <string.h>
+#include "led_strip_spi.h"
+#include "host_test.h"
+
+#define NUM_LEDS 10
+
+typedef struct {
+    const char *name;
+    uint32_t bit_ns;
+    uint32_t t1h_ns;
+} LedType;
+
+static const LedType types[] = {
+    { "WS2812", 300 + 900, 900 },
+    { "SK6812", 300 + 900, 600 },
+    { "APA106", 350 + 1360, 1360 },
+};
+
+// Wire channel -> source byte within an LED, as led_strip_t::buf_map
+typedef struct {
+    const uint8_t *map;
+    size_t size;
+} Layout;
+
+static const uint8_t map_grb[] = { 1, 0, 2 };
+static const uint8_t map_brg[] = { 2, 0, 1 };
+static const uint8_t map_grbw[] = { 1, 0, 2, 3 };
+
+static const Layout layouts[] = {
+    { NULL, 3 },
+    { NULL, 4 },
+    { map_grb, 3 },
+    { map_brg, 3 },
+    { map_grbw, 4 },
+};
+
+static const uint8_t brightnesses[] = { 255, 128, 1, 0 };
+
+// scale8_video() written out
+static uint8_t ref_scale(uint8_t v, uint8_t brightness) {
+    return v * brightness / 256 + (v && brightness);
+}
+
+// One LED bit at a time: 'hi' SPI bits high, the rest low, MSB first
+static void ref_encode(uint8_t bits, uint8_t t1h_units, const uint8_t *src, size_t len, uint8_t *dst,
+                       uint8_t brightness, const uint8_t *map, size_t size) {
+    memset(dst, 0, len * bits);
+    size_t out = 0;
+    size_t n = map ? len / size * size : len;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t v = map ? src[i / size * size + map[i % size]] : src[i];
+        if (brightness != 255) v = ref_scale(v, brightness);
+        for (int bit = 7; bit >= 0; bit--) {
+            int hi = v & (1 << bit) ? t1h_units : 1;
+            for (int u = 0; u < bits; u++, out++) {
+                if (u < hi) dst[out / 8] |= 0x80 >> (out % 8);
+            }
+        }
+    }
+}
+
+static void check_code(const led_strip_spi_code_t *code, uint8_t bits, const LedType *type) {
+    TEST_ASSERT_EQUAL(bits, code->bits);
+    TEST_ASSERT_EQUAL(1, code->t0h_units);
+    TEST_ASSERT(code->clock_hz > 0);
+    TEST_ASSERT_EQUAL(1000000000UL / code->clock_hz, code->unit_ns);
+    // The clock divides APB, so the LED bit is at most a few percent long
+    uint32_t bit_ns = code->unit_ns * bits;
+    TEST_ASSERT(bit_ns + bits >= type->bit_ns && bit_ns <= type->bit_ns * 21 / 20);
+    // Nearest high time that leaves a low SPI bit and stays apart from a 0
+    TEST_ASSERT(code->t1h_units >= 2 && code->t1h_units <= bits - 1);
+    long err = labs((long)code->t1h_units * code->unit_ns - (long)type->t1h_ns);
+    for (uint8_t u = 2; u <= bits - 1; u++) TEST_ASSERT(err <= labs((long)u * code->unit_ns - (long)type->t1h_ns));
+}
+
+int main() {
+    // Known patterns for 0xa5: 1 bits 1110/110, 0 bits 1000/100
+    led_strip_spi_code_t code;
+    uint8_t a5 = 0xa5, out[4];
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_spi_code_init(&code, 4, types[0].bit_ns, types[0].t1h_ns));
+    led_strip_spi_encode(&code, &a5, 1, out, 255, NULL, 3);
+    TEST_ASSERT(!memcmp(out, "\xe8\xe8\x8e\x8e", 4));
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_spi_code_init(&code, 3, types[1].bit_ns, types[1].t1h_ns));
+    led_strip_spi_encode(&code, &a5, 1, out, 255, NULL, 3);
+    TEST_ASSERT(!memcmp(out, "\xd3\x49\xa6", 3));
+
+    TEST_ASSERT(led_strip_spi_code_init(&code, 5, types[0].bit_ns, types[0].t1h_ns) != ESP_OK);
+
+    static uint8_t src[NUM_LEDS * 4], expected[NUM_LEDS * 4 * 4], actual[NUM_LEDS * 4 * 4 + 1];
+    uint32_t x = 0x2545f491;
+    for (size_t i = 0; i < sizeof(src); i++) {
+        x = x * 1664525 + 1013904223;
+        src[i] = i < 4 ? (uint8_t[]){ 0, 1, 0x80, 0xff }[i] : x >> 24;
+    }
+
+    int cases = 0;
+    for (uint8_t bits = 3; bits <= 4; bits++) {
+        for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+            TEST_ASSERT_EQUAL(ESP_OK, led_strip_spi_code_init(&code, bits, types[t].bit_ns, types[t].t1h_ns));
+            check_code(&code, bits, &types[t]);
+            printf("%s, %d bits: %u Hz, %u ns per SPI bit, 1 = %u bits high\n", types[t].name, bits,
+                   (unsigned)code.clock_hz, (unsigned)code.unit_ns, (unsigned)code.t1h_units);
+            for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+                const Layout *layout = &layouts[l];
+                size_t len = NUM_LEDS * layout->size;
+                for (size_t b = 0; b < sizeof(brightnesses); b++) {
+                    ref_encode(bits, code.t1h_units, src, len, expected, brightnesses[b], layout->map, layout->size);
+                    memset(actual, 0x5a, sizeof(actual));
+                    led_strip_spi_encode(&code, src, len, actual, brightnesses[b], layout->map, layout->size);
+                    if (memcmp(expected, actual, len * bits)) {
+                        fprintf(stderr, "%s, %d bits, layout %d, brightness %d: encoding differs\n", types[t].name,
+                                bits, (int)l, brightnesses[b]);
+                        return 1;
+                    }
+                    TEST_ASSERT_EQUAL(0x5a, actual[len * bits]); // Nothing written past the end
+                    cases++;
+                }
+            }
+        }
+    }
+    printf("%d encodings match the reference\n", cases);
+    return 0;
+}
@@ -0,0 +1,117 @@
+// RMT waveform of led_strip: frames flushed through the RMT translator
+// (run by the stub driver) decode back to the strip bytes with brightness
+// applied, every bit is within one RMT tick of the datasheet timing of the
+// LED type, and the wire time matches led_strip_get_timing().
+#include <string.h>
+#include "led_strip.h"
+#include "host_test.h"
+
+#define NUM_LEDS 12
+#define TICK_NS 50                  // RMT tick: APB / 4
+
+typedef struct {
+    const char *name;
+    led_strip_type_t type;
+    bool is_rgbw;
+    uint32_t t0h_ns, t0l_ns, t1h_ns, t1l_ns; // Datasheet
+    uint8_t first, second, third; // Wire bytes of the colour 0x112233
+} LedType;
+
+static const LedType types[] = {
+    { "WS2812", LED_STRIP_WS2812, false, 300, 900, 900, 300, 0x22, 0x11, 0x33 },
+    { "SK6812", LED_STRIP_SK6812, false, 300, 900, 600, 600, 0x22, 0x11, 0x33 },
+    { "SK6812 RGBW", LED_STRIP_SK6812, true, 300, 900, 600, 600, 0x22, 0x11, 0x33 },
+    { "APA106", LED_STRIP_APA106, false, 350, 1360, 1360, 350, 0x11, 0x22, 0x33 },
+};
+
+static const uint8_t brightnesses[] = { 255, 100, 1 };
+
+// scale8_video() written out
+static uint8_t ref_scale(uint8_t v, uint8_t brightness) {
+    return v * brightness / 256 + (v && brightness);
+}
+
+static bool near(uint32_t actual_ns, uint32_t nominal_ns) {
+    return actual_ns + TICK_NS > nominal_ns && actual_ns < nominal_ns + TICK_NS;
+}
+
+// Decodes the last frame of 'strip' into 'bytes' and checks every bit
+// against 'type'; returns the wire time
+static uint64_t decode(const led_strip_t *strip, const LedType *type, const led_strip_timing_t *timing,
+                       uint8_t *bytes, size_t len) {
+    size_t num;
+    const rmt_item32_t *items = rmt_stub_items(strip->channel, &num);
+    TEST_ASSERT_EQUAL(len * 8, num);
+    uint32_t mid_ns = (type->t0h_ns + type->t1h_ns) / 2;
+    uint64_t wire_ns = 0, model_ns = 0;
+    memset(bytes, 0, len);
+    for (size_t i = 0; i < num; i++) {
+        const rmt_item32_t *item = &items[i];
+        TEST_ASSERT(item->level0 == 1 && item->level1 == 0);
+        uint32_t high_ns = item->duration0 * TICK_NS, low_ns = item->duration1 * TICK_NS;
+        bool one = high_ns > mid_ns;
+        if (one) {
+            bytes[i / 8] |= 0x80 >> (i % 8);
+            TEST_ASSERT(near(high_ns, type->t1h_ns) && near(low_ns, type->t1l_ns));
+            TEST_ASSERT(high_ns == timing->t1h_ns && low_ns == timing->t1l_ns);
+        } else {
+            TEST_ASSERT(near(high_ns, type->t0h_ns) && near(low_ns, type->t0l_ns));
+            TEST_ASSERT(high_ns == timing->t0h_ns && low_ns == timing->t0l_ns);
+        }
+        wire_ns += high_ns + low_ns;
+        model_ns += one ? timing->t1h_ns + timing->t1l_ns : timing->t0h_ns + timing->t0l_ns;
+    }
+    TEST_ASSERT(wire_ns == model_ns);
+    return wire_ns;
+}
+
+int main() {
+    led_strip_install();
+    static uint8_t expected[NUM_LEDS * 4], actual[NUM_LEDS * 4];
+
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        const LedType *type = &types[t];
+        led_strip_t strip = {
+            .type = type->type,
+            .is_rgbw = type->is_rgbw,
+            .length = NUM_LEDS,
+            .gpio = 18,
+            .channel = 0,
+            .brightness = 255,
+        };
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_init(&strip));
+        size_t len = NUM_LEDS * (type->is_rgbw ? 4 : 3);
+        led_strip_timing_t timing;
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_get_timing(&strip, &timing));
+
+        // Colours go out in the order of the LED type
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_set_pixel(&strip, 0, (rgb_t){ .r = 0x11, .g = 0x22, .b = 0x33 }));
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_flush(&strip));
+        decode(&strip, type, &timing, actual, len);
+        TEST_ASSERT(actual[0] == type->first && actual[1] == type->second && actual[2] == type->third);
+
+        // Every byte value in the buffer, in wire order
+        for (size_t i = 0; i < len; i++) strip.buf[i] = i < 4 ? (uint8_t[]){ 0, 0xff, 0x80, 0x01 }[i] : i * 37 + t;
+        for (size_t b = 0; b < sizeof(brightnesses); b++) {
+            strip.brightness = brightnesses[b];
+            for (size_t i = 0; i < len; i++) {
+                expected[i] = strip.brightness == 255 ? strip.buf[i] : ref_scale(strip.buf[i], strip.brightness);
+            }
+            TEST_ASSERT_EQUAL(ESP_OK, led_strip_flush(&strip));
+            uint64_t wire_ns = decode(&strip, type, &timing, actual, len);
+            if (memcmp(expected, actual, len)) {
+                fprintf(stderr, "%s, brightness %d: decoded bytes differ\n", type->name, strip.brightness);
+                return 1;
+            }
+            // frame_ns counts every bit at the longer bit period
+            TEST_ASSERT(wire_ns <= timing.frame_ns);
+            if (timing.t0h_ns + timing.t0l_ns == timing.t1h_ns + timing.t1l_ns) TEST_ASSERT(wire_ns == timing.frame_ns);
+        }
+        printf("%-12s 0 = %u/%u ns, 1 = %u/%u ns, %u LEDs in %u ns\n", type->name, (unsigned)timing.t0h_ns,
+               (unsigned)timing.t0l_ns, (unsigned)timing.t1h_ns, (unsigned)timing.t1l_ns, NUM_LEDS,
+               (unsigned)timing.frame_ns);
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_wait(&strip, 0));
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_free(&strip));
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Seeded random streams of lib8tion: a seed and stream number always give
+// the same sequence (pinned by known values), different streams and seeds
+// diverge, and fill_random8() consumes the stream as documented, matching
+// random8_r() and random32_r() calls on the same state.
+#include <string.h>
+#include "lib8tion.h"
+#include "host_test.h"
+
+#define LENGTH 1000
+#define STREAMS 64
+
+static void sequence(uint32_t seed, uint32_t stream, uint32_t *out) {
+    random_state_t state;
+    random_state_init(&state, seed, stream);
+    for (int i = 0; i < LENGTH; i++) out[i] = random32_r(&state);
+}
+
+int main() {
+    static uint32_t a[LENGTH], b[LENGTH];
+
+    // Same seed and stream, same sequence, also across builds
+    sequence(1, 0, a);
+    sequence(1, 0, b);
+    TEST_ASSERT(!memcmp(a, b, sizeof(a)));
+    static const uint32_t known[] = { 0x73d0b521, 0xf61b8d94, 0x20d8e2ad, 0xf84c48ef };
+    for (size_t i = 0; i < sizeof(known) / sizeof(known[0]); i++) TEST_ASSERT_EQUAL(known[i], a[i]);
+
+    // Other streams and seeds share no leading values with it, nor with
+    // each other
+    static uint32_t firsts[2 * STREAMS];
+    for (int s = 0; s < 2 * STREAMS; s++) {
+        sequence(s < STREAMS ? 1 : 2, s % STREAMS, b);
+        firsts[s] = b[0];
+        if (s == 0) continue;
+        int equal = 0;
+        for (int i = 0; i < LENGTH; i++) equal += a[i] == b[i];
+        TEST_ASSERT(equal <= 1);
+        for (int i = 0; i < LENGTH; i++) TEST_ASSERT(b[0] != a[i]);
+    }
+    for (int s = 0; s < 2 * STREAMS; s++) {
+        for (int t = 0; t < s; t++) TEST_ASSERT(firsts[s] != firsts[t]);
+    }
+
+    // fill_random8(): byte 4k is the k-th random8_r(), the rest are the
+    // lower bytes of the same step, and the state ends up where
+    // (num + 3) / 4 steps leave it
+    static uint8_t buf[LENGTH + 1];
+    for (size_t num = 0; num <= LENGTH; num = num < 12 ? num + 1 : num * 3) {
+        random_state_t bulk, single, wide;
+        random_state_init(&bulk, 42, 7);
+        single = wide = bulk;
+        buf[num] = 0x5a;
+        fill_random8(&bulk, buf, num);
+        TEST_ASSERT_EQUAL(0x5a, buf[num]);
+        for (size_t i = 0; i < num; i += 4) {
+            TEST_ASSERT_EQUAL(random8_r(&single), buf[i]);
+            uint32_t r = random32_r(&wide);
+            for (size_t j = i; j < num && j < i + 4; j++, r <<= 8) TEST_ASSERT_EQUAL(r >> 24, buf[j]);
+        }
+        TEST_ASSERT(!memcmp(&bulk, &single, sizeof(bulk)));
+        TEST_ASSERT(!memcmp(&bulk, &wide, sizeof(bulk)));
+    }
+
+    // Bytes are spread evenly
+    static uint32_t counts[256];
+    random_state_t state;
+    random_state_init(&state, 3, 0);
+    for (int round = 0; round < 256; round++) {
+        fill_random8(&state, buf, LENGTH);
+        for (int i = 0; i < LENGTH; i++) counts[buf[i]]++;
+    }
+    for (int v = 0; v < 256; v++) TEST_ASSERT(counts[v] > 800 && counts[v] < 1200);
+
+    printf("streams reproduce and diverge; fill_random8 matches random8_r/random32_r\n");
+    return 0;
+}
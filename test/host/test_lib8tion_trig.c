@@ -0,0 +1,62 @@
+// Table-driven waves of lib8tion: sin8_table, quadwave8_table, sin8_lut()
+// and cos8_lut() equal sin8(), quadwave8() and cos8() at all 256 phases,
+// and fill_sin8(), fill_quadwave8() and fill_beatsin8() equal the scalar
+// functions element by element for any phase and step.
+#include "lib8tion.h"
+#include "host_test.h"
+
+#define NUM 300 // Longer than a turn, so the phase wraps
+
+static const uint8_t steps[] = { 0, 1, 3, 7, 64, 128, 255 };
+
+int main() {
+    for (int theta = 0; theta < 256; theta++) {
+        TEST_ASSERT_EQUAL(sin8(theta), sin8_table[theta]);
+        TEST_ASSERT_EQUAL(quadwave8(theta), quadwave8_table[theta]);
+        TEST_ASSERT_EQUAL(sin8(theta), sin8_lut(theta));
+        TEST_ASSERT_EQUAL(cos8(theta), cos8_lut(theta));
+    }
+
+    static uint8_t out[NUM + 1];
+    for (int phase = 0; phase < 256; phase++) {
+        for (size_t s = 0; s < sizeof(steps); s++) {
+            uint8_t step = steps[s];
+            out[NUM] = 0x5a;
+            fill_sin8(out, NUM, phase, step);
+            for (int i = 0; i < NUM; i++) TEST_ASSERT_EQUAL(sin8((uint8_t)(phase + i * step)), out[i]);
+            fill_quadwave8(out, NUM, phase, step);
+            for (int i = 0; i < NUM; i++) TEST_ASSERT_EQUAL(quadwave8((uint8_t)(phase + i * step)), out[i]);
+            TEST_ASSERT_EQUAL(0x5a, out[NUM]);
+        }
+    }
+
+    // The beat moves with the clock: compare only fills that saw one beat
+    static const accum88 bpms[] = { 0, 60 << 8, 143 << 8 };
+    static const uint8_t ranges[][2] = { { 0, 255 }, { 40, 200 }, { 100, 100 } };
+    int fills = 0;
+    for (size_t b = 0; b < sizeof(bpms) / sizeof(bpms[0]); b++) {
+        for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+            for (size_t s = 0; s < sizeof(steps); s++) {
+                uint8_t lowest = ranges[r][0], highest = ranges[r][1], offset = 17 * s;
+                uint32_t timebase = 1234;
+                uint8_t beat;
+                do {
+                    beat = beat8(bpms[b], timebase);
+                    fill_beatsin8(out, NUM, bpms[b], lowest, highest, timebase, offset, steps[s]);
+                } while (beat != beat8(bpms[b], timebase));
+                for (int i = 0; i < NUM; i++) {
+                    uint8_t phase = offset + i * steps[s];
+                    // beatsin8() at that beat with the element's phase offset
+                    uint8_t expected = lowest + scale8(sin8((uint8_t)(beat + phase)), highest - lowest);
+                    TEST_ASSERT_EQUAL(expected, out[i]);
+                    // At 0 BPM the beat stands still, so beatsin8() itself can be asked
+                    if (!bpms[b]) TEST_ASSERT_EQUAL(beatsin8(0, lowest, highest, timebase, phase), out[i]);
+                }
+                fills++;
+            }
+        }
+    }
+    printf("256 phases, %d wave fills and %d beat fills match the scalar functions\n",
+           256 * (int)sizeof(steps) * 2, fills);
+    return 0;
+}
@@ -0,0 +1,169 @@
+// Rollback netplay between two sessions on loopback: each session owns one
+// player of its own court and returns the ball it sees there, with packets
+// dropped and delayed by the test options. Once the inputs of both sides
+// are confirmed the two courts hold the same state frame by frame, and no
+// rollback went deeper than NET_MAX_ROLLBACK. One side then reboots (a new
+// session on the same port); the other restarts with it and they agree
+// again.
+#include <string.h>
+#include <unistd.h>
+#include "netplay.h"
+#include "esp_log.h"
+#include "host_test.h"
+
+#define NUM_LEDS 54
+#define FRAMES 6000                 // A minute of play
+#define LOSS_PCT 15
+#define DELAY_MS 30
+#define PRESS_ONE_IN 12             // Chance of a press per frame outside rallies
+
+static Court courts[2];
+static NetSession nets[2];
+static uint16_t ports[2];
+static uint32_t now_ms;
+static uint32_t rng = 12345;
+static uint32_t playing_frames;    // Frames player 1 simulated with the ball in play
+
+static void open_session(int i) {
+    TEST_ASSERT_EQUAL(ESP_OK, netplay_init(&nets[i], &courts[i], i + 1, ports[i], "127.0.0.1", ports[!i]));
+    nets[i].sim_loss_pct = LOSS_PCT;
+    nets[i].sim_delay_ms = DELAY_MS;
+}
+
+// Returns the ball at the paddle of player 'i' + 1 as this side sees it;
+// otherwise presses now and then, which serves and restarts games
+static bool bot(int i) {
+    const Court *c = &courts[i];
+    rng = rng * 1664525 + 1013904223;
+    if (c->state != GAME_STATE_PLAYING) return (rng >> 16) % PRESS_ONE_IN == 0;
+    if (i == 0) return c->ball.direction == LEFT && c->ball.position < 3;
+    return c->ball.direction == RIGHT && c->ball.position > NUM_LEDS - 4;
+}
+
+// Runs both sessions for 'frames' frames of wall time
+static void run(uint32_t frames, bool press) {
+    for (uint32_t k = 0; k < frames; k++, now_ms += NET_FRAME_MS) {
+        for (int i = 0; i < 2; i++) {
+            netplay_poll(&nets[i], now_ms);
+            if (bot(i) && press) netplay_press(&nets[i]);
+            netplay_advance(&nets[i], now_ms);
+        }
+        playing_frames += courts[0].state == GAME_STATE_PLAYING;
+    }
+}
+
+static bool same_state(const CourtSnapshot *a, const CourtSnapshot *b) {
+    if (memcmp(a->lives, b->lives, sizeof(a->lives)) || a->state != b->state || a->serving != b->serving ||
+        a->ball_position != b->ball_position || a->ball_speed != b->ball_speed ||
+        a->ball_direction != b->ball_direction || a->serveBlinkOn != b->serveBlinkOn ||
+        a->rallyCount != b->rallyCount || a->serveWaitStart != b->serveWaitStart || a->now != b->now ||
+        a->timers_armed != b->timers_armed || memcmp(a->deadlines, b->deadlines, sizeof(a->deadlines))) {
+        return false;
+    }
+    return a->anim.type == b->anim.type && a->anim.running == b->anim.running && a->anim.frame == b->anim.frame;
+}
+
+// Lets the packets in flight arrive without loss or presses, then compares
+// the state before the last frames both sides simulated with all inputs
+// confirmed, and the live courts at the same frame; returns the number of
+// states compared
+static int settle_and_compare(void) {
+    for (int i = 0; i < 2; i++) nets[i].sim_loss_pct = 0;
+    run(NET_MAX_ROLLBACK + DELAY_MS / NET_FRAME_MS + 4, false);
+    for (int i = 0; i < 2; i++) TEST_ASSERT_EQUAL(UINT32_MAX, nets[i].rollback_from);
+
+    uint32_t end = nets[0].frame;
+    for (int i = 0; i < 2; i++) {
+        if ((int32_t)(nets[i].frame - end) < 0) end = nets[i].frame;
+        if ((int32_t)(nets[i].remote_confirmed - end) < 0) end = nets[i].remote_confirmed;
+    }
+    TEST_ASSERT(end >= NET_RING / 2);
+    for (uint32_t f = end - NET_RING / 2; f != end; f++) {
+        CourtSnapshot *a = &nets[0].snapshots[f % NET_RING], *b = &nets[1].snapshots[f % NET_RING];
+        if (!same_state(a, b)) {
+            fprintf(stderr, "frame %u: courts differ\n", (unsigned)f);
+            exit(1);
+        }
+    }
+
+    // The live courts too, once both are at the same frame with all inputs
+    for (int i = 0; i < 2; i++) nets[i].sim_delay_ms = 0;
+    run(NET_MAX_ROLLBACK, false);
+    while (nets[0].frame != nets[1].frame) {
+        int behind = (int32_t)(nets[0].frame - nets[1].frame) > 0;
+        TEST_ASSERT(netplay_advance(&nets[behind], now_ms));
+    }
+    for (int i = 0; i < 2; i++) {
+        netplay_poll(&nets[i], now_ms);
+        TEST_ASSERT(nets[i].remote_confirmed >= nets[i].frame);
+        TEST_ASSERT_EQUAL(UINT32_MAX, nets[i].rollback_from);
+    }
+    CourtSnapshot a, b;
+    court_snapshot(&courts[0], &a);
+    court_snapshot(&courts[1], &b);
+    TEST_ASSERT(same_state(&a, &b));
+    for (int i = 0; i < 2; i++) {
+        nets[i].sim_loss_pct = LOSS_PCT;
+        nets[i].sim_delay_ms = DELAY_MS;
+    }
+    return NET_RING / 2 + 1;
+}
+
+static void report(const char *what) {
+    for (int i = 0; i < 2; i++) {
+        const NetStats *s = &nets[i].stats;
+        printf("%s, player %d: frame %u, %u rollbacks (%u frames, max %u), %u stalls, %u sent, %u received, "
+               "%u restarts\n", what, i + 1, (unsigned)nets[i].frame, (unsigned)s->rollbacks,
+               (unsigned)s->resimulated, (unsigned)s->max_rollback, (unsigned)s->stalls, (unsigned)s->sent,
+               (unsigned)s->received, (unsigned)s->restarts);
+        TEST_ASSERT(s->max_rollback <= NET_MAX_ROLLBACK);
+    }
+}
+
+int main() {
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+    esp_log_level_set("Netplay", ESP_LOG_ERROR);
+    ports[0] = 30000 + getpid() % 15000 * 2;
+    ports[1] = ports[0] + 1;
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL(ESP_OK, court_init(&courts[i], i, NUM_LEDS));
+        open_session(i);
+    }
+    TEST_ASSERT(nets[0].session && nets[1].session && nets[0].session != nets[1].session);
+
+    run(FRAMES, true);
+    int compared = settle_and_compare();
+    report("lossy link");
+    TEST_ASSERT_EQUAL(nets[1].session, nets[0].peer_session);
+    TEST_ASSERT_EQUAL(nets[0].session, nets[1].peer_session);
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT(nets[i].stats.rollbacks > 0);
+        TEST_ASSERT(nets[i].stats.received > 0 && nets[i].stats.received < nets[!i].stats.sent);
+        TEST_ASSERT_EQUAL(0, nets[i].stats.restarts);
+    }
+    TEST_ASSERT(playing_frames > FRAMES / 2);
+    printf("%d frames identical\n", compared);
+
+    // Player 2 reboots while player 1 still has packets in flight to it
+    uint32_t a_session = nets[0].session, b_session = nets[1].session;
+    run(FRAMES / 10, true);
+    netplay_free(&nets[1]);
+    open_session(1);
+    TEST_ASSERT(nets[1].session != b_session);
+    run(FRAMES / 2, true);
+    compared = settle_and_compare();
+    report("after reboot");
+    TEST_ASSERT_EQUAL(1, nets[0].stats.restarts);
+    TEST_ASSERT_EQUAL(0, nets[1].stats.restarts);
+    TEST_ASSERT(nets[0].session != a_session);
+    TEST_ASSERT_EQUAL(nets[1].session, nets[0].peer_session);
+    TEST_ASSERT_EQUAL(nets[0].session, nets[1].peer_session);
+    TEST_ASSERT(nets[0].frame < FRAMES / 2 + NET_RING); // Restarted at frame 0
+    printf("%d frames identical\n", compared);
+
+    for (int i = 0; i < 2; i++) {
+        netplay_free(&nets[i]);
+        court_free(&courts[i]);
+    }
+    return 0;
+}
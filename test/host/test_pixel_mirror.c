@@ -0,0 +1,144 @@
+// Spectator mirror against a pixel node on loopback, both on 600-LED
+// strips: the first frame goes out in full, later frames only with their
+// changed LEDs, nearby changes in one packet and the last packet pushing
+// the frame. A frame flushed within 1 / max_fps of the last one is held
+// back, and newer frames replace it and count as dropped; an unchanged
+// frame sends nothing, and a full frame repeats the last one when the
+// keyframe interval is due. After every send the node shows the source
+// frame and has missed no packet.
+#include <string.h>
+#include <unistd.h>
+#include "pixel_node.h"
+#include "pixel_mirror.h"
+#include "esp_log.h"
+#include "host_test.h"
+
+#define NUM_LEDS 600
+#define BUF_SIZE (NUM_LEDS * 3)
+#define MAX_FPS 50
+#define FRAME_US (1000000 / MAX_FPS)
+#define KEYFRAME_MS 1000
+#define START_US 5000000            // Clock at the first send, as some time after boot
+
+static led_strip_t source, target;
+static pixel_node_t node;
+static pixel_mirror_t mirror;
+static int64_t now_us;
+
+// Lets the node read what the mirror sent; returns the frames it showed
+static uint32_t receive(void) {
+    uint32_t frames = 0;
+    if (pixel_node_wait(&node, 100) == ESP_OK) TEST_ASSERT_EQUAL(ESP_OK, pixel_node_receive(&node, &frames));
+    return frames;
+}
+
+static void check_target(void) {
+    static uint8_t rgb[BUF_SIZE];
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_read_rgb(&source, rgb));
+    TEST_ASSERT(!memcmp(target.buf, rgb, BUF_SIZE));
+}
+
+// Sends 'at_us' after the first send; returns the packets that went out
+static uint32_t send_at(int64_t at_us, int64_t *wait_us) {
+    now_us = START_US + at_us;
+    uint32_t packets = mirror.stats.packets;
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_mirror_send(&mirror, now_us, wait_us));
+    return mirror.stats.packets - packets;
+}
+
+static void set(size_t led, uint8_t v) {
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_set_pixel(&source, led, (rgb_t){ .r = v, .g = v + 1, .b = v + 2 }));
+}
+
+int main() {
+    esp_log_level_set("pixel_node", ESP_LOG_WARN);
+    esp_log_level_set("pixel_mirror", ESP_LOG_WARN);
+    led_strip_install();
+    source = (led_strip_t){ .type = LED_STRIP_WS2812, .length = NUM_LEDS, .gpio = 18, .channel = 0,
+                            .brightness = 255 };
+    target = (led_strip_t){ .type = LED_STRIP_WS2812, .length = NUM_LEDS, .gpio = 19, .channel = 1,
+                            .brightness = 255, .rgb_buf = true };
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_init(&source));
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_init(&target));
+    uint16_t port = 30000 + getpid() % 15000 * 2;
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_node_init(&node, &target, PIXEL_NODE_DDP, port, 0));
+    pixel_mirror_config_t config = { .peers = { "127.0.0.1" }, .port = port, .max_fps = MAX_FPS,
+                                     .keyframe_ms = KEYFRAME_MS };
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_mirror_init(&mirror, &source, &config));
+
+    // Full first frame: 1440 + 360 bytes
+    for (size_t i = 0; i < NUM_LEDS; i++) set(i, i);
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_flush(&source));
+    TEST_ASSERT_EQUAL(1, mirror.stats.submitted);
+    TEST_ASSERT_EQUAL(2, send_at(0, NULL));
+    TEST_ASSERT_EQUAL(1, receive());
+    check_target();
+    TEST_ASSERT_EQUAL(1, mirror.stats.keyframes);
+    TEST_ASSERT_EQUAL(BUF_SIZE, mirror.stats.bytes);
+
+    // Delta: LEDs 10..30 in one packet (gaps below 64 bytes), LED 500 alone
+    set(10, 0xa0);
+    set(12, 0xa1);
+    set(30, 0xa2);
+    set(500, 0xa3);
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_flush(&source));
+    TEST_ASSERT_EQUAL(2, send_at(FRAME_US, NULL));
+    TEST_ASSERT_EQUAL(1, receive());
+    check_target();
+    TEST_ASSERT_EQUAL(BUF_SIZE + 21 * 3 + 3, mirror.stats.bytes);
+    TEST_ASSERT_EQUAL(1, mirror.stats.keyframes);
+
+    // Held back by max_fps; a newer frame replaces it
+    int64_t wait_us;
+    set(100, 0xb0);
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_flush(&source));
+    TEST_ASSERT_EQUAL(0, send_at(FRAME_US + FRAME_US / 4, &wait_us));
+    TEST_ASSERT_EQUAL(FRAME_US * 3 / 4, wait_us);
+    set(101, 0xb1);
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_flush(&source));
+    TEST_ASSERT_EQUAL(1, mirror.stats.dropped);
+    TEST_ASSERT_EQUAL(0, receive());
+    TEST_ASSERT_EQUAL(1, send_at(2 * FRAME_US, &wait_us));
+    TEST_ASSERT_EQUAL(1, receive());
+    check_target();
+    TEST_ASSERT_EQUAL(KEYFRAME_MS * 1000 - 2 * FRAME_US, wait_us); // Nothing waiting: the next full frame
+
+    // An unchanged frame sends nothing
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_flush(&source));
+    TEST_ASSERT_EQUAL(0, send_at(3 * FRAME_US, NULL));
+    TEST_ASSERT_EQUAL(3, mirror.stats.sent);
+
+    // Backpressure: frames flushed faster than sent are dropped but the last
+    for (int k = 0; k < 10; k++) {
+        set(200 + k, 0xc0 + k);
+        TEST_ASSERT_EQUAL(ESP_OK, led_strip_flush(&source));
+    }
+    TEST_ASSERT_EQUAL(10, mirror.stats.dropped);
+    TEST_ASSERT_EQUAL(1, send_at(4 * FRAME_US, NULL));
+    TEST_ASSERT_EQUAL(1, receive());
+    check_target();
+
+    // Keyframe: without new frames the last one goes out in full when due
+    TEST_ASSERT_EQUAL(0, send_at(KEYFRAME_MS * 1000 - 1, &wait_us));
+    TEST_ASSERT_EQUAL(1, wait_us);
+    memset(target.buf, 0, BUF_SIZE); // As a receiver that joined late
+    TEST_ASSERT_EQUAL(2, send_at(KEYFRAME_MS * 1000, NULL));
+    TEST_ASSERT_EQUAL(1, receive());
+    check_target();
+    TEST_ASSERT_EQUAL(2, mirror.stats.keyframes);
+    TEST_ASSERT_EQUAL(5, mirror.stats.sent);
+    TEST_ASSERT_EQUAL(15, mirror.stats.submitted);
+
+    TEST_ASSERT_EQUAL(mirror.stats.packets, node.stats.packets);
+    TEST_ASSERT_EQUAL(0, node.stats.dropped);
+    printf("%u frames submitted, %u sent (%u full), %u dropped, %u packets, %u bytes\n",
+           (unsigned)mirror.stats.submitted, (unsigned)mirror.stats.sent, (unsigned)mirror.stats.keyframes,
+           (unsigned)mirror.stats.dropped, (unsigned)mirror.stats.packets, (unsigned)mirror.stats.bytes);
+
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_mirror_free(&mirror));
+    TEST_ASSERT(source.flush_cb == NULL);
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_node_free(&node));
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_free(&source));
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_free(&target));
+    return 0;
+}
@@ -0,0 +1,205 @@
+// Network pixel receiver on loopback: DDP packets land in the strip buffer
+// at their offset and a PUSH shows the frame; E1.31 universes land one after
+// the other and the frame is shown by the matching sync packet, or without
+// a sync address by the last universe of the strip. Missing sequence numbers
+// count as dropped, E1.31 packets less than 20 behind are late and
+// discarded, further back is a restarted source. The strip keeps RGB in its buffer
+// (`rgb_buf`) and the RMT items sent for a frame carry it in WS2812 wire
+// order.
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include "pixel_node.h"
+#include "esp_log.h"
+#include "host_test.h"
+
+#define NUM_LEDS 200                // Two E1.31 universes of 170 RGB LEDs
+#define BUF_SIZE (NUM_LEDS * 3)
+#define UNIVERSE 10
+#define SYNC_UNIVERSE 7000
+
+static led_strip_t strip;
+static pixel_node_t node;
+static int sender = -1;
+static struct sockaddr_in node_addr;
+static uint8_t frame[BUF_SIZE];     // Payload of the current frame
+
+static void fill_frame(uint8_t seed) {
+    for (int i = 0; i < BUF_SIZE; i++) frame[i] = (uint8_t)(i * 7 + seed);
+}
+
+// Sends 'len' bytes and lets the node read them; returns the frames shown
+static uint32_t deliver(const uint8_t *packet, size_t len) {
+    TEST_ASSERT(sendto(sender, packet, len, 0, (struct sockaddr *)&node_addr, sizeof(node_addr)) == (ssize_t)len);
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_node_wait(&node, 1000));
+    uint32_t frames;
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_node_receive(&node, &frames));
+    return frames;
+}
+
+static void open_node(pixel_node_protocol_t protocol, uint16_t port) {
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_node_init(&node, &strip, protocol, port, UNIVERSE));
+    node_addr = (struct sockaddr_in){ .sin_family = AF_INET, .sin_port = htons(port),
+                                      .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    memset(strip.buf, 0, BUF_SIZE);
+}
+
+// --- DDP ---
+static uint32_t send_ddp(uint8_t flags, uint8_t seq, size_t offset, size_t len) {
+    uint8_t packet[10 + BUF_SIZE] = { 0x40 | flags, seq, 0x0b, 1, offset >> 24, offset >> 16, offset >> 8, offset,
+                                      len >> 8, len };
+    memcpy(packet + 10, frame + offset, len);
+    return deliver(packet, 10 + len);
+}
+
+// --- E1.31 ---
+static uint32_t send_e131(uint16_t universe, uint8_t seq, uint8_t options, uint16_t sync) {
+    static const uint8_t acn_id[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+    uint8_t packet[126 + 512] = { 0x00, 0x10 };
+    size_t offset = (universe - UNIVERSE) * 510;
+    size_t len = BUF_SIZE - offset < 510 ? BUF_SIZE - offset : 510;
+    memcpy(packet + 4, acn_id, sizeof(acn_id));
+    packet[21] = 0x04;                              // Root vector: data
+    packet[43] = 0x02;                              // Framing vector: data packet
+    packet[108] = 100;                              // Priority
+    packet[109] = sync >> 8, packet[110] = sync;
+    packet[111] = seq;
+    packet[112] = options;
+    packet[113] = universe >> 8, packet[114] = universe;
+    packet[117] = 0x02, packet[118] = 0xa1;         // DMP: set property, address type
+    packet[122] = 1;                                // Address increment
+    packet[123] = (len + 1) >> 8, packet[124] = len + 1;
+    memcpy(packet + 126, frame + offset, len);
+    return deliver(packet, 126 + len);
+}
+
+static uint32_t send_e131_sync(uint16_t sync) {
+    static const uint8_t acn_id[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+    uint8_t packet[49] = { 0x00, 0x10 };
+    memcpy(packet + 4, acn_id, sizeof(acn_id));
+    packet[21] = 0x08;                              // Root vector: extended
+    packet[43] = 0x01;                              // Framing vector: sync
+    packet[45] = sync >> 8, packet[46] = sync;
+    return deliver(packet, sizeof(packet));
+}
+
+// Decodes the RMT items of the last flush and checks them against the
+// frame in WS2812 order, G, R, B
+static void check_wire(void) {
+    led_strip_timing_t timing;
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_get_timing(&strip, &timing));
+    size_t num;
+    const rmt_item32_t *items = rmt_stub_items(strip.channel, &num);
+    TEST_ASSERT_EQUAL(BUF_SIZE * 8, num);
+    uint32_t mid_ns = (timing.t0h_ns + timing.t1h_ns) / 2;
+    for (int led = 0; led < NUM_LEDS; led++) {
+        const uint8_t *rgb = frame + led * 3;
+        uint8_t wire[3] = { rgb[1], rgb[0], rgb[2] };
+        for (int b = 0; b < 24; b++) {
+            bool one = items[led * 24 + b].duration0 * 50 > mid_ns;
+            TEST_ASSERT_EQUAL((wire[b / 8] >> (7 - b % 8)) & 1, one);
+        }
+    }
+}
+
+int main() {
+    esp_log_level_set("pixel_node", ESP_LOG_WARN);
+    led_strip_install();
+    strip = (led_strip_t){
+        .type = LED_STRIP_WS2812,
+        .length = NUM_LEDS,
+        .gpio = 18,
+        .channel = 0,
+        .brightness = 255,
+        .rgb_buf = true,
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_init(&strip));
+    sender = socket(AF_INET, SOCK_DGRAM, 0);
+    TEST_ASSERT(sender >= 0);
+    uint16_t port = 30000 + getpid() % 15000 * 2;
+
+    // DDP: two halves, the second one pushes
+    open_node(PIXEL_NODE_DDP, port);
+    fill_frame(1);
+    TEST_ASSERT_EQUAL(0, send_ddp(0, 1, 0, BUF_SIZE / 2));
+    TEST_ASSERT_EQUAL(0, node.stats.frames);
+    TEST_ASSERT(!memcmp(strip.buf, frame, BUF_SIZE / 2));
+    TEST_ASSERT_EQUAL(1, send_ddp(0x01, 2, BUF_SIZE / 2, BUF_SIZE / 2));
+    TEST_ASSERT(!memcmp(strip.buf, frame, BUF_SIZE));
+    check_wire();
+    TEST_ASSERT_EQUAL(2, node.stats.packets);
+    TEST_ASSERT_EQUAL(NUM_LEDS, node.stats.pixels);
+
+    // Sequence numbers run 1..15: 5 after 2 misses two, 15 after 5 nine,
+    // and 15 to 1 is no gap
+    TEST_ASSERT_EQUAL(1, send_ddp(0x01, 5, 0, BUF_SIZE));
+    TEST_ASSERT_EQUAL(2, node.stats.dropped);
+    TEST_ASSERT_EQUAL(1, send_ddp(0x01, 15, 0, BUF_SIZE));
+    TEST_ASSERT_EQUAL(1, send_ddp(0x01, 1, 0, BUF_SIZE));
+    TEST_ASSERT_EQUAL(11, node.stats.dropped);
+    // A query is not written
+    TEST_ASSERT_EQUAL(0, send_ddp(0x02, 0, 0, 3));
+    TEST_ASSERT_EQUAL(1, node.stats.ignored);
+    printf("DDP: %u frames, %u packets, %u dropped\n", (unsigned)node.stats.frames, (unsigned)node.stats.packets,
+           (unsigned)node.stats.dropped);
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_node_free(&node));
+
+    // E1.31 without a sync address: the last universe shows the frame
+    open_node(PIXEL_NODE_E131, port + 1);
+    fill_frame(2);
+    TEST_ASSERT_EQUAL(0, send_e131(UNIVERSE, 1, 0, 0));
+    TEST_ASSERT_EQUAL(1, send_e131(UNIVERSE + 1, 1, 0, 0));
+    TEST_ASSERT(!memcmp(strip.buf, frame, BUF_SIZE));
+    check_wire();
+    TEST_ASSERT_EQUAL(0, send_e131(UNIVERSE + 2, 1, 0, 0)); // Past the strip
+    TEST_ASSERT_EQUAL(0, send_e131(UNIVERSE, 2, 0x40, 0));  // Preview data
+    TEST_ASSERT_EQUAL(2, node.stats.ignored);
+
+    // With a sync address only the matching sync packet shows it
+    fill_frame(3);
+    TEST_ASSERT_EQUAL(0, send_e131(UNIVERSE, 2, 0, SYNC_UNIVERSE));
+    TEST_ASSERT_EQUAL(0, send_e131(UNIVERSE + 1, 2, 0, SYNC_UNIVERSE));
+    TEST_ASSERT_EQUAL(0, send_e131_sync(SYNC_UNIVERSE + 1));
+    TEST_ASSERT_EQUAL(1, send_e131_sync(SYNC_UNIVERSE));
+    TEST_ASSERT(!memcmp(strip.buf, frame, BUF_SIZE));
+    check_wire();
+    TEST_ASSERT_EQUAL(0, send_e131_sync(SYNC_UNIVERSE)); // Nothing new
+    TEST_ASSERT_EQUAL(2, node.stats.frames);
+
+    // Sequence numbers per universe: a gap is dropped packets, a step back
+    // of up to 19 is late and not written, 20 is a restarted source
+    fill_frame(4);
+    TEST_ASSERT_EQUAL(0, send_e131(UNIVERSE, 6, 0, 0));
+    TEST_ASSERT_EQUAL(3, node.stats.dropped);
+    uint8_t before[BUF_SIZE];
+    memcpy(before, strip.buf, BUF_SIZE);
+    fill_frame(5);
+    TEST_ASSERT_EQUAL(0, send_e131(UNIVERSE, 5, 0, 0));
+    TEST_ASSERT_EQUAL(0, send_e131(UNIVERSE, 6, 0, 0));
+    TEST_ASSERT_EQUAL(0, send_e131(UNIVERSE, 6 - 19, 0, 0));
+    TEST_ASSERT_EQUAL(3, node.stats.late);
+    TEST_ASSERT(!memcmp(strip.buf, before, BUF_SIZE));
+    TEST_ASSERT_EQUAL(0, send_e131(UNIVERSE, 6 - 20, 0, 0));
+    TEST_ASSERT_EQUAL(3, node.stats.late);
+    TEST_ASSERT_EQUAL(3, node.stats.dropped);
+    TEST_ASSERT(!memcmp(strip.buf, frame, 510));
+    TEST_ASSERT_EQUAL(1, send_e131(UNIVERSE + 1, 3, 0, 0));
+    check_wire();
+    printf("E1.31: %u frames, %u packets, %u dropped, %u late, %u ignored\n", (unsigned)node.stats.frames,
+           (unsigned)node.stats.packets, (unsigned)node.stats.dropped, (unsigned)node.stats.late,
+           (unsigned)node.stats.ignored);
+
+    // Discarded packets are not written and start the streams over
+    TEST_ASSERT(sendto(sender, "x", 1, 0, (struct sockaddr *)&node_addr, sizeof(node_addr)) == 1);
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_node_wait(&node, 1000));
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_node_discard(&node));
+    TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, pixel_node_wait(&node, 0));
+    TEST_ASSERT_EQUAL(0, send_e131(UNIVERSE, 200, 0, 0));
+    TEST_ASSERT_EQUAL(3, node.stats.dropped);
+
+    TEST_ASSERT_EQUAL(ESP_OK, pixel_node_free(&node));
+    TEST_ASSERT_EQUAL(ESP_OK, led_strip_free(&strip));
+    close(sender);
+    return 0;
+}
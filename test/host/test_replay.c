@@ -0,0 +1,60 @@
+// Smoke test of input log replays: presses are counted, the replay ends
+// after its tail, and frames do not depend on the frame rate.
+#include <string.h>
+#include "replay.h"
+#include "esp_log.h"
+#include "host_test.h"
+
+#define NUM_LEDS 54
+#define TAIL_MS 2000
+
+// Plays 'log' in frames of 'frame_ms'; keeps the frame shown at 'at_ms'
+static uint32_t play(FILE *log, uint32_t frame_ms, uint32_t at_ms, rgb_t *at, uint32_t *presses) {
+    Replay replay;
+    rewind(log);
+    TEST_ASSERT_EQUAL(ESP_OK, replay_init(&replay, log, NUM_LEDS, TAIL_MS));
+    const rgb_t *frame;
+    bool changed;
+    uint32_t frames = 0;
+    for (uint32_t t = 0; (frame = replay_frame(&replay, t, &changed)); t += frame_ms) {
+        if (t == at_ms) memcpy(at, frame, NUM_LEDS * sizeof(rgb_t));
+        frames++;
+    }
+    *presses = replay.presses;
+    replay_free(&replay);
+    return frames;
+}
+
+int main() {
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+    FILE *log = tmpfile();
+    TEST_ASSERT(log);
+    fprintf(log, "3000 1 # serve\n");
+    fprintf(log, "not a press\n");
+    fprintf(log, "3500 3\n");           // No such player, skipped
+    write_input_log(log, 4000, 30000);
+    uint32_t last_ms = 0, lines = 1;
+    rewind(log);
+    char line[80];
+    unsigned t;
+    int player;
+    while (fgets(line, sizeof(line), log)) {
+        if (sscanf(line, "%u %d", &t, &player) == 2 && t >= 4000) {
+            last_ms = t;
+            lines++;
+        }
+    }
+
+    static rgb_t at10[NUM_LEDS], at5[NUM_LEDS];
+    uint32_t presses10, presses5;
+    uint32_t frames10 = play(log, 10, 20000, at10, &presses10);
+    uint32_t frames5 = play(log, 5, 20000, at5, &presses5);
+    TEST_ASSERT_EQUAL(lines, presses10);
+    TEST_ASSERT_EQUAL(lines, presses5);
+    TEST_ASSERT_EQUAL((last_ms + TAIL_MS) / 10 + 1, frames10);
+    TEST_ASSERT_EQUAL((last_ms + TAIL_MS) / 5 + 1, frames5);
+    TEST_ASSERT(!memcmp(at10, at5, sizeof(at10)));
+    printf("%u presses, %u frames\n", (unsigned)presses10, (unsigned)frames10);
+    fclose(log);
+    return 0;
+}
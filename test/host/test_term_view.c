@@ -0,0 +1,160 @@
+// Smoke test of the terminal view: the escape sequences written for a
+// match, replayed on a minimal terminal model, show every frame exactly. A
+// frame larger than the pipe written to a non-blocking output (as stdout
+// sharing a tty with a non-blocking keyboard) arrives in full.
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "term_view.h"
+#include "env.h"
+#include "esp_log.h"
+#include "host_test.h"
+
+#define NUM_LEDS 54
+#define COLUMNS 20
+#define ROWS ((NUM_LEDS + COLUMNS - 1) / COLUMNS)
+#define FRAMES 3000
+#define BIG_LEDS 8000               // About 200 KB of escapes, more than a pipe holds
+
+// Terminal model: background colour of every screen cell
+static rgb_t screen[ROWS + 2][COLUMNS * 2 + 2];
+static int row = 1, col = 1;
+static rgb_t background;
+
+static void terminal_write(const char *s, size_t len) {
+    for (size_t i = 0; i < len;) {
+        if (s[i] == '\n') {
+            row++;
+            col = 1;
+            i++;
+        } else if (s[i] != 0x1b) {
+            if (row <= ROWS && col <= COLUMNS * 2) screen[row][col] = background;
+            col++;
+            i++;
+        } else {
+            TEST_ASSERT(s[i + 1] == '[');
+            i += 2;
+            if (s[i] == '?') { // Cursor show/hide
+                while (s[i] != 'h' && s[i] != 'l') i++;
+                i++;
+                continue;
+            }
+            int v[5] = { 0 }, n = 0;
+            for (; (s[i] >= '0' && s[i] <= '9') || s[i] == ';'; i++) {
+                if (s[i] == ';') {
+                    TEST_ASSERT(++n < 5);
+                } else {
+                    v[n] = v[n] * 10 + s[i] - '0';
+                }
+            }
+            char command = s[i++];
+            if (command == 'H') {
+                row = v[0];
+                col = v[1];
+            } else if (command == 'm' && v[0] == 48) {
+                background = (rgb_t){ .r = v[2], .g = v[3], .b = v[4] };
+            } else {
+                TEST_ASSERT(command == 'J' || command == 'm');
+            }
+        }
+    }
+}
+
+static void drain(int fd) {
+    static char buf[1 << 16];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) terminal_write(buf, n);
+}
+
+int main() {
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+    int out[2], keys[2];
+    TEST_ASSERT(pipe(out) == 0 && pipe(keys) == 0);
+    fcntl(out[0], F_SETFL, O_NONBLOCK);
+    int flags = fcntl(keys[0], F_GETFL, 0);
+
+    Env env;
+    EnvObs obs;
+    static rgb_t frame[NUM_LEDS];
+    TEST_ASSERT_EQUAL(ESP_OK, env_init(&env, 1, NUM_LEDS, 0));
+    env_reset(&env, 0, 1, &obs);
+
+    TermView view;
+    TEST_ASSERT_EQUAL(ESP_OK, term_view_init(&view, out[1], keys[0], NUM_LEDS, COLUMNS, 0));
+    TEST_ASSERT(fcntl(keys[0], F_GETFL, 0) & O_NONBLOCK);
+    for (int f = 0; f < FRAMES; f++) {
+        uint8_t action = 0;
+        int led = (int)(obs.ball_position + 0.5f);
+        if (obs.state == GAME_STATE_WAIT_SERVE) {
+            action = obs.serving ? ENV_PRESS_P2 : ENV_PRESS_P1;
+        } else if (obs.ball_direction < 0 && led <= 5) {
+            action = ENV_PRESS_P1;
+        } else if (obs.ball_direction > 0 && led >= NUM_LEDS - 6 && f % 3) {
+            action = ENV_PRESS_P2;
+        }
+        env_step(&env, 0, 1, &action, &obs, frame);
+        TEST_ASSERT(term_view_draw(&view, frame, f));
+        drain(out[0]);
+        for (int i = 0; i < NUM_LEDS; i++) {
+            rgb_t *cell = &screen[i / COLUMNS + 1][i % COLUMNS * 2 + 1];
+            TEST_ASSERT(!memcmp(&cell[0], &frame[i], sizeof(rgb_t)) && !memcmp(&cell[1], &frame[i], sizeof(rgb_t)));
+        }
+    }
+    TEST_ASSERT(view.stats.cells < FRAMES * NUM_LEDS / 4); // Only changes are redrawn
+    printf("%u frames, %.1f cells and %.0f bytes per frame\n", (unsigned)view.stats.frames,
+           (double)view.stats.cells / view.stats.frames, (double)view.stats.bytes / view.stats.frames);
+
+    // Keys
+    TEST_ASSERT_EQUAL(0, term_view_keys(&view));
+    TEST_ASSERT_EQUAL(3, write(keys[1], "xaL", 3));
+    TEST_ASSERT_EQUAL(ENV_PRESS_P1 | ENV_PRESS_P2, term_view_keys(&view));
+    TEST_ASSERT_EQUAL(1, write(keys[1], "\x1b", 1));
+    TEST_ASSERT_EQUAL(TERM_VIEW_QUIT, term_view_keys(&view));
+    term_view_free(&view);
+    TEST_ASSERT_EQUAL(flags, fcntl(keys[0], F_GETFL, 0));
+
+    // Frame rate limit: 1 ms frames at 100 fps
+    TEST_ASSERT_EQUAL(ESP_OK, term_view_init(&view, out[1], -1, NUM_LEDS, COLUMNS, 100));
+    int drawn = 0;
+    for (int f = 0; f < 1000; f++) {
+        drawn += term_view_draw(&view, frame, f * 1000);
+        drain(out[0]);
+    }
+    TEST_ASSERT_EQUAL(100, drawn);
+    TEST_ASSERT_EQUAL(900, view.stats.skipped);
+    term_view_free(&view);
+
+    // Non-blocking output: a slow reader in a child process counts the bytes
+    int big[2], result[2];
+    TEST_ASSERT(pipe(big) == 0 && pipe(result) == 0);
+    pid_t child = fork();
+    TEST_ASSERT(child >= 0);
+    if (!child) {
+        close(big[1]);
+        static char buf[4096];
+        uint64_t total = 0;
+        ssize_t n;
+        usleep(20000);
+        while ((n = read(big[0], buf, sizeof(buf))) > 0) total += n;
+        _exit(write(result[1], &total, sizeof(total)) != sizeof(total));
+    }
+    close(big[0]);
+    fcntl(big[1], F_SETFL, O_NONBLOCK);
+    static rgb_t big_frame[BIG_LEDS];
+    for (int i = 0; i < BIG_LEDS; i++) big_frame[i] = (rgb_t){ .r = 100 + i % 100, .g = i % 7, .b = 200 };
+    TEST_ASSERT_EQUAL(ESP_OK, term_view_init(&view, big[1], -1, BIG_LEDS, COLUMNS, 0));
+    TEST_ASSERT(term_view_draw(&view, big_frame, 0));
+    TEST_ASSERT(view.stats.bytes > 1 << 17);
+    uint64_t expected = view.stats.bytes;
+    term_view_free(&view);
+    close(big[1]);
+    uint64_t received = 0;
+    TEST_ASSERT_EQUAL(sizeof(received), read(result[0], &received, sizeof(received)));
+    int status;
+    TEST_ASSERT(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    TEST_ASSERT(received > expected); // Plus the screen set-up and restore
+    TEST_ASSERT(received < expected + 64);
+    env_free(&env);
+    return 0;
+}
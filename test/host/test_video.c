@@ -0,0 +1,68 @@
+// Smoke test of video export: a Y4M stream from an input log and a PNG
+// sequence from a frame log come out with the expected sizes and headers.
+#include <string.h>
+#include "video.h"
+#include "game.h"
+#include "esp_log.h"
+#include "host_test.h"
+
+#define NUM_LEDS 54
+#define SCALE 4
+#define PNG_FRAMES 3
+
+static long file_size(const char *path) {
+    FILE *f = fopen(path, "rb");
+    TEST_ASSERT(f);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+int main() {
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+    FILE *inputs = tmpfile();
+    TEST_ASSERT(inputs);
+    write_input_log(inputs, 3000, 10000);
+    rewind(inputs);
+
+    Video video;
+    TEST_ASSERT_EQUAL(ESP_OK, video_open(&video, VIDEO_Y4M, "test_video.y4m", NUM_LEDS, SCALE, 25));
+    TEST_ASSERT_EQUAL(ESP_OK, video_replay_inputs(&video, inputs, 1000));
+    uint32_t frames = video.frames;
+    TEST_ASSERT(frames > 25 * 10);
+    TEST_ASSERT_EQUAL(ESP_OK, video_close(&video));
+    char header[64];
+    int header_len = snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F25:1 Ip A1:1 C444\n", NUM_LEDS * SCALE, SCALE);
+    long frame_size = 6 + 3L * NUM_LEDS * SCALE * SCALE; // "FRAME\n" and three planes
+    TEST_ASSERT_EQUAL(header_len + frames * frame_size, file_size("test_video.y4m"));
+
+    // Frame log: a ball moving along the strip
+    FILE *frame_log = tmpfile();
+    TEST_ASSERT(frame_log);
+    for (int f = 0; f < PNG_FRAMES; f++) {
+        rgb_t frame[NUM_LEDS] = { 0 };
+        frame[f * 10] = (rgb_t){ .r = 0, .g = 255, .b = 255 };
+        fwrite(frame, sizeof(frame), 1, frame_log);
+    }
+    rewind(frame_log);
+    TEST_ASSERT_EQUAL(ESP_OK, video_open(&video, VIDEO_PNG, "test_video_%02d.png", NUM_LEDS, SCALE, 0));
+    TEST_ASSERT_EQUAL(ESP_OK, video_replay_frames(&video, frame_log));
+    TEST_ASSERT_EQUAL(PNG_FRAMES, video.frames);
+    TEST_ASSERT_EQUAL(ESP_OK, video_close(&video));
+    for (int f = 0; f < PNG_FRAMES; f++) {
+        char name[32];
+        uint8_t head[24];
+        snprintf(name, sizeof(name), "test_video_%02d.png", f);
+        FILE *png = fopen(name, "rb");
+        TEST_ASSERT(png);
+        TEST_ASSERT_EQUAL(sizeof(head), fread(head, 1, sizeof(head), png));
+        fclose(png);
+        TEST_ASSERT(!memcmp(head, "\x89PNG\r\n\x1a\n", 8) && !memcmp(head + 12, "IHDR", 4));
+        TEST_ASSERT_EQUAL(NUM_LEDS * SCALE, (head[16] << 24) | (head[17] << 16) | (head[18] << 8) | head[19]);
+    }
+    printf("%u Y4M frames, %d PNG frames\n", (unsigned)frames, PNG_FRAMES);
+    fclose(frame_log);
+    fclose(inputs);
+    return 0;
+}
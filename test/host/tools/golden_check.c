@@ -0,0 +1,79 @@
+// Checks a scenario against its golden file (see golden.h), or records the
+// golden file with --record after an intended render change.
+//
+//   golden_check [--record] [--leds N] scenario.log scenario.golden
+//
+// A check takes the court length from the header of the golden file, a
+// recording from --leds (default 54, a court of the firmware). Exits with 0
+// if the scenario matches, 1 with the first divergent frame described on
+// stderr if not, and 2 on errors.
+#include <stdlib.h>
+#include <string.h>
+#include "golden.h"
+#include "game.h"
+#include "esp_log.h"
+
+#define DEFAULT_LEDS 54
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [--record] [--leds N] scenario.log scenario.golden\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    bool record = false;
+    int leds = DEFAULT_LEDS;
+    const char *paths[2];
+    int num_paths = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--record")) {
+            record = true;
+        } else if (!strcmp(argv[i], "--leds") && i + 1 < argc) {
+            leds = atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && num_paths < 2) {
+            paths[num_paths++] = argv[i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (num_paths != 2 || leds < 1) usage(argv[0]);
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+
+    FILE *inputs = fopen(paths[0], "r");
+    FILE *golden = fopen(paths[1], record ? "w" : "r");
+    if (!inputs || !golden) {
+        perror(inputs ? paths[1] : paths[0]);
+        return 2;
+    }
+
+    GoldenResult result;
+    esp_err_t r;
+    if (record) {
+        r = golden_record(inputs, leds, golden, &result);
+    } else {
+        if (fscanf(golden, "# golden %d LEDs", &leds) != 1) {
+            fprintf(stderr, "%s: not a golden file\n", paths[1]);
+            return 2;
+        }
+        rewind(golden);
+        r = golden_check(inputs, leds, golden, stderr, &result);
+    }
+    fclose(inputs);
+    if (fclose(golden) || r != ESP_OK) {
+        fprintf(stderr, "%s: %s failed\n", paths[1], record ? "recording" : "reading");
+        return 2;
+    }
+
+    printf("%s: %u frames, %u flushed, hash %016llx", paths[0], (unsigned)result.frames, (unsigned)result.flushed,
+           (unsigned long long)result.hash);
+    if (record) {
+        printf(", recorded\n");
+        return 0;
+    }
+    if (!result.match) {
+        printf(", diverges at frame %u\n", (unsigned)result.first_mismatch);
+        return 1;
+    }
+    printf(", matches\n");
+    return 0;
+}
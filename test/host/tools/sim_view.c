@@ -0,0 +1,115 @@
+// Plays a court in the terminal: the training environment runs one court in
+// real time and term_view draws it, with the keyboard on the buttons ('a'
+// for player 1, 'l' for player 2, Esc or Ctrl-C to quit). With --replay it
+// plays an input log (see replay.h) instead and only reads the keyboard to
+// quit. The terminal needs 24-bit colour.
+//
+//   sim_view [--leds N] [--fps N] [--columns N] [--replay log]
+//
+// Defaults: 54 LEDs, 60 frames per second, 40 LEDs per row. Without a log
+// the environment advances one frame per step, so a lower frame rate also
+// makes the ball move in coarser steps.
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "env.h"
+#include "replay.h"
+#include "term_view.h"
+#include "esp_log.h"
+#include "frame_clock.h"
+
+#define DEFAULT_LEDS 54
+#define DEFAULT_FPS 60
+
+static void on_deadline(void *arg) {
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [--leds N] [--fps N] [--columns N] [--replay log]\n", argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    int leds = DEFAULT_LEDS, columns = 0;
+    uint32_t fps = DEFAULT_FPS;
+    const char *replay_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        if (!strcmp(argv[i], "--leds")) {
+            leds = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--fps")) {
+            fps = strtoul(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--columns")) {
+            columns = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--replay")) {
+            replay_path = argv[++i];
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (leds < 8 || !fps || fps > 1000 || columns < 0) usage(argv[0]);
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN); // Log lines would scroll the view
+    uint32_t frame_ms = 1000 / fps;
+
+    Env env;
+    Replay replay;
+    EnvObs obs;
+    rgb_t *frame = malloc(leds * sizeof(rgb_t)); // Environment frames
+    if (!frame) return 2;
+    if (replay_path) {
+        FILE *log = fopen(replay_path, "r");
+        if (!log) {
+            perror(replay_path);
+            return 1;
+        }
+        if (replay_init(&replay, log, leds, 0) != ESP_OK) return 2;
+    } else {
+        if (env_init(&env, 1, leds, frame_ms) != ESP_OK) return 2;
+        env_reset(&env, 0, 1, &obs);
+    }
+
+    TermView view;
+    frame_clock_t clock;
+    // Frames are paced here, the view needs no rate limit of its own
+    if (term_view_init(&view, STDOUT_FILENO, STDIN_FILENO, leds, columns, 0) != ESP_OK ||
+        frame_clock_init(&clock, on_deadline, NULL) != ESP_OK) {
+        return 2;
+    }
+
+    int64_t start_us = frame_clock_now_us();
+    uint32_t games = 0;
+    for (uint32_t f = 0;; f++) {
+        uint8_t keys = term_view_keys(&view);
+        if (keys & TERM_VIEW_QUIT) break;
+        const rgb_t *shown = frame;
+        if (replay_path) {
+            bool changed;
+            shown = replay_frame(&replay, f * frame_ms, &changed);
+            if (!shown) break;
+        } else {
+            uint8_t action = keys & (ENV_PRESS_P1 | ENV_PRESS_P2);
+            env_step(&env, 0, 1, &action, &obs, frame);
+            games += obs.done;
+        }
+        int64_t now_us = frame_clock_now_us();
+        term_view_draw(&view, shown, now_us);
+        frame_clock_arm(&clock, start_us + (int64_t)(f + 1) * frame_ms * 1000);
+        frame_clock_wait(&clock);
+    }
+
+    TermViewStats stats = view.stats;
+    term_view_free(&view);
+    frame_clock_free(&clock);
+    printf("%u frames drawn, %u skipped, %.0f bytes per frame", (unsigned)stats.frames, (unsigned)stats.skipped,
+           stats.frames ? (double)stats.bytes / stats.frames : 0.0);
+    if (replay_path) {
+        printf(", %u presses replayed\n", (unsigned)replay.presses);
+        fclose(replay.log);
+        replay_free(&replay);
+    } else {
+        printf(", %u games\n", (unsigned)games);
+        env_free(&env);
+    }
+    free(frame);
+    return 0;
+}
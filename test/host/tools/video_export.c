@@ -0,0 +1,90 @@
+// Exports a replay as video (see video.h): an input log played through the
+// court engine, or a frame log of raw R, G, B frames, written as a Y4M
+// stream or a numbered PNG sequence.
+//
+//   video_export (--inputs log | --frames log) --out path
+//                [--format y4m|png] [--leds N] [--scale N] [--fps N] [--tail MS]
+//
+// "-" reads the log from stdin or writes the Y4M stream to stdout; for PNG
+// the output is a printf pattern taking the frame number, e.g.
+// "frames/%06d.png". Defaults: Y4M, 54 LEDs, 16 pixels per LED, 50 frames
+// per second, 5 s played after the last press. For example
+//
+//   video_export --inputs match.log --out - | ffmpeg -i - match.mp4
+#include <stdlib.h>
+#include <string.h>
+#include "video.h"
+#include "game.h"
+#include "esp_log.h"
+
+#define DEFAULT_LEDS 54
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "Usage: %s (--inputs log | --frames log) --out path\n"
+            "       [--format y4m|png] [--leds N] [--scale N] [--fps N] [--tail MS]\n",
+            argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    const char *inputs = NULL, *frames = NULL, *out = NULL;
+    VideoFormat format = VIDEO_Y4M;
+    int leds = DEFAULT_LEDS, scale = 0, fps = 0;
+    uint32_t tail_ms = 0;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) usage(argv[0]);
+        const char *value = argv[++i];
+        if (!strcmp(argv[i - 1], "--inputs")) {
+            inputs = value;
+        } else if (!strcmp(argv[i - 1], "--frames")) {
+            frames = value;
+        } else if (!strcmp(argv[i - 1], "--out")) {
+            out = value;
+        } else if (!strcmp(argv[i - 1], "--format")) {
+            if (!strcmp(value, "y4m")) {
+                format = VIDEO_Y4M;
+            } else if (!strcmp(value, "png")) {
+                format = VIDEO_PNG;
+            } else {
+                usage(argv[0]);
+            }
+        } else if (!strcmp(argv[i - 1], "--leds")) {
+            leds = atoi(value);
+        } else if (!strcmp(argv[i - 1], "--scale")) {
+            scale = atoi(value);
+        } else if (!strcmp(argv[i - 1], "--fps")) {
+            fps = atoi(value);
+        } else if (!strcmp(argv[i - 1], "--tail")) {
+            tail_ms = strtoul(value, NULL, 10);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if (!inputs == !frames || !out || leds < 1 || scale < 0 || fps < 0) usage(argv[0]);
+    esp_log_level_set(GAME_LOG_TAG, ESP_LOG_WARN);
+
+    const char *log_path = inputs ? inputs : frames;
+    FILE *log = strcmp(log_path, "-") ? fopen(log_path, inputs ? "r" : "rb") : stdin;
+    if (!log) {
+        perror(log_path);
+        return 1;
+    }
+    Video video;
+    if (video_open(&video, format, out, leds, scale, fps) != ESP_OK) {
+        fprintf(stderr, "Cannot open %s\n", out);
+        return 1;
+    }
+    esp_err_t r = inputs ? video_replay_inputs(&video, log, tail_ms) : video_replay_frames(&video, log);
+    uint32_t written = video.frames;
+    int width = video.width, height = video.height;
+    if (video_close(&video) != ESP_OK) r = ESP_FAIL;
+    if (log != stdin) fclose(log);
+    if (r != ESP_OK) {
+        fprintf(stderr, "Export failed after %u frames\n", (unsigned)written);
+        return 1;
+    }
+    // stdout may be the video
+    fprintf(stderr, "%u frames of %dx%d at %d fps\n", (unsigned)written, width, height, fps ? fps : VIDEO_FPS);
+    return 0;
+}